@@ -1,6 +1,9 @@
 #pragma once
 #include <systemc.h>
 #include <iostream>
+#include "control_word.h"
+#include "alu_tables.h"
+#include "cpu_defs.h"
 
 
 // ALU 
@@ -14,45 +17,60 @@ SC_MODULE(alu) {
     sc_out<bool> zero;
     sc_out<bool> negative;
     sc_out<bool> overflow;
+    control_word_in ctrl; // optional, op is taken from the control word when bound
+    bool table_driven = false; // ADC/SBC/INC/DEC/shifts from alu_tables() instead of the switch
 
     void process() {
-        sc_uint<8> res = 0;
+        cpu_word_t res = 0;
         bool c = false, v = false, n = false, z = false;
-        switch(op.read()) {
+        sc_uint<4> alu_op = ctrl.size() ? ctrl->read().alu_op() : op.read();
+        if (table_driven && alu_table_op(alu_op)) {
+            alu_result_t r = alu_lookup(alu_op, a.read(), b.read(), carry_in.read());
+            result.write(r.result);
+            carry.write(r.flags & FLAG_C);
+            zero.write(r.flags & FLAG_Z);
+            negative.write(r.flags & FLAG_N);
+            overflow.write(r.flags & FLAG_V);
+            return;
+        }
+        // Carry and overflow come from 9-bit intermediates, res wraps to 8 bits
+        cpu_word_t a_val = a.read(), b_val = b.read();
+        unsigned carry_val = carry_in.read() & 1;
+        switch(alu_op) {
             case 0x0: // ADC
             {
-                sc_uint<9> tmp = (sc_uint<9>)a.read() + (sc_uint<9>)b.read() + (carry_in.read() & 1);
-                res = tmp.range(7,0);
-                c = tmp[8];
-                v = (~(a.read() ^ b.read()) & (a.read() ^ res)) & 0x80;
+                unsigned tmp = a_val + b_val + carry_val;
+                res = tmp & 0xFF;
+                c = tmp & 0x100;
+                v = (~(a_val ^ b_val) & (a_val ^ res)) & 0x80;
                 /*
-                std::cout << "ALU DEBUG: ADC a=" << std::hex << (int)a.read() 
-                          << " b=" << (int)b.read() << " carry=" << (int)carry_in.read()
-                          << " tmp=" << (int)tmp << " res=" << (int)res << std::endl;
+                std::cout << "ALU DEBUG: ADC a=" << std::hex << (int)a_val 
+                          << " b=" << (int)b_val << " carry=" << carry_val
+                          << " tmp=" << tmp << " res=" << (int)res << std::endl;
                 */
                 break;
             }
             case 0x1: // SBC
             {
-                sc_uint<9> tmp = (sc_uint<9>)a.read() - (sc_uint<9>)b.read() - (1 - (carry_in.read() & 1));
-                res = tmp.range(7,0);
-                c = !tmp[8];
-                v = ((a.read() ^ b.read()) & (a.read() ^ res)) & 0x80;
+                unsigned tmp = (a_val - b_val - (1 - carry_val)) & 0x1FF;
+                res = tmp & 0xFF;
+                c = !(tmp & 0x100);
+                v = ((a_val ^ b_val) & (a_val ^ res)) & 0x80;
                 break;
             }
-            case 0x2: res = a.read() & b.read(); break; // AND
-            case 0x3: res = a.read() | b.read(); break; // ORA
-            case 0x4: res = a.read() ^ b.read(); break; // EOR
-            case 0x5: res = a.read() + 1; break; // INC
-            case 0x6: res = a.read() - 1; break; // DEC
-            case 0x7: res = a.read() << 1; c = a.read()[7]; break; // ASL
-            case 0x8: res = a.read() >> 1; c = a.read()[0]; break; // LSR
-            case 0x9: res = (a.read() << 1) | (carry_in.read() & 1); c = a.read()[7]; break; // ROL
-            case 0xA: res = (a.read() >> 1) | ((carry_in.read() & 1) << 7); c = a.read()[0]; break; // ROR
-            case 0xB: res = a.read(); break; // MOV (LDA, LDX, LDY)
+            case 0x2: res = a_val & b_val; break; // AND
+            case 0x3: res = a_val | b_val; break; // ORA
+            case 0x4: res = a_val ^ b_val; break; // EOR
+            case 0x5: res = (a_val + 1) & 0xFF; break; // INC
+            case 0x6: res = (a_val - 1) & 0xFF; break; // DEC
+            case 0x7: res = (a_val << 1) & 0xFF; c = a_val & 0x80; break; // ASL
+            case 0x8: res = a_val >> 1; c = a_val & 0x01; break; // LSR
+            case 0x9: res = ((a_val << 1) | carry_val) & 0xFF; c = a_val & 0x80; break; // ROL
+            case 0xA: res = (a_val >> 1) | (carry_val << 7); c = a_val & 0x01; break; // ROR
+            case 0xB: res = a_val; break; // MOV (LDA, LDX, LDY)
             default: res = 0;
         }
-        n = res[7];
+        n = res & 0x80;
         z = (res == 0);
         result.write(res);
         carry.write(c);
@@ -63,6 +81,6 @@ SC_MODULE(alu) {
 
     SC_CTOR(alu) {
         SC_METHOD(process);
-        sensitive << a << b << carry_in << op;
+        sensitive << a << b << carry_in << op << ctrl;
     }
 };
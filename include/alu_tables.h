@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include "control_rom.h"
+
+
+// Table-driven ALU: results of alu::process precomputed for every input, so
+// an operation is one indexed load giving the result byte and its flags.
+//
+//   adc, sbc  [carry][a][b]  256x256x2 entries each
+//   unary     [op - ALU_INC][carry][a]  INC, DEC, ASL, LSR, ROL, ROR
+//
+// Flags are packed in status register layout (FLAG_N, FLAG_V, FLAG_Z, FLAG_C).
+// Binary mode only, like alu::process: decimal ADC/SBC tables can be added
+// once the D flag is honoured. AND, ORA, EOR and MOV are cheaper to compute
+// than to look up and have no table.
+//
+// Used by alu when table_driven is set and by cpu6502_core built with
+// CPU6502_ALU_TABLES=1.
+struct alu_result_t {
+    uint8_t result;
+    uint8_t flags;
+};
+
+struct alu_tables_t {
+    alu_result_t adc[2][256][256];
+    alu_result_t sbc[2][256][256];
+    alu_result_t unary[ALU_ROR - ALU_INC + 1][2][256];
+};
+
+// Built on first use (about 520KB)
+const alu_tables_t& alu_tables();
+
+// Operations with a table
+constexpr bool alu_table_op(unsigned op) {
+    return op == ALU_ADC || op == ALU_SBC || (op >= ALU_INC && op <= ALU_ROR);
+}
+
+// op must satisfy alu_table_op(), b is ignored by the unary operations
+inline alu_result_t alu_lookup(unsigned op, uint8_t a, uint8_t b, unsigned carry) {
+    const alu_tables_t& tables = alu_tables();
+    carry &= 1;
+    switch (op) {
+        case ALU_ADC: return tables.adc[carry][a][b];
+        case ALU_SBC: return tables.sbc[carry][a][b];
+        default:      return tables.unary[op - ALU_INC][carry][a];
+    }
+}
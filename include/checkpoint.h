@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Full-system checkpoint: CPU state, register file and the 64KB memory array.
+// Little-endian (host order on every supported host):
+//
+//   checkpoint_header_t   magic, version, size of the state record
+//   checkpoint_state_t    state_size bytes, newer fields appended at the end
+//   page map              32 bytes, bit n set when memory page n follows
+//   pages                 256 bytes each in address order, all-zero pages
+//                         are left out and restored as zeros
+//
+// Taken at instruction boundaries only (cpu::save_checkpoint), so a
+// checkpoint restores into any cpu model. Devices are not saved.
+#define CHECKPOINT_MAGIC "CPUCKPT\0"
+#define CHECKPOINT_VERSION 1
+
+struct checkpoint_header_t {
+    char magic[8];          // CHECKPOINT_MAGIC
+    uint32_t version;       // CHECKPOINT_VERSION
+    uint32_t state_size;    // sizeof(checkpoint_state_t) of the writer
+};
+
+struct checkpoint_state_t {
+    uint64_t cycle;         // clock cycle when saved, for reference (SystemC time is not restored)
+    uint8_t model;          // cpu::cpu_model_t of the writer
+    uint8_t state;          // cpu::cpu_state_t, FETCH in version 1
+    uint8_t halted;         // stopped on BRK
+    uint8_t ir;             // ir_val
+    uint16_t pc;            // pc_val, address of the next instruction
+    uint16_t effective_addr;
+    uint8_t operand;
+    uint8_t reg_a;          // reg_a_val
+    uint8_t a, x, y, s, p;  // register file
+    uint8_t reserved[1];
+};
+
+static_assert(sizeof(checkpoint_header_t) == 16, "checkpoint header layout");
+static_assert(sizeof(checkpoint_state_t) == 24, "checkpoint state layout");
+
+std::vector<uint8_t> write_checkpoint(const checkpoint_state_t& state, const uint8_t* mem);
+// False with error set on a bad magic, an unknown version or a truncated file
+bool parse_checkpoint(const uint8_t* data, size_t length, checkpoint_state_t& state, uint8_t* mem,
+                      std::string& error);
+
+bool save_checkpoint_file(const std::string& path, const checkpoint_state_t& state, const uint8_t* mem,
+                          std::string& error);
+bool load_checkpoint_file(const std::string& path, checkpoint_state_t& state, uint8_t* mem, std::string& error);
@@ -0,0 +1,182 @@
+#pragma once
+#include <cstdint>
+#include "opcode_table.h"
+
+
+// Microcode ROM of control_unit: one packed control word per opcode,
+// generated at compile time from opcode_table.
+//
+// Outputs of control_unit are sticky, an opcode drives only some of them and
+// the others keep the value of the previous instruction. Every entry therefore
+// carries a write mask next to the control word, control_unit updates only the
+// outputs in the mask whose value differs from what it drives already.
+
+// Bit fields of the packed control word (and of the write mask)
+enum control_field_t : uint32_t {
+    CW_ALU_OP          = 0xFu << 0,  // ALU operation code
+    CW_ALU_ENABLE      = 1u << 4,
+    CW_SET_FLAGS       = 1u << 5,
+    CW_REG_WE          = 1u << 6,
+    CW_REG_SEL         = 0x7u << 7,  // 0=A, 1=X, 2=Y, 3=S, 4=P
+    CW_REG_SRC         = 0x7u << 10, // same encoding as reg_sel
+    CW_MEM_WE          = 1u << 13,
+    CW_MEM_OE          = 1u << 14,
+    CW_PC_INC          = 1u << 15,
+    CW_PC_LOAD         = 1u << 16,
+    CW_HALT            = 1u << 17,
+    CW_IRQ_ACK         = 1u << 18,
+    CW_NMI_ACK         = 1u << 19,
+    CW_SET_CARRY       = 1u << 20,
+    CW_CLEAR_CARRY     = 1u << 21,
+    CW_SET_INTERRUPT   = 1u << 22,
+    CW_CLEAR_INTERRUPT = 1u << 23,
+    CW_SET_DECIMAL     = 1u << 24,
+    CW_CLEAR_DECIMAL   = 1u << 25,
+    CW_CLEAR_OVERFLOW  = 1u << 26,
+
+    // P flag strobes are cleared every cycle, they are in every write mask
+    CW_FLAG_STROBES    = 0x7Fu << 20
+};
+
+// ALU operation codes (see alu::process)
+enum alu_op_t {
+    ALU_ADC = 0x0, ALU_SBC = 0x1, ALU_AND = 0x2, ALU_ORA = 0x3, ALU_EOR = 0x4,
+    ALU_INC = 0x5, ALU_DEC = 0x6, ALU_ASL = 0x7, ALU_LSR = 0x8, ALU_ROL = 0x9,
+    ALU_ROR = 0xA, ALU_MOV = 0xB, ALU_CMP = 0xC, ALU_CPX = 0xD, ALU_CPY = 0xE
+};
+
+constexpr int control_field_shift(uint32_t field) {
+    int shift = 0;
+    while (!(field & 1)) { field >>= 1; ++shift; }
+    return shift;
+}
+
+constexpr uint32_t control_field_get(uint32_t word, uint32_t field) {
+    return (word & field) >> control_field_shift(field);
+}
+
+struct microcode_t {
+    uint32_t word; // output values
+    uint32_t mask; // outputs driven by the opcode
+
+    constexpr microcode_t& set(uint32_t field, uint32_t value) {
+        word = (word & ~field) | ((value << control_field_shift(field)) & field);
+        mask |= field;
+        return *this;
+    }
+    constexpr uint32_t get(uint32_t field) const { return control_field_get(word, field); }
+};
+
+struct control_rom_t {
+    microcode_t entry[256];
+    constexpr const microcode_t& operator[](uint8_t opcode) const { return entry[opcode]; }
+};
+
+// Result of the ALU written back to a register: loads, logic, arithmetic, transfers
+constexpr microcode_t alu_to_reg(uint32_t op, uint32_t reg, bool flags, bool mem_read) {
+    return microcode_t{ 0, CW_FLAG_STROBES }
+        .set(CW_ALU_OP, op).set(CW_ALU_ENABLE, 1).set(CW_REG_SEL, reg).set(CW_REG_WE, 1)
+        .set(CW_SET_FLAGS, flags).set(CW_MEM_WE, 0).set(CW_MEM_OE, mem_read)
+        .set(CW_PC_INC, 1).set(CW_HALT, 0);
+}
+
+// Register written to memory without the ALU: stores, pushes
+constexpr microcode_t reg_to_mem(uint32_t reg, bool mem_write) {
+    return microcode_t{ 0, CW_FLAG_STROBES }
+        .set(CW_ALU_ENABLE, 0).set(CW_REG_SRC, reg).set(CW_REG_WE, 0)
+        .set(CW_MEM_WE, mem_write).set(CW_MEM_OE, 0).set(CW_SET_FLAGS, 0)
+        .set(CW_PC_INC, 1).set(CW_HALT, 0);
+}
+
+// ALU result only sets flags or goes back to memory: compares, INC/DEC, shifts on memory
+constexpr microcode_t alu_to_mem(uint32_t op, bool mem_read, bool mem_write) {
+    return microcode_t{ 0, CW_FLAG_STROBES }
+        .set(CW_ALU_OP, op).set(CW_ALU_ENABLE, 1).set(CW_REG_WE, 0)
+        .set(CW_MEM_WE, mem_write).set(CW_MEM_OE, mem_read).set(CW_SET_FLAGS, 1)
+        .set(CW_PC_INC, 1).set(CW_HALT, 0);
+}
+
+// Direct P flag update (CLC, SEC)
+constexpr microcode_t flag_op(uint32_t strobe) {
+    return microcode_t{ 0, CW_FLAG_STROBES }
+        .set(strobe, 1).set(CW_REG_WE, 0).set(CW_ALU_ENABLE, 0).set(CW_SET_FLAGS, 0)
+        .set(CW_MEM_WE, 0).set(CW_MEM_OE, 0).set(CW_PC_INC, 1).set(CW_HALT, 0);
+}
+
+constexpr microcode_t make_microcode(const opcode_info_t& info) {
+    const bool mem_read = info.mode != AM_IMM;
+    const bool acc = info.mode == AM_ACC;
+    microcode_t none = { 0, CW_FLAG_STROBES };
+
+    switch (info.mnemonic) {
+        case MN_LDA: return alu_to_reg(ALU_MOV, 0, true, mem_read);
+        case MN_LDX: return alu_to_reg(ALU_MOV, 1, true, mem_read);
+        case MN_LDY: return alu_to_reg(ALU_MOV, 2, true, mem_read);
+        // STA abs keeps mem_we low, the write is done by cpu once the address is fetched
+        case MN_STA: return reg_to_mem(0, info.mode != AM_ABS);
+        case MN_STX: return reg_to_mem(1, true);
+        case MN_STY: return reg_to_mem(2, true);
+
+        case MN_TAX: return alu_to_reg(ALU_MOV, 1, true, false).set(CW_REG_SRC, 0);
+        case MN_TAY: return alu_to_reg(ALU_MOV, 2, true, false).set(CW_REG_SRC, 0);
+        case MN_TSX: return alu_to_reg(ALU_MOV, 1, false, false).set(CW_REG_SRC, 3);
+        case MN_TXA: return alu_to_reg(ALU_MOV, 0, true, false).set(CW_REG_SRC, 1);
+        case MN_TXS: return alu_to_reg(ALU_MOV, 3, false, false).set(CW_REG_SRC, 1);
+        case MN_TYA: return alu_to_reg(ALU_MOV, 0, true, false).set(CW_REG_SRC, 2);
+
+        case MN_PHA: return reg_to_mem(0, true);
+        case MN_PHP: return reg_to_mem(4, true);
+        case MN_PLA: return alu_to_reg(ALU_MOV, 0, true, true);
+        case MN_PLP: return alu_to_reg(ALU_MOV, 4, false, true);
+
+        case MN_AND: return alu_to_reg(ALU_AND, 0, true, mem_read);
+        case MN_ORA: return alu_to_reg(ALU_ORA, 0, true, mem_read);
+        case MN_EOR: return alu_to_reg(ALU_EOR, 0, true, mem_read);
+        case MN_ADC: return alu_to_reg(ALU_ADC, 0, true, mem_read);
+        case MN_SBC: return alu_to_reg(ALU_SBC, 0, true, mem_read);
+
+        case MN_INC: return alu_to_mem(ALU_INC, true, true);
+        case MN_DEC: return alu_to_mem(ALU_DEC, true, true);
+        case MN_ASL: return acc ? alu_to_reg(ALU_ASL, 0, true, false) : alu_to_mem(ALU_ASL, true, true);
+        case MN_LSR: return acc ? alu_to_reg(ALU_LSR, 0, true, false) : alu_to_mem(ALU_LSR, true, true);
+        case MN_ROL: return acc ? alu_to_reg(ALU_ROL, 0, true, false) : alu_to_mem(ALU_ROL, true, true);
+        case MN_ROR: return acc ? alu_to_reg(ALU_ROR, 0, true, false) : alu_to_mem(ALU_ROR, true, true);
+
+        case MN_CMP: return alu_to_mem(ALU_CMP, mem_read, false);
+        case MN_CPX: return alu_to_mem(ALU_CPX, mem_read, false);
+        case MN_CPY: return alu_to_mem(ALU_CPY, mem_read, false);
+
+        // PC value is computed by cpu, control_unit only requests the load
+        case MN_JMP:
+        case MN_JSR: return none.set(CW_PC_LOAD, 1).set(CW_PC_INC, 0).set(CW_HALT, 0);
+        case MN_RTS: return none.set(CW_PC_LOAD, 1).set(CW_HALT, 0);
+        case MN_RTI: return none.set(CW_NMI_ACK, 1).set(CW_PC_LOAD, 1).set(CW_HALT, 0);
+        case MN_BRK: return none.set(CW_IRQ_ACK, 1).set(CW_HALT, 0);
+
+        case MN_BPL: case MN_BMI: case MN_BVC: case MN_BVS:
+        case MN_BCC: case MN_BCS: case MN_BNE: case MN_BEQ:
+            return none.set(CW_HALT, 0);
+
+        case MN_CLC: return flag_op(CW_CLEAR_CARRY);
+        case MN_SEC: return flag_op(CW_SET_CARRY);
+        // I, D and V strobes are not wired to regfile yet
+        case MN_CLI: case MN_SEI: case MN_CLV: case MN_CLD: case MN_SED:
+            return none.set(CW_PC_INC, 1).set(CW_HALT, 0);
+
+        default: return none; // NOP/illegal
+    }
+}
+
+constexpr control_rom_t make_control_rom() {
+    control_rom_t rom = {};
+    for (int i = 0; i < 256; ++i) {
+        rom.entry[i] = make_microcode(opcode_table[i]);
+    }
+    return rom;
+}
+
+constexpr control_rom_t control_rom = make_control_rom();
+
+static_assert(control_rom[0xA9].get(CW_ALU_OP) == ALU_MOV && !control_rom[0xA9].get(CW_MEM_OE), "LDA #imm");
+static_assert(control_rom[0x8D].mask & CW_MEM_WE && !control_rom[0x8D].get(CW_MEM_WE), "STA abs");
+static_assert(control_rom[0xFF].mask == CW_FLAG_STROBES, "illegal opcodes only clear the flag strobes");
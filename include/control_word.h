@@ -0,0 +1,61 @@
+#pragma once
+#include <systemc.h>
+#include <iostream>
+#include "control_rom.h"
+
+
+// All control_unit outputs in one value, packed as in control_rom.h.
+// In the bundled mode control_unit drives a single sc_signal<control_word_t>
+// instead of one signal per output, cpu, regfile and alu read their fields from it.
+struct control_word_t {
+    uint32_t bits;
+
+    control_word_t(uint32_t bits = 0) : bits(bits) {}
+
+    uint32_t get(uint32_t field) const { return control_field_get(bits, field); }
+    control_word_t& set(uint32_t field, uint32_t value) {
+        bits = (bits & ~field) | ((value << control_field_shift(field)) & field);
+        return *this;
+    }
+
+    sc_uint<4> alu_op() const  { return get(CW_ALU_OP); }
+    bool alu_enable() const    { return bits & CW_ALU_ENABLE; }
+    bool set_flags() const     { return bits & CW_SET_FLAGS; }
+    bool reg_we() const        { return bits & CW_REG_WE; }
+    sc_uint<3> reg_sel() const { return get(CW_REG_SEL); }
+    sc_uint<3> reg_src() const { return get(CW_REG_SRC); }
+    bool pc_inc() const        { return bits & CW_PC_INC; }
+    bool pc_load() const       { return bits & CW_PC_LOAD; }
+
+    bool operator==(const control_word_t& other) const { return bits == other.bits; }
+    bool operator!=(const control_word_t& other) const { return bits != other.bits; }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const control_word_t& cw) {
+    std::ios::fmtflags f = os.flags();
+    os << std::hex << "alu_op=" << cw.get(CW_ALU_OP)
+       << " alu_enable=" << cw.get(CW_ALU_ENABLE)
+       << " set_flags=" << cw.get(CW_SET_FLAGS)
+       << " reg_we=" << cw.get(CW_REG_WE)
+       << " reg_sel=" << cw.get(CW_REG_SEL)
+       << " reg_src=" << cw.get(CW_REG_SRC)
+       << " mem_we=" << cw.get(CW_MEM_WE)
+       << " mem_oe=" << cw.get(CW_MEM_OE)
+       << " pc_inc=" << cw.get(CW_PC_INC)
+       << " pc_load=" << cw.get(CW_PC_LOAD)
+       << " halt=" << cw.get(CW_HALT)
+       << " irq_ack=" << cw.get(CW_IRQ_ACK)
+       << " nmi_ack=" << cw.get(CW_NMI_ACK)
+       << " strobes=" << cw.get(CW_FLAG_STROBES);
+    os.flags(f);
+    return os;
+}
+
+// Traced as one 27-bit vector, field layout is control_field_t
+inline void sc_trace(sc_trace_file* tf, const control_word_t& cw, const std::string& name) {
+    sc_trace(tf, cw.bits, name, 27);
+}
+
+// Control word ports are optional, the discrete ports are used when they are left unbound
+typedef sc_port<sc_signal_in_if<control_word_t>, 1, SC_ZERO_OR_MORE_BOUND> control_word_in;
+typedef sc_port<sc_signal_inout_if<control_word_t>, 1, SC_ZERO_OR_MORE_BOUND> control_word_out;
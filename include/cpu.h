@@ -1,9 +1,49 @@
 #pragma once
 #include <systemc.h>
+#include <tlm.h>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
 #include "alu.h"
 #include "regfile.h"
 #include "memory.h"
 #include "control_unit.h"
+#include "cpu_defs.h"
+#include "cpu_trace.h"
+#include "trace_file.h"
+#include "checkpoint.h"
+#include "cpu_coverage.h"
+#include "lockstep.h"
+#include "waveform_capture.h"
+#include "cpu6502_core.h"
+#include "opcode_table.h"
+
+struct cpu;
+
+// Datapath and control signals of cpu for waveforms, as X(signal, bits).
+// control_unit's reg_sel and reg_src drive reg_w_addr and reg_r_addr.
+#define CPU_WAVEFORM_SIGNALS(X) \
+    X(pc, 16) X(ir, 8) X(opcode, 8) \
+    X(mem_addr, 16) X(mem_w_data, 8) X(mem_r_data, 8) X(mem_we, 1) \
+    X(alu_op, 4) X(alu_enable, 1) X(alu_a, 8) X(alu_b, 8) X(alu_carry_in, 8) X(alu_result, 8) \
+    X(alu_carry, 1) X(alu_zero, 1) X(alu_negative, 1) X(alu_overflow, 1) \
+    X(reg_we, 1) X(reg_w_addr, 3) X(reg_r_addr, 3) \
+    X(reg_w_data, 8) X(reg_r_data, 8) X(set_flags, 1) \
+    X(pc_inc, 1) X(pc_load, 1) X(pc_new, 16) X(halt, 1) \
+    X(set_carry, 1) X(clear_carry, 1) X(set_interrupt, 1) X(clear_interrupt, 1) \
+    X(set_decimal, 1) X(clear_decimal, 1) X(clear_overflow, 1) \
+    X(control_word, 27)
+
+// Bus used by the loosely-timed models, a TLM-2.0 initiator on cpu::mem_socket.
+// Reads are a dereference of the DMI pointer granted by memory, writes (and
+// reads while there is no DMI) are b_transport calls.
+struct lt_memory_bus {
+    cpu* cpu_i = nullptr;
+    const uint8_t* dmi = nullptr; // all 64KB readable, null until granted
+
+    uint8_t read(uint16_t addr) { return dmi ? dmi[addr] : transport(tlm::TLM_READ_COMMAND, addr, 0); }
+    void write(uint16_t addr, uint8_t data) { transport(tlm::TLM_WRITE_COMMAND, addr, data); }
+    uint8_t transport(tlm::tlm_command command, uint16_t addr, uint8_t data);
+};
 
 // Main CPU Module
 SC_MODULE(cpu) {
@@ -34,6 +74,9 @@ SC_MODULE(cpu) {
     sc_signal<bool> set_decimal, clear_decimal;
     sc_signal<bool> clear_overflow;
 
+    // All control_unit outputs in one signal (BUNDLED_CONTROL model)
+    sc_signal<control_word_t> control_word;
+
     // Additional CPU signals
     sc_signal<sc_uint<8>> alu_a, alu_b, alu_result;
     sc_signal<sc_uint<8>> alu_carry_in;
@@ -42,6 +85,9 @@ SC_MODULE(cpu) {
     sc_signal<sc_uint<8>> reg_w_data, reg_r_data;
     sc_signal<sc_uint<3>> reg_w_addr, reg_r_addr;
 
+    // TLM-2.0 initiator bound to memory_i->socket (loosely-timed models, debug access)
+    tlm_utils::simple_initiator_socket<cpu> mem_socket;
+
     sc_signal<bool> mem_clk;
     sc_signal<sc_uint<16>> mem_addr;
     sc_signal<sc_uint<8>> mem_w_data, mem_r_data;
@@ -50,7 +96,18 @@ SC_MODULE(cpu) {
     sc_signal<sc_uint<16>> pc;
     sc_signal<sc_uint<8>> ir;
 
-    cpu(sc_module_name name);
+    // Simulation model
+    enum cpu_model_t {
+        SIGNAL_LEVEL,    // cycle-by-cycle FSM wired through submodule signals
+        BUNDLED_CONTROL, // as SIGNAL_LEVEL, control_unit outputs travel as one control_word_t
+        LOOSELY_TIMED,   // one SC_THREAD, plain C++ state, time advanced per instruction
+        BLOCK_CACHED     // as LOOSELY_TIMED, executing decoded basic blocks, time advanced per block
+    };
+    cpu_model_t model;
+
+    bool loosely_timed() const { return model == LOOSELY_TIMED || model == BLOCK_CACHED; }
+
+    cpu(sc_module_name name, cpu_model_t model = SIGNAL_LEVEL);
 
 
     // --- fetch/execute fields ---
@@ -71,19 +128,96 @@ SC_MODULE(cpu) {
         INDIRECT_Y   // LDA ($42),Y
     };
     
-    sc_uint<16> pc_val = 0x0000;
-    sc_uint<8> ir_val = 0x00;
-    sc_uint<8> operand = 0x00;
-    sc_uint<16> effective_addr = 0x0000; // Effective address for complex addressing
-    sc_uint<8> reg_a_val = 0x00; // Track value of register A
+    cpu_addr_t pc_val = 0x0000;
+    cpu_word_t ir_val = 0x00;
+    cpu_word_t operand = 0x00;
+    cpu_addr_t effective_addr = 0x0000; // Effective address for complex addressing
+    cpu_word_t reg_a_val = 0x00; // Track value of register A
+    const opcode_info_t* ir_info = &opcode_table[0x00]; // Metadata of the instruction in IR
+    addressing_mode_t ir_mode = IMPLIED;                 // FSM addressing mode of the instruction in IR
 
     void fetch_execute();
+    uint16_t reset_vector() const;    // boot address at $FFFC/$FFFD
+    bool brk_reached = false; // signal-level FSM stopped on BRK, until the next reset
+    sc_event brk_event;       // notified when any model stops on BRK
+
+    // Coverage feedback for cpu_fuzz (cpu_coverage.h), null when not fuzzing
+    cpu_coverage* coverage = nullptr;
+    unsigned coverage_state = FETCH; // FSM state of the previous cycle
+    void set_coverage(cpu_coverage* map); // also hands it to control_unit_i
+
+    // Golden reference (lockstep.h) run alongside the model, null when off.
+    // Started at the first instruction boundary after a reset or restore_state(),
+    // compared when instructions retire: the FSM at WAIT_INSTRUCTION of the next
+    // instruction (its register and memory writes have landed) and on BRK, the
+    // LT models after every instruction (block). The first divergence is
+    // printed, triggers divergence_capture if set, and stops the simulation.
+    lockstep_checker* lockstep = nullptr;
+    waveform_capture* divergence_capture = nullptr;
+    bool lockstep_sync = true;    // start the reference at the next boundary
+    void set_lockstep(lockstep_checker* checker); // also hands it to memory_i
+    void lockstep_retire(uint64_t n); // starts the reference instead while lockstep_sync is set
+
+    // Waveforms of CPU_WAVEFORM_SIGNALS: every cycle into a SystemC trace file,
+    // or into a windowed capture (signal-level models, the LT models leave them idle)
+    void trace_signals(sc_trace_file* tf);
+    void add_waveform_probes(waveform_capture& capture);
+
+    // Binary execution trace of the signal-level models: an instruction record
+    // when it retires, completed with the registers once the register file has
+    // taken the write (WAIT_INSTRUCTION of the next instruction), plus the bus
+    // cycles recorded by memory_i. The loosely-timed models write no trace.
+    trace_file_writer* trace_file = nullptr;
+    trace_record_t trace_pending = {};
+    bool trace_pending_valid = false;
+    void set_trace_file(trace_file_writer* writer); // also hands it to memory_i, null stops tracing
+    void trace_decode();              // PC and instruction bytes
+    void trace_retire();              // cycle and effective address
+    void trace_commit();              // registers, writes the record
+
+    // Debug access to memory through transport_dbg, returns the bytes transferred
+    unsigned debug_write(uint16_t addr, const uint8_t* data, unsigned length);
+    unsigned debug_read(uint16_t addr, uint8_t* data, unsigned length);
+    bool request_dmi();           // asks memory for a DMI pointer, false if refused
+    void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end);
+    control_word_t current_control(); // control_unit outputs read by the FSM
+
+    // Checkpoints (checkpoint.h): the fetch/execute fields, register file and
+    // memory array. Saved between clock edges at an instruction boundary, for
+    // the FSM once it waits for the next opcode. Restored at any time, the CPU
+    // then continues from the saved PC on whichever model it runs.
+    bool at_instruction_boundary() const;
+    checkpoint_state_t checkpoint_state() const;
+    void restore_state(const checkpoint_state_t& saved); // memory is restored separately
+    bool save_checkpoint(const std::string& path, std::string& error) const;
+    bool restore_checkpoint(const std::string& path, std::string& error);
+
+    // --- loosely-timed model ---
+    // Instruction-set core on plain integers, registers are copied to regfile_i after every instruction
+    cpu6502_core_t<lt_memory_bus> lt_core;
+    sc_signal<bool> lt_idle_clk; // submodule clock in LT mode, never toggles
+    sc_event lt_resume;          // restore_state() left BRK, wakes the halted thread
+    cpu6502_block_cache block_cache; // decoded basic blocks (BLOCK_CACHED), invalidated by memory_i writes
+
+    // Temporal decoupling of the loosely-timed models: with a non-zero quantum the
+    // CPU runs ahead of SystemC time and only syncs once per quantum, before a
+    // device access (I/O ports) and on BRK. Reset is seen at those sync points only.
+    tlm_utils::tlm_quantumkeeper quantum_keeper;
+    sc_time quantum = SC_ZERO_TIME;   // zero: wait after every instruction (block)
+    void set_quantum(const sc_time& q);
+    bool decoupled() const { return quantum != SC_ZERO_TIME; }
+    void sync_before_io();            // called by lt_memory_bus on device accesses
+
+    void loosely_timed_thread();
+    void lt_reset();
+    int lt_step();               // executes one instruction (one block when cached), returns its cycle count
+    void lt_sync_regfile();
     
-    // helper functions
-    addressing_mode_t get_addressing_mode(sc_uint<8> opcode);
-    int get_instruction_length(sc_uint<8> opcode);
-    bool needs_operand(sc_uint<8> opcode);
-    bool is_store_instruction(sc_uint<8> opcode);
+    // helper functions, all backed by opcode_table
+    static addressing_mode_t get_addressing_mode(cpu_word_t opcode);
+    static int get_instruction_length(cpu_word_t opcode); // as stepped by the FSM, 1 for branches
+    static bool needs_operand(cpu_word_t opcode);
+    static bool is_store_instruction(cpu_word_t opcode);
 
     ~cpu() {
         delete alu_i;
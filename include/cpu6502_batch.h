@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cpu6502_core.h"
+
+// Vector instructions of cpu6502_batch, picked from the target flags: AVX2
+// with -mavx2 (CMake option CPU6502_BATCH_AVX2), SSE2 on any x86-64, plain
+// loops elsewhere or with -DCPU6502_BATCH_SCALAR=1
+#ifndef CPU6502_BATCH_SCALAR
+#define CPU6502_BATCH_SCALAR 0
+#endif
+
+// Many independent CPUs (lanes) stepped in lockstep, for workloads running
+// thousands of short programs (fuzzing, regression runs).
+//
+// Registers are kept as structure of arrays, one byte per lane, and every step
+// executes one instruction on every running lane:
+//  - each lane fetches its opcode from its own 64KB memory
+//  - lanes are grouped by opcode (vector compare + movemask); loads, stores,
+//    ALU, read-modify-write, transfer and flag opcodes run for a whole group
+//    at once with vector instructions under a lane mask, operands gathered
+//    from and results scattered to the lane memories; branches test the
+//    condition for the group and jump per lane
+//  - stack and jump opcodes run lane by lane on a cpu6502_core
+//  - lanes halted on BRK are masked out until reset()
+//
+// Lanes running the same code on different data stay in one group per step,
+// code that diverges ends up with one group per distinct opcode. Flags follow
+// the rules of alu::process (binary mode), results and cycle counts match
+// cpu6502_core bit for bit.
+class cpu6502_batch {
+public:
+    static constexpr int MAX_LANES = 32;
+    // Lane memories are 64 bytes more than 64KB apart, so one guest address
+    // in all lanes does not map to a single cache set
+    static const size_t LANE_STRIDE = 65536 + 64;
+
+    // Registers, lane i in element i
+    alignas(32) uint8_t a[MAX_LANES];
+    alignas(32) uint8_t x[MAX_LANES];
+    alignas(32) uint8_t y[MAX_LANES];
+    alignas(32) uint8_t s[MAX_LANES];
+    alignas(32) uint8_t p[MAX_LANES];
+    uint16_t pc[MAX_LANES];
+
+    uint32_t halted;                        // bit i set: lane i stopped on BRK
+    uint64_t instructions[MAX_LANES];       // retired instructions since reset
+    uint64_t cycles[MAX_LANES];             // 6502 clock cycles since reset
+
+    uint64_t vector_groups;  // opcode groups executed by the batch kernels
+    uint64_t scalar_groups;  // opcode groups handed to cpu6502_core lane by lane
+
+    // lanes: 1..MAX_LANES
+    explicit cpu6502_batch(int lanes = MAX_LANES);
+
+    int lanes() const { return lane_count; }
+    uint8_t* memory(int lane) { return &mem[lane * LANE_STRIDE]; }
+    uint32_t running() const { return lane_mask & ~halted; }
+
+    // Power-on state on every lane, same as cpu6502_core::reset()
+    void reset(uint16_t start_pc = 0x0000);
+    void reset_counters() { vector_groups = 0; scalar_groups = 0; }
+
+    // Execute up to n instructions on every running lane, returns the number
+    // of instructions executed over all lanes
+    uint64_t run(uint64_t n);
+
+    // "AVX2", "SSE2" or "scalar"
+    static const char* simd();
+
+private:
+    int lane_count;
+    uint32_t lane_mask;
+    std::vector<uint8_t> mem;               // 64KB per lane, LANE_STRIDE apart
+    alignas(32) uint8_t opcode[MAX_LANES];  // opcode fetched by each lane this step
+    cpu6502_core scalar;                    // executes fallback opcodes
+
+    void step(uint32_t lanes);
+    void execute_batched(uint8_t op, uint32_t group);
+    void execute_branch(uint8_t op, uint32_t group);
+    void execute_scalar(uint32_t group);
+    template <int Mode> uint16_t operand_address(const uint8_t* m, int lane);
+    template <int Mode> void gather(const opcode_info_t& info, uint32_t group, uint16_t* addr, uint8_t* value);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// Cache of decoded basic blocks for cpu6502_core_t::run_cached().
+//
+// A block is a straight run of instructions starting at some pc and ending
+// with a branch, jump, return or BRK. Each instruction is kept with its
+// operand bytes already fetched, so executing a cached block does not fetch
+// or decode anything from memory again.
+//
+// Blocks are registered on every 256-byte page they cover. Every memory write
+// has to be reported through invalidate_write() (memory::write_mem does it),
+// a write to a page holding decoded code drops all blocks on that page, so
+// self-modifying code is decoded again.
+
+struct cpu6502_decoded_insn_t {
+    uint8_t opcode;
+    uint16_t operand; // operand bytes, little-endian (0 for implied)
+};
+
+struct cpu6502_block_t {
+    uint16_t start;  // pc of the first instruction
+    uint32_t size;   // bytes covered by the block
+    std::vector<cpu6502_decoded_insn_t> insns;
+
+    // Native translation (cpu6502_jit), dropped together with the block
+    uint32_t exec_count = 0;     // executions seen by the JIT
+    void* native = nullptr;      // translated code, valid while native_epoch matches the JIT
+    uint64_t native_epoch = 0;
+    bool jit_failed = false;     // first instruction cannot be translated
+};
+
+class cpu6502_block_cache {
+public:
+    static const unsigned MAX_BLOCK_INSNS = 64;
+
+    uint64_t hits;          // blocks found in the cache
+    uint64_t misses;        // blocks decoded
+    uint64_t invalidations; // blocks dropped by writes
+    uint64_t generation;    // changes on every invalidation
+
+    cpu6502_block_cache();
+
+    cpu6502_block_t* find(uint16_t pc) {
+        cpu6502_block_t* block = blocks[pc].get();
+        if (block) {
+            hits++;
+        } else {
+            misses++;
+        }
+        return block;
+    }
+
+    cpu6502_block_t* insert(cpu6502_block_t&& block);
+
+    // Called for every write to memory
+    void invalidate_write(uint16_t addr) {
+        if (!page_blocks[addr >> 8].empty()) {
+            invalidate_page(addr >> 8);
+        }
+    }
+
+    void invalidate_page(uint8_t page);
+
+    // Drop every block, counters are kept
+    void clear();
+    void reset_counters();
+
+private:
+    std::vector<std::unique_ptr<cpu6502_block_t> > blocks; // indexed by start pc
+    std::vector<uint16_t> page_blocks[256];                 // start pcs of the blocks on each page
+
+    void remove(uint16_t start);
+};
@@ -0,0 +1,564 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "cpu6502_opcodes.h"
+#include "opcode_table.h"
+#include "cpu6502_block_cache.h"
+#include "cpu6502_jit.h"
+#include "alu_tables.h"
+
+// Threaded dispatch needs the GCC/Clang labels-as-values extension,
+// build with -DCPU6502_COMPUTED_GOTO=0 to force the switch fallback
+#ifndef CPU6502_COMPUTED_GOTO
+#if defined(__GNUC__)
+#define CPU6502_COMPUTED_GOTO 1
+#else
+#define CPU6502_COMPUTED_GOTO 0
+#endif
+#endif
+
+// ADC, SBC, shifts and rotates from alu_tables() (one load for result and
+// flags) instead of computing them, build with -DCPU6502_ALU_TABLES=1
+#ifndef CPU6502_ALU_TABLES
+#define CPU6502_ALU_TABLES 0
+#endif
+
+// Instruction-set simulator of the CPU, without any SystemC dependency.
+// Executes one whole instruction per dispatch through a 256-entry handler
+// table, so it can be used for batch runs and tooling that do not need
+// cycle-level signals. The SystemC cpu module stays the timing reference.
+//
+// Memory is accessed through a Bus type providing
+//     uint8_t read(uint16_t addr);
+//     void write(uint16_t addr, uint8_t data);
+
+// Position of every opcode in CPU6502_OPCODE_LIST, opcodes not in the list map
+// to the entry after the last one. Indexes the label table of run_threaded().
+struct opcode_list_index_t {
+    uint8_t index[256];
+    constexpr uint8_t operator[](uint8_t opcode) const { return index[opcode]; }
+};
+
+constexpr opcode_list_index_t make_opcode_list_index() {
+    opcode_list_index_t table = {};
+    int count = 0;
+#define CPU6502_LIST_COUNT(opcode, mnemonic, mode) ++count;
+    CPU6502_OPCODE_LIST(CPU6502_LIST_COUNT)
+#undef CPU6502_LIST_COUNT
+    for (int i = 0; i < 256; ++i) {
+        table.index[i] = (uint8_t)count;
+    }
+    int n = 0;
+#define CPU6502_LIST_INDEX(opcode, mnemonic, mode) table.index[opcode] = (uint8_t)n++;
+    CPU6502_OPCODE_LIST(CPU6502_LIST_INDEX)
+#undef CPU6502_LIST_INDEX
+    return table;
+}
+
+constexpr opcode_list_index_t opcode_list_index = make_opcode_list_index();
+
+// Plain 64KB memory array
+struct flat_memory_bus {
+    uint8_t* mem;
+
+    flat_memory_bus(uint8_t* mem = nullptr) : mem(mem) {}
+
+    uint8_t read(uint16_t addr) { return mem[addr]; }
+    void write(uint16_t addr, uint8_t data) { mem[addr] = data; }
+};
+
+template <class Bus>
+class cpu6502_core_t {
+public:
+    typedef void (*handler_t)(cpu6502_core_t&);
+
+    // Registers
+    uint8_t a, x, y, s, p;
+    uint16_t pc;
+
+    bool halted;            // set by BRK, cleared by reset
+    uint64_t instructions;  // retired instructions since reset
+    uint64_t cycles;        // 6502 clock cycles since reset (opcode_table timing)
+
+    Bus bus;
+
+    cpu6502_core_t() { reset(); }
+    explicit cpu6502_core_t(const Bus& bus) : bus(bus) { reset(); }
+
+    // Power-on state, same as regfile's initial values
+    void reset(uint16_t start_pc = 0x0000) {
+        a = 0; x = 0; y = 0;
+        s = 0xFF;
+        p = FLAG_U;
+        pc = start_pc;
+        halted = false;
+        instructions = 0;
+        cycles = 0;
+    }
+
+    // Execute one instruction, returns false if the CPU is halted
+    bool step() {
+        if (halted) return false;
+        dispatch[bus.read(pc)](*this);
+        instructions++;
+        return true;
+    }
+
+    // Execute up to n instructions, returns how many were executed
+    uint64_t run(uint64_t n) {
+        uint64_t done = 0;
+        while (done < n && !halted) {
+            dispatch[bus.read(pc)](*this);
+            done++;
+        }
+        instructions += done;
+        return done;
+    }
+
+    // Same as run(), one switch over the opcode list instead of the handler table
+    uint64_t run_switch(uint64_t n) {
+        uint64_t done = 0;
+        while (done < n && !halted) {
+            switch (bus.read(pc)) {
+#define CPU6502_SWITCH_CASE(opcode, mnemonic, mode) \
+                case opcode: exec<opcode, mode, &op_##mnemonic<mode> >(*this); break;
+                CPU6502_OPCODE_LIST(CPU6502_SWITCH_CASE)
+#undef CPU6502_SWITCH_CASE
+                default: exec<0xEA, AM_IMP, &op_NOP<AM_IMP> >(*this); break;
+            }
+            done++;
+        }
+        instructions += done;
+        return done;
+    }
+
+    // Same as run(), threaded code: every handler ends with its own indirect
+    // jump to the next one, so there is no shared dispatch branch to mispredict.
+    // Falls back to run_switch() without CPU6502_COMPUTED_GOTO. One label per
+    // opcode of CPU6502_OPCODE_LIST, the 144 opcodes control_unit has always
+    // decoded; every other opcode byte runs as NOP.
+    uint64_t run_threaded(uint64_t n) {
+#if CPU6502_COMPUTED_GOTO
+        static void* const labels[] = {
+#define CPU6502_THREADED_LABEL(opcode, mnemonic, mode) &&threaded_##mnemonic##_##mode,
+            CPU6502_OPCODE_LIST(CPU6502_THREADED_LABEL)
+#undef CPU6502_THREADED_LABEL
+            &&threaded_illegal
+        };
+        uint64_t done = 0;
+        if (n == 0 || halted) {
+            return 0;
+        }
+#define CPU6502_THREADED_NEXT() \
+        if (++done >= n || halted) goto threaded_out; \
+        goto *labels[opcode_list_index[bus.read(pc)]];
+
+        goto *labels[opcode_list_index[bus.read(pc)]];
+#define CPU6502_THREADED_BODY(opcode, mnemonic, mode) \
+    threaded_##mnemonic##_##mode: \
+        exec<opcode, mode, &op_##mnemonic<mode> >(*this); \
+        CPU6502_THREADED_NEXT()
+        CPU6502_OPCODE_LIST(CPU6502_THREADED_BODY)
+#undef CPU6502_THREADED_BODY
+    threaded_illegal:
+        exec<0xEA, AM_IMP, &op_NOP<AM_IMP> >(*this);
+        CPU6502_THREADED_NEXT()
+#undef CPU6502_THREADED_NEXT
+    threaded_out:
+        instructions += done;
+        return done;
+#else
+        return run_switch(n);
+#endif
+    }
+
+    // Execute one basic block from cache (decoding it on a miss), at most n instructions.
+    // Returns how many were executed. Stops early when a write invalidates cached code.
+    uint64_t run_block(cpu6502_block_cache& cache, uint64_t n = UINT64_MAX) {
+        if (halted || n == 0) return 0;
+        const cpu6502_block_t& block = fetch_block(cache);
+        uint64_t done = interpret_block(block, 0, n, cache, cache.generation);
+        instructions += done;
+        return done;
+    }
+
+    // Same as run(), through decoded basic blocks. All writes must reach
+    // cache.invalidate_write() for self-modifying code to stay correct.
+    uint64_t run_cached(cpu6502_block_cache& cache, uint64_t n) {
+        uint64_t done = 0;
+        while (done < n && !halted) {
+            done += run_block(cache, n - done);
+        }
+        return done;
+    }
+
+    // Same as run_cached() on jit.cache, hot blocks run as translated x86-64 code.
+    // Needs a Bus with the whole address space readable as uint8_t* mem, stores
+    // still go through bus.write() and must reach cache.invalidate_write().
+    uint64_t run_jit(cpu6502_jit& jit, uint64_t n) {
+        cpu6502_block_cache& cache = jit.cache;
+        uint64_t done = 0;
+        while (done < n && !halted) {
+            cpu6502_block_t& block = fetch_block(cache);
+            uint64_t generation = cache.generation;
+            uint64_t budget = n - done;
+            uint64_t k = 0;
+            // Native code cannot stop in the middle, only run it when the whole block fits
+            if (budget >= block.insns.size()) {
+                cpu6502_jit::native_fn native = jit.native_code(block, jit_layout());
+                if (native) k = native(this, bus.mem, budget);
+            }
+            // Rest of the block (or all of it) on the interpreter, unless a store dropped it.
+            // Native code that looped has done whole passes, k >= block size.
+            if (cache.generation == generation && k < block.insns.size() && k < budget) {
+                k += interpret_block(block, k, budget - k, cache, generation);
+            }
+            instructions += k;
+            done += k;
+        }
+        return done;
+    }
+
+    // Register offsets and store callback for the translated code
+    static const cpu6502_jit_layout_t& jit_layout() {
+        static const cpu6502_jit_layout_t layout = {
+            offsetof(cpu6502_core_t, a), offsetof(cpu6502_core_t, x), offsetof(cpu6502_core_t, y),
+            offsetof(cpu6502_core_t, s), offsetof(cpu6502_core_t, p), offsetof(cpu6502_core_t, pc),
+            offsetof(cpu6502_core_t, cycles), &jit_write
+        };
+        return layout;
+    }
+
+    // Decode the basic block starting at start
+    cpu6502_block_t decode_block(uint16_t start) {
+        cpu6502_block_t block;
+        block.start = start;
+        block.size = 0;
+        uint32_t addr = start;
+        while (true) {
+            uint8_t opcode = bus.read((uint16_t)addr);
+            const opcode_info_t& info = opcode_table[opcode];
+            uint16_t operand = 0;
+            if (info.length >= 2) operand = bus.read((uint16_t)(addr + 1));
+            if (info.length == 3) operand |= bus.read((uint16_t)(addr + 2)) << 8;
+            block.insns.push_back(cpu6502_decoded_insn_t{ opcode, operand });
+            block.size += info.length;
+            addr += info.length;
+            if ((info.flags & (OPC_BRANCH | OPC_JUMP)) || block.insns.size() >= cpu6502_block_cache::MAX_BLOCK_INSNS
+                || addr > 0xFFFF) {
+                break;
+            }
+        }
+        return block;
+    }
+
+    // Execute until BRK (or max_instructions), returns how many were executed
+    uint64_t run_until_brk(uint64_t max_instructions = UINT64_MAX) {
+        return run(max_instructions);
+    }
+
+    struct dispatch_table_t {
+        handler_t handler[256];
+        handler_t operator[](uint8_t opcode) const { return handler[opcode]; }
+    };
+    static const dispatch_table_t dispatch;
+
+    // Handlers taking the already fetched operand bytes (decoded blocks)
+    typedef void (*decoded_handler_t)(cpu6502_core_t&, uint16_t operand);
+    struct decoded_dispatch_table_t {
+        decoded_handler_t handler[256];
+        decoded_handler_t operator[](uint8_t opcode) const { return handler[opcode]; }
+    };
+    static const decoded_dispatch_table_t decoded_dispatch;
+
+private:
+    cpu6502_block_t& fetch_block(cpu6502_block_cache& cache) {
+        cpu6502_block_t* block = cache.find(pc);
+        if (!block) {
+            block = cache.insert(decode_block(pc));
+        }
+        return *block;
+    }
+
+    // Instructions first.. of block, at most n. Does not count them in instructions.
+    uint64_t interpret_block(const cpu6502_block_t& block, size_t first, uint64_t n,
+                             const cpu6502_block_cache& cache, uint64_t generation) {
+        uint64_t done = 0;
+        for (size_t i = first; i < block.insns.size(); ++i) {
+            const cpu6502_decoded_insn_t& insn = block.insns[i];
+            decoded_dispatch[insn.opcode](*this, insn.operand);
+            done++;
+            // block may be gone after an invalidation, do not touch it again
+            if (done >= n || halted || cache.generation != generation) break;
+        }
+        return done;
+    }
+
+    // Stores of translated code
+    static uint32_t jit_write(void* core, uint32_t addr, uint32_t value, cpu6502_block_cache* cache) {
+        cpu6502_core_t& c = *static_cast<cpu6502_core_t*>(core);
+        uint64_t generation = cache->generation;
+        c.bus.write((uint16_t)addr, (uint8_t)value);
+        return cache->generation != generation;
+    }
+
+    // --- helpers ---
+    uint8_t read(uint16_t addr) { return bus.read(addr); }
+    void write(uint16_t addr, uint8_t data) { bus.write(addr, data); }
+    uint16_t read16_zp(uint8_t addr) { return read(addr) | (read((uint8_t)(addr + 1)) << 8); }
+
+    void push(uint8_t data) { write(0x0100 | s, data); s--; }
+    uint8_t pull() { s++; return read(0x0100 | s); }
+
+    void set_nz(uint8_t value) {
+        p = (p & ~(FLAG_N | FLAG_Z)) | (value == 0 ? FLAG_Z : 0) | (value & FLAG_N);
+    }
+    void set_c(bool c) { p = (p & ~FLAG_C) | (c ? FLAG_C : 0); }
+    void compare(uint8_t reg, uint8_t value) { set_c(reg >= value); set_nz(reg - value); }
+
+    // Table lookup of an alu_op_t, the flags in changed are taken from the table
+    uint8_t alu_table(unsigned op, uint8_t a, uint8_t b, uint8_t changed) {
+        alu_result_t r = alu_lookup(op, a, b, p & FLAG_C);
+        p = (p & ~changed) | (r.flags & changed);
+        return r.result;
+    }
+
+    // Operand bytes following the opcode, pc points at the opcode
+    template <int Mode>
+    uint16_t fetch_operand() {
+        constexpr int length = opcode_length(Mode);
+        return length == 3 ? read(pc + 1) | (read(pc + 2) << 8)
+             : length == 2 ? read(pc + 1)
+             : 0;
+    }
+
+    // Effective address from the operand bytes, pc points at the opcode
+    template <int Mode>
+    uint16_t operand_address(uint16_t operand) {
+        switch (Mode) {
+            case AM_IMM:  return pc + 1;
+            case AM_ZP:   return operand;
+            case AM_ZPX:  return (uint8_t)(operand + x);
+            case AM_ZPY:  return (uint8_t)(operand + y);
+            case AM_ABS:  return operand;
+            case AM_ABSX: return (uint16_t)(operand + x);
+            case AM_ABSY: return (uint16_t)(operand + y);
+            case AM_IND: {
+                // JMP ($xxFF) wraps inside the page like the original 6502
+                return read(operand) | (read((operand & 0xFF00) | ((operand + 1) & 0xFF)) << 8);
+            }
+            case AM_INDX: return read16_zp(operand + x);
+            case AM_INDY: return (uint16_t)(read16_zp(operand) + y);
+            case AM_REL:  return pc + 1;
+            default:      return 0;
+        }
+    }
+
+    // Every table entry: decode the operand address, step pc over the
+    // instruction, count cycles, run the operation
+    template <int Opcode, int Mode, void (*Op)(cpu6502_core_t&, uint16_t)>
+    static void exec(cpu6502_core_t& c) {
+        execute<Opcode, Mode, Op>(c, c.template fetch_operand<Mode>());
+    }
+
+    template <int Opcode, int Mode, void (*Op)(cpu6502_core_t&, uint16_t)>
+    static void execute(cpu6502_core_t& c, uint16_t operand) {
+        constexpr opcode_info_t info = opcode_table[Opcode];
+        uint16_t addr = c.template operand_address<Mode>(operand);
+        c.pc += info.length;
+        c.cycles += info.cycles;
+        if (info.page_penalty && (Mode == AM_ABSX || Mode == AM_ABSY || Mode == AM_INDY)) {
+            uint16_t base = addr - (Mode == AM_ABSX ? c.x : c.y);
+            if ((base ^ addr) & 0xFF00) c.cycles += info.page_penalty;
+        }
+        Op(c, addr);
+    }
+
+    static constexpr dispatch_table_t build_dispatch();
+    static constexpr decoded_dispatch_table_t build_decoded_dispatch();
+
+    // --- operations (addr is the effective address, pc already points at the next instruction) ---
+    template <int M> static void op_LDA(cpu6502_core_t& c, uint16_t addr) { c.a = c.read(addr); c.set_nz(c.a); }
+    template <int M> static void op_LDX(cpu6502_core_t& c, uint16_t addr) { c.x = c.read(addr); c.set_nz(c.x); }
+    template <int M> static void op_LDY(cpu6502_core_t& c, uint16_t addr) { c.y = c.read(addr); c.set_nz(c.y); }
+    template <int M> static void op_STA(cpu6502_core_t& c, uint16_t addr) { c.write(addr, c.a); }
+    template <int M> static void op_STX(cpu6502_core_t& c, uint16_t addr) { c.write(addr, c.x); }
+    template <int M> static void op_STY(cpu6502_core_t& c, uint16_t addr) { c.write(addr, c.y); }
+
+    template <int M> static void op_TAX(cpu6502_core_t& c, uint16_t) { c.x = c.a; c.set_nz(c.x); }
+    template <int M> static void op_TAY(cpu6502_core_t& c, uint16_t) { c.y = c.a; c.set_nz(c.y); }
+    template <int M> static void op_TSX(cpu6502_core_t& c, uint16_t) { c.x = c.s; c.set_nz(c.x); }
+    template <int M> static void op_TXA(cpu6502_core_t& c, uint16_t) { c.a = c.x; c.set_nz(c.a); }
+    template <int M> static void op_TXS(cpu6502_core_t& c, uint16_t) { c.s = c.x; }
+    template <int M> static void op_TYA(cpu6502_core_t& c, uint16_t) { c.a = c.y; c.set_nz(c.a); }
+
+    template <int M> static void op_PHA(cpu6502_core_t& c, uint16_t) { c.push(c.a); }
+    template <int M> static void op_PHP(cpu6502_core_t& c, uint16_t) { c.push(c.p | FLAG_B | FLAG_U); }
+    template <int M> static void op_PLA(cpu6502_core_t& c, uint16_t) { c.a = c.pull(); c.set_nz(c.a); }
+    template <int M> static void op_PLP(cpu6502_core_t& c, uint16_t) { c.p = (c.pull() & ~FLAG_B) | FLAG_U; }
+
+    template <int M> static void op_AND(cpu6502_core_t& c, uint16_t addr) { c.a &= c.read(addr); c.set_nz(c.a); }
+    template <int M> static void op_ORA(cpu6502_core_t& c, uint16_t addr) { c.a |= c.read(addr); c.set_nz(c.a); }
+    template <int M> static void op_EOR(cpu6502_core_t& c, uint16_t addr) { c.a ^= c.read(addr); c.set_nz(c.a); }
+
+    // Same carry/overflow rules as alu::process (binary mode only)
+    template <int M> static void op_ADC(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t value = c.read(addr);
+        if (CPU6502_ALU_TABLES) {
+            c.a = c.alu_table(ALU_ADC, c.a, value, FLAG_N | FLAG_Z | FLAG_C | FLAG_V);
+            return;
+        }
+        unsigned tmp = c.a + value + (c.p & FLAG_C);
+        uint8_t res = tmp & 0xFF;
+        bool v = (~(c.a ^ value) & (c.a ^ res)) & 0x80;
+        c.p = (c.p & ~(FLAG_C | FLAG_V)) | ((tmp & 0x100) ? FLAG_C : 0) | (v ? FLAG_V : 0);
+        c.a = res;
+        c.set_nz(c.a);
+    }
+    template <int M> static void op_SBC(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t value = c.read(addr);
+        if (CPU6502_ALU_TABLES) {
+            c.a = c.alu_table(ALU_SBC, c.a, value, FLAG_N | FLAG_Z | FLAG_C | FLAG_V);
+            return;
+        }
+        unsigned tmp = c.a - value - (1 - (c.p & FLAG_C));
+        uint8_t res = tmp & 0xFF;
+        bool v = ((c.a ^ value) & (c.a ^ res)) & 0x80;
+        c.p = (c.p & ~(FLAG_C | FLAG_V)) | ((tmp & 0x100) ? 0 : FLAG_C) | (v ? FLAG_V : 0);
+        c.a = res;
+        c.set_nz(c.a);
+    }
+
+    template <int M> static void op_CMP(cpu6502_core_t& c, uint16_t addr) { c.compare(c.a, c.read(addr)); }
+    template <int M> static void op_CPX(cpu6502_core_t& c, uint16_t addr) { c.compare(c.x, c.read(addr)); }
+    template <int M> static void op_CPY(cpu6502_core_t& c, uint16_t addr) { c.compare(c.y, c.read(addr)); }
+
+    template <int M> static void op_INC(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t res = c.read(addr) + 1; c.write(addr, res); c.set_nz(res);
+    }
+    template <int M> static void op_DEC(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t res = c.read(addr) - 1; c.write(addr, res); c.set_nz(res);
+    }
+
+    // Shifts and rotates work on A for AM_ACC, on memory otherwise
+    template <int M> static uint8_t rmw_read(cpu6502_core_t& c, uint16_t addr) {
+        return M == AM_ACC ? c.a : c.read(addr);
+    }
+    template <int M> static void rmw_write(cpu6502_core_t& c, uint16_t addr, uint8_t value) {
+        if (M == AM_ACC) c.a = value; else c.write(addr, value);
+        c.set_nz(value);
+    }
+    template <int M> static void op_ASL(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t value = rmw_read<M>(c, addr);
+        if (CPU6502_ALU_TABLES) return rmw_write<M>(c, addr, c.alu_table(ALU_ASL, value, 0, FLAG_C));
+        c.set_c(value & 0x80);
+        rmw_write<M>(c, addr, value << 1);
+    }
+    template <int M> static void op_LSR(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t value = rmw_read<M>(c, addr);
+        if (CPU6502_ALU_TABLES) return rmw_write<M>(c, addr, c.alu_table(ALU_LSR, value, 0, FLAG_C));
+        c.set_c(value & 0x01);
+        rmw_write<M>(c, addr, value >> 1);
+    }
+    template <int M> static void op_ROL(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t value = rmw_read<M>(c, addr);
+        if (CPU6502_ALU_TABLES) return rmw_write<M>(c, addr, c.alu_table(ALU_ROL, value, 0, FLAG_C));
+        uint8_t res = (value << 1) | (c.p & FLAG_C);
+        c.set_c(value & 0x80);
+        rmw_write<M>(c, addr, res);
+    }
+    template <int M> static void op_ROR(cpu6502_core_t& c, uint16_t addr) {
+        uint8_t value = rmw_read<M>(c, addr);
+        if (CPU6502_ALU_TABLES) return rmw_write<M>(c, addr, c.alu_table(ALU_ROR, value, 0, FLAG_C));
+        uint8_t res = (value >> 1) | ((c.p & FLAG_C) << 7);
+        c.set_c(value & 0x01);
+        rmw_write<M>(c, addr, res);
+    }
+
+    template <int M> static void op_JMP(cpu6502_core_t& c, uint16_t addr) { c.pc = addr; }
+    template <int M> static void op_JSR(cpu6502_core_t& c, uint16_t addr) {
+        uint16_t ret = c.pc - 1;
+        c.push(ret >> 8);
+        c.push(ret & 0xFF);
+        c.pc = addr;
+    }
+    template <int M> static void op_RTS(cpu6502_core_t& c, uint16_t) {
+        uint16_t lo = c.pull();
+        uint16_t hi = c.pull();
+        c.pc = (lo | (hi << 8)) + 1;
+    }
+    template <int M> static void op_RTI(cpu6502_core_t& c, uint16_t) {
+        c.p = (c.pull() & ~FLAG_B) | FLAG_U;
+        uint16_t lo = c.pull();
+        uint16_t hi = c.pull();
+        c.pc = lo | (hi << 8);
+    }
+    // BRK halts the CPU on the BRK opcode, same as the SystemC model
+    template <int M> static void op_BRK(cpu6502_core_t& c, uint16_t) { c.pc -= 1; c.halted = true; }
+    template <int M> static void op_NOP(cpu6502_core_t&, uint16_t) {}
+
+    // Taken branch costs one cycle more, two if it lands on another page
+    static void branch(cpu6502_core_t& c, uint16_t addr, bool taken) {
+        if (taken) {
+            uint16_t target = c.pc + (int8_t)c.read(addr);
+            c.cycles += ((c.pc ^ target) & 0xFF00) ? 2 : 1;
+            c.pc = target;
+        }
+    }
+    template <int M> static void op_BPL(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, !(c.p & FLAG_N)); }
+    template <int M> static void op_BMI(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, c.p & FLAG_N); }
+    template <int M> static void op_BVC(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, !(c.p & FLAG_V)); }
+    template <int M> static void op_BVS(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, c.p & FLAG_V); }
+    template <int M> static void op_BCC(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, !(c.p & FLAG_C)); }
+    template <int M> static void op_BCS(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, c.p & FLAG_C); }
+    template <int M> static void op_BNE(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, !(c.p & FLAG_Z)); }
+    template <int M> static void op_BEQ(cpu6502_core_t& c, uint16_t addr) { branch(c, addr, c.p & FLAG_Z); }
+
+    template <int M> static void op_CLC(cpu6502_core_t& c, uint16_t) { c.p &= ~FLAG_C; }
+    template <int M> static void op_SEC(cpu6502_core_t& c, uint16_t) { c.p |= FLAG_C; }
+    template <int M> static void op_CLI(cpu6502_core_t& c, uint16_t) { c.p &= ~FLAG_I; }
+    template <int M> static void op_SEI(cpu6502_core_t& c, uint16_t) { c.p |= FLAG_I; }
+    template <int M> static void op_CLV(cpu6502_core_t& c, uint16_t) { c.p &= ~FLAG_V; }
+    template <int M> static void op_CLD(cpu6502_core_t& c, uint16_t) { c.p &= ~FLAG_D; }
+    template <int M> static void op_SED(cpu6502_core_t& c, uint16_t) { c.p |= FLAG_D; }
+};
+
+// Dispatch table: NOP everywhere, then every opcode of CPU6502_OPCODE_LIST
+template <class Bus>
+constexpr typename cpu6502_core_t<Bus>::dispatch_table_t cpu6502_core_t<Bus>::build_dispatch() {
+    dispatch_table_t table = {};
+    for (int i = 0; i < 256; ++i) {
+        table.handler[i] = &exec<0xEA, AM_IMP, &op_NOP<AM_IMP> >;
+    }
+#define CPU6502_DISPATCH_ENTRY(opcode, mnemonic, mode) \
+    table.handler[opcode] = &exec<opcode, mode, &op_##mnemonic<mode> >;
+    CPU6502_OPCODE_LIST(CPU6502_DISPATCH_ENTRY)
+#undef CPU6502_DISPATCH_ENTRY
+    return table;
+}
+
+// Built at compile time
+template <class Bus>
+const typename cpu6502_core_t<Bus>::dispatch_table_t cpu6502_core_t<Bus>::dispatch =
+    cpu6502_core_t<Bus>::build_dispatch();
+
+template <class Bus>
+constexpr typename cpu6502_core_t<Bus>::decoded_dispatch_table_t cpu6502_core_t<Bus>::build_decoded_dispatch() {
+    decoded_dispatch_table_t table = {};
+    for (int i = 0; i < 256; ++i) {
+        table.handler[i] = &execute<0xEA, AM_IMP, &op_NOP<AM_IMP> >;
+    }
+#define CPU6502_DECODED_ENTRY(opcode, mnemonic, mode) \
+    table.handler[opcode] = &execute<opcode, mode, &op_##mnemonic<mode> >;
+    CPU6502_OPCODE_LIST(CPU6502_DECODED_ENTRY)
+#undef CPU6502_DECODED_ENTRY
+    return table;
+}
+
+template <class Bus>
+const typename cpu6502_core_t<Bus>::decoded_dispatch_table_t cpu6502_core_t<Bus>::decoded_dispatch =
+    cpu6502_core_t<Bus>::build_decoded_dispatch();
+
+// Core over a flat uint8_t[65536], compiled once in the cpu6502_core library
+typedef cpu6502_core_t<flat_memory_bus> cpu6502_core;
+extern template class cpu6502_core_t<flat_memory_bus>;
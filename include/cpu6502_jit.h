@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "cpu6502_block_cache.h"
+
+// Native code is only generated for x86-64 Linux, elsewhere (or with
+// -DCPU6502_JIT=0) every block stays on the interpreter
+#ifndef CPU6502_JIT
+#if defined(__x86_64__) && defined(__linux__)
+#define CPU6502_JIT 1
+#else
+#define CPU6502_JIT 0
+#endif
+#endif
+
+// Dynamic binary translator for cpu6502_core_t::run_jit().
+//
+// Blocks of the cpu6502_block_cache are counted as they run, a block reaching
+// `threshold` executions is translated into x86-64 code in an mmap'd arena.
+// The translated code keeps A/X/Y in host registers and works on the core
+// directly: it loads operands straight from the guest memory array, calls
+// back into the core for every store, and computes C/V from the host flags.
+// N/Z are lazy: the last result is kept in a register and only folded into
+// P when the block exits or something reads P.
+//
+// A block ending in a branch or jump back to its own start loops inside the
+// native code instead of returning to the dispatcher every iteration.
+//
+// Translation stops at the first opcode it does not handle (RTI, BRK,
+// JMP ($xxxx)), the interpreter runs the rest of the block. A store that
+// invalidates cached code leaves the native block right after the store.
+// Translations hang off the cached blocks, so whatever drops a block from the
+// cache (memory::write_mem, a write through the core) drops its code too.
+//
+// When perf_map is set every translation is listed in /tmp/perf-<pid>.map,
+// so `perf report` shows guest blocks as cpu6502_block_XXXX symbols.
+
+// Where the translated code finds the core registers, and the store callback.
+// Filled by cpu6502_core_t::jit_layout().
+struct cpu6502_jit_layout_t {
+    size_t a, x, y, s, p, pc, cycles;
+    // Writes value to addr through the core's bus, returns nonzero when the
+    // write invalidated cached code
+    uint32_t (*write)(void* core, uint32_t addr, uint32_t value, cpu6502_block_cache* cache);
+};
+
+class cpu6502_jit {
+public:
+    // Runs a translated block on core, returns how many instructions it executed.
+    // A block jumping back to its own start keeps looping natively while
+    // another pass fits in budget.
+    typedef uint64_t (*native_fn)(void* core, uint8_t* mem, uint64_t budget);
+
+    cpu6502_block_cache& cache;
+    unsigned threshold;
+
+    uint64_t translations;  // blocks translated
+    uint64_t flushes;       // arena resets
+    uint64_t native_runs;   // translated blocks executed
+
+    cpu6502_jit(cpu6502_block_cache& cache, unsigned threshold = 16, size_t arena_size = 4 << 20,
+                bool perf_map = false);
+    ~cpu6502_jit();
+    cpu6502_jit(const cpu6502_jit&) = delete;
+    cpu6502_jit& operator=(const cpu6502_jit&) = delete;
+
+    // False when native code cannot be generated (other host, mmap refused)
+    bool available() const { return arena != nullptr; }
+
+    // Translated code of block, translating it once it gets hot. nullptr
+    // while it is cold or cannot be translated.
+    native_fn native_code(cpu6502_block_t& block, const cpu6502_jit_layout_t& layout) {
+        if (block.native && block.native_epoch == epoch) {
+            native_runs++;
+            return (native_fn)block.native;
+        }
+        if (!arena || block.jit_failed || ++block.exec_count < threshold) {
+            return nullptr;
+        }
+        return translate(block, layout);
+    }
+
+    // Drop all generated code
+    void flush();
+    void reset_counters();
+
+private:
+    uint8_t* arena;
+    size_t arena_size;
+    size_t used;
+    uint64_t epoch;  // bumped by flush(), older translations are stale
+    FILE* perf_map;
+
+    native_fn translate(cpu6502_block_t& block, const cpu6502_jit_layout_t& layout);
+};
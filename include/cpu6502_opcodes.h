@@ -0,0 +1,124 @@
+#pragma once
+
+
+// Opcodes decoded by control_unit, as X(opcode, mnemonic, addressing mode).
+// Every table over the ISA (dispatch, metadata, ...) is expanded from this list,
+// opcodes not listed here are executed as 1-byte NOP.
+#define CPU6502_OPCODE_LIST(X) \
+    /* Load/Store */ \
+    X(0xA9, LDA, AM_IMM)  X(0xA5, LDA, AM_ZP)   X(0xB5, LDA, AM_ZPX)  X(0xAD, LDA, AM_ABS) \
+    X(0xBD, LDA, AM_ABSX) X(0xB9, LDA, AM_ABSY) X(0xA1, LDA, AM_INDX) X(0xB1, LDA, AM_INDY) \
+    X(0xA2, LDX, AM_IMM)  X(0xA6, LDX, AM_ZP)   X(0xB6, LDX, AM_ZPY)  X(0xAE, LDX, AM_ABS) \
+    X(0xBE, LDX, AM_ABSY) \
+    X(0xA0, LDY, AM_IMM)  X(0xA4, LDY, AM_ZP)   X(0xB4, LDY, AM_ZPX)  X(0xAC, LDY, AM_ABS) \
+    X(0xBC, LDY, AM_ABSX) \
+    X(0x85, STA, AM_ZP)   X(0x95, STA, AM_ZPX)  X(0x8D, STA, AM_ABS)  X(0x9D, STA, AM_ABSX) \
+    X(0x99, STA, AM_ABSY) X(0x81, STA, AM_INDX) X(0x91, STA, AM_INDY) \
+    X(0x86, STX, AM_ZP)   X(0x96, STX, AM_ZPY)  X(0x8E, STX, AM_ABS) \
+    X(0x84, STY, AM_ZP)   X(0x94, STY, AM_ZPX)  X(0x8C, STY, AM_ABS) \
+    /* Transfers */ \
+    X(0xAA, TAX, AM_IMP)  X(0xA8, TAY, AM_IMP)  X(0xBA, TSX, AM_IMP)  X(0x8A, TXA, AM_IMP) \
+    X(0x9A, TXS, AM_IMP)  X(0x98, TYA, AM_IMP) \
+    /* Stack */ \
+    X(0x48, PHA, AM_IMP)  X(0x08, PHP, AM_IMP)  X(0x68, PLA, AM_IMP)  X(0x28, PLP, AM_IMP) \
+    /* Logic */ \
+    X(0x29, AND, AM_IMM)  X(0x25, AND, AM_ZP)   X(0x35, AND, AM_ZPX)  X(0x2D, AND, AM_ABS) \
+    X(0x3D, AND, AM_ABSX) X(0x39, AND, AM_ABSY) X(0x21, AND, AM_INDX) X(0x31, AND, AM_INDY) \
+    X(0x09, ORA, AM_IMM)  X(0x05, ORA, AM_ZP)   X(0x15, ORA, AM_ZPX)  X(0x0D, ORA, AM_ABS) \
+    X(0x1D, ORA, AM_ABSX) X(0x19, ORA, AM_ABSY) X(0x01, ORA, AM_INDX) X(0x11, ORA, AM_INDY) \
+    X(0x49, EOR, AM_IMM)  X(0x45, EOR, AM_ZP)   X(0x55, EOR, AM_ZPX)  X(0x4D, EOR, AM_ABS) \
+    X(0x5D, EOR, AM_ABSX) X(0x59, EOR, AM_ABSY) X(0x41, EOR, AM_INDX) X(0x51, EOR, AM_INDY) \
+    /* Arithmetic */ \
+    X(0x69, ADC, AM_IMM)  X(0x65, ADC, AM_ZP)   X(0x75, ADC, AM_ZPX)  X(0x6D, ADC, AM_ABS) \
+    X(0x7D, ADC, AM_ABSX) X(0x79, ADC, AM_ABSY) X(0x61, ADC, AM_INDX) X(0x71, ADC, AM_INDY) \
+    X(0xE9, SBC, AM_IMM)  X(0xE5, SBC, AM_ZP)   X(0xF5, SBC, AM_ZPX)  X(0xED, SBC, AM_ABS) \
+    X(0xFD, SBC, AM_ABSX) X(0xF9, SBC, AM_ABSY) X(0xE1, SBC, AM_INDX) X(0xF1, SBC, AM_INDY) \
+    /* Increment/Decrement memory */ \
+    X(0xC6, DEC, AM_ZP)   X(0xD6, DEC, AM_ZPX)  X(0xCE, DEC, AM_ABS)  X(0xDE, DEC, AM_ABSX) \
+    X(0xE6, INC, AM_ZP)   X(0xF6, INC, AM_ZPX)  X(0xEE, INC, AM_ABS)  X(0xFE, INC, AM_ABSX) \
+    /* Shifts and rotates */ \
+    X(0x0A, ASL, AM_ACC)  X(0x06, ASL, AM_ZP)   X(0x16, ASL, AM_ZPX)  X(0x0E, ASL, AM_ABS) \
+    X(0x1E, ASL, AM_ABSX) \
+    X(0x4A, LSR, AM_ACC)  X(0x46, LSR, AM_ZP)   X(0x56, LSR, AM_ZPX)  X(0x4E, LSR, AM_ABS) \
+    X(0x5E, LSR, AM_ABSX) \
+    X(0x2A, ROL, AM_ACC)  X(0x26, ROL, AM_ZP)   X(0x36, ROL, AM_ZPX)  X(0x2E, ROL, AM_ABS) \
+    X(0x3E, ROL, AM_ABSX) \
+    X(0x6A, ROR, AM_ACC)  X(0x66, ROR, AM_ZP)   X(0x76, ROR, AM_ZPX)  X(0x6E, ROR, AM_ABS) \
+    X(0x7E, ROR, AM_ABSX) \
+    /* Jumps and subroutines */ \
+    X(0x4C, JMP, AM_ABS)  X(0x6C, JMP, AM_IND)  X(0x20, JSR, AM_ABS) \
+    X(0x60, RTS, AM_IMP)  X(0x40, RTI, AM_IMP)  X(0x00, BRK, AM_IMP) \
+    /* Branches */ \
+    X(0x10, BPL, AM_REL)  X(0x30, BMI, AM_REL)  X(0x50, BVC, AM_REL)  X(0x70, BVS, AM_REL) \
+    X(0x90, BCC, AM_REL)  X(0xB0, BCS, AM_REL)  X(0xD0, BNE, AM_REL)  X(0xF0, BEQ, AM_REL) \
+    /* Flags */ \
+    X(0x18, CLC, AM_IMP)  X(0x38, SEC, AM_IMP)  X(0x58, CLI, AM_IMP)  X(0x78, SEI, AM_IMP) \
+    X(0xB8, CLV, AM_IMP)  X(0xD8, CLD, AM_IMP)  X(0xF8, SED, AM_IMP) \
+    /* Compare */ \
+    X(0xC9, CMP, AM_IMM)  X(0xC5, CMP, AM_ZP)   X(0xD5, CMP, AM_ZPX)  X(0xCD, CMP, AM_ABS) \
+    X(0xDD, CMP, AM_ABSX) X(0xD9, CMP, AM_ABSY) X(0xC1, CMP, AM_INDX) X(0xD1, CMP, AM_INDY) \
+    X(0xE0, CPX, AM_IMM)  X(0xE4, CPX, AM_ZP)   X(0xEC, CPX, AM_ABS) \
+    X(0xC0, CPY, AM_IMM)  X(0xC4, CPY, AM_ZP)   X(0xCC, CPY, AM_ABS)
+
+// Instruction classes
+enum cpu6502_class_t {
+    OPC_READ   = 0x01, // reads its operand from memory/immediate
+    OPC_STORE  = 0x02, // only writes memory (STA, STX, STY)
+    OPC_RMW    = 0x04, // read-modify-write on memory (INC, DEC, shifts)
+    OPC_BRANCH = 0x08, // conditional relative branch
+    OPC_JUMP   = 0x10, // unconditional change of PC (JMP, JSR, RTS, RTI, BRK)
+    OPC_LEGAL  = 0x80  // decoded by control_unit
+};
+
+// Mnemonics as M(name, class), shifts and rotates are RMW only on memory
+#define CPU6502_MNEMONIC_LIST(M) \
+    M(LDA, OPC_READ)  M(LDX, OPC_READ)  M(LDY, OPC_READ) \
+    M(STA, OPC_STORE) M(STX, OPC_STORE) M(STY, OPC_STORE) \
+    M(TAX, 0) M(TAY, 0) M(TSX, 0) M(TXA, 0) M(TXS, 0) M(TYA, 0) \
+    M(PHA, 0) M(PHP, 0) M(PLA, 0) M(PLP, 0) \
+    M(AND, OPC_READ)  M(ORA, OPC_READ)  M(EOR, OPC_READ) \
+    M(ADC, OPC_READ)  M(SBC, OPC_READ) \
+    M(DEC, OPC_RMW)   M(INC, OPC_RMW) \
+    M(ASL, OPC_RMW)   M(LSR, OPC_RMW)   M(ROL, OPC_RMW)   M(ROR, OPC_RMW) \
+    M(JMP, OPC_JUMP)  M(JSR, OPC_JUMP)  M(RTS, OPC_JUMP)  M(RTI, OPC_JUMP)  M(BRK, OPC_JUMP) \
+    M(BPL, OPC_BRANCH) M(BMI, OPC_BRANCH) M(BVC, OPC_BRANCH) M(BVS, OPC_BRANCH) \
+    M(BCC, OPC_BRANCH) M(BCS, OPC_BRANCH) M(BNE, OPC_BRANCH) M(BEQ, OPC_BRANCH) \
+    M(CLC, 0) M(SEC, 0) M(CLI, 0) M(SEI, 0) M(CLV, 0) M(CLD, 0) M(SED, 0) \
+    M(CMP, OPC_READ)  M(CPX, OPC_READ)  M(CPY, OPC_READ) \
+    M(NOP, 0)
+
+enum cpu6502_mnemonic_t {
+#define CPU6502_MNEMONIC_ENUM(name, cls) MN_##name,
+    CPU6502_MNEMONIC_LIST(CPU6502_MNEMONIC_ENUM)
+#undef CPU6502_MNEMONIC_ENUM
+    MN_COUNT
+};
+
+// Addressing modes of the ISA
+enum cpu6502_mode_t {
+    AM_IMP,   // implied
+    AM_ACC,   // accumulator (ASL A)
+    AM_IMM,   // #$42
+    AM_ZP,    // $42
+    AM_ZPX,   // $42,X
+    AM_ZPY,   // $42,Y
+    AM_ABS,   // $1234
+    AM_ABSX,  // $1234,X
+    AM_ABSY,  // $1234,Y
+    AM_IND,   // ($1234), JMP only
+    AM_INDX,  // ($42,X)
+    AM_INDY,  // ($42),Y
+    AM_REL    // branch offset
+};
+
+// Status register bits
+enum cpu6502_flag_t {
+    FLAG_C = 0x01, // carry
+    FLAG_Z = 0x02, // zero
+    FLAG_I = 0x04, // interrupt disable
+    FLAG_D = 0x08, // decimal mode
+    FLAG_B = 0x10, // break (only on the stack)
+    FLAG_U = 0x20, // unused, always 1
+    FLAG_V = 0x40, // overflow
+    FLAG_N = 0x80  // negative
+};
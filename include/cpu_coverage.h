@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+
+// Execution coverage for cpu_fuzz: saturating hit counts of features hashed
+// into a 64KB map, cleared before every run. Features:
+//   transition(opcode, from, to)  FSM state transitions of fetch_execute,
+//                                 qualified by the opcode in IR (so also by
+//                                 its addressing mode)
+//   control(from, to)             control word changes of control_unit
+//   retire(opcode, p)             instructions of the loosely-timed models
+//                                 with their N/V/Z/C outcome, BLOCK_CACHED
+//                                 included (one instruction per step)
+// States are below 10, so a from nibble of 0xF never collides with a
+// transition.
+struct cpu_coverage {
+    static const size_t MAP_SIZE = 1 << 16;
+    uint8_t map[MAP_SIZE];
+
+    cpu_coverage() { clear(); }
+    void clear() { std::memset(map, 0, sizeof(map)); }
+
+    void hit(uint32_t feature) {
+        uint8_t& count = map[feature & (MAP_SIZE - 1)];
+        count += count != 0xFF;
+    }
+    void transition(uint8_t opcode, unsigned from, unsigned to) { hit(opcode << 8 | from << 4 | to); }
+    void control(uint32_t from, uint32_t to) { hit((from * 0x9E3779B1u ^ to) * 0x85EBCA6Bu >> 16); }
+    void retire(uint8_t opcode, uint8_t p) {
+        hit(opcode << 8 | 0xF0 | (p >> 4 & 0x0C) | (p & 0x03));
+    }
+};
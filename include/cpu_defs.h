@@ -1,5 +1,25 @@
 #pragma once
+#include <cstdint>
 
 
 #define CPU_CYCLES 500 
+#define CPU_CLOCK_PERIOD_NS 10 // clock period used by the loosely-timed model
 #define FALLBACK_PROGRAM "../programs/hello.txt"
+
+// Word types of the datapath: register and state storage and the internal
+// arithmetic of alu, regfile, memory and cpu. Native integers by default,
+// build with -DCPU_SC_WORDS=1 (CMake option CPU_SC_WORDS) for sc_uint
+// everywhere. Ports and signals stay sc_uint either way, memory::mem stays
+// uint8_t because it is handed out through DMI.
+#ifndef CPU_SC_WORDS
+#define CPU_SC_WORDS 0
+#endif
+
+#if CPU_SC_WORDS
+#include <systemc.h>
+typedef sc_uint<8>  cpu_word_t;   // data byte
+typedef sc_uint<16> cpu_addr_t;   // address
+#else
+typedef uint8_t  cpu_word_t;
+typedef uint16_t cpu_addr_t;
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+
+// Diagnostic trace of the SystemC modules, by category and level.
+//
+//   CPU_TRACE(TRACE_MEMORY, TRACE_VERBOSE, "MEMORY READ: addr=0x" << std::hex << addr);
+//
+// A message is printed when its level is compiled in (CPU_TRACE_LEVEL) and
+// selected at runtime (cpu_trace.categories, cpu_trace.level, set from the
+// --trace option). With CPU_TRACE_LEVEL=0 the macro compiles to nothing, the
+// message arguments are not even evaluated.
+//
+// Levels: 1 info (program output, halt), 2 debug (per instruction),
+// 3 verbose (per bus cycle).
+#ifndef CPU_TRACE_LEVEL
+#define CPU_TRACE_LEVEL 3
+#endif
+
+enum trace_category_t : unsigned {
+    TRACE_FETCH   = 1u << 0,
+    TRACE_DECODE  = 1u << 1,
+    TRACE_ALU     = 1u << 2,
+    TRACE_REGFILE = 1u << 3,
+    TRACE_MEMORY  = 1u << 4,
+    TRACE_IO      = 1u << 5,
+    TRACE_ALL     = (1u << 6) - 1
+};
+
+enum trace_level_t : unsigned {
+    TRACE_OFF     = 0,
+    TRACE_INFO    = 1,
+    TRACE_DEBUG   = 2,
+    TRACE_VERBOSE = 3
+};
+
+// Runtime selection, by default only the output ports are shown
+struct cpu_trace_config {
+    unsigned categories = TRACE_IO;
+    unsigned level = TRACE_INFO;
+    std::ostream* out = &std::cout;
+
+    bool enabled(unsigned category, unsigned message_level) const {
+        return (categories & category) && message_level <= level;
+    }
+};
+
+extern cpu_trace_config cpu_trace;
+
+// Parses a --trace argument, "category[,category...][:level]" with the
+// category names fetch, decode, alu, regfile, memory, io or all, and the
+// level as a number 0-3 (debug when omitted). "off" disables the trace.
+// Returns false on an unknown name, leaving cpu_trace unchanged.
+bool cpu_trace_parse(const std::string& spec);
+
+#if CPU_TRACE_LEVEL > 0
+#define CPU_TRACE(category, message_level, message)                                         \
+    do {                                                                                    \
+        if ((message_level) <= CPU_TRACE_LEVEL && cpu_trace.enabled(category, message_level)) { \
+            *cpu_trace.out << message << std::dec << '\n';                                  \
+        }                                                                                   \
+    } while (0)
+#else
+#define CPU_TRACE(category, message_level, message) do { } while (0)
+#endif
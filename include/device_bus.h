@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+
+// Memory-mapped device, addressed by its offset from the mapped base.
+// The signal-level memory samples the bus every clock cycle it is not
+// writing, so a device may see the same read more than once per access.
+class bus_device {
+public:
+    virtual ~bus_device() {}
+    virtual uint8_t read(uint16_t offset) = 0;
+    virtual void write(uint16_t offset, uint8_t data) = 0;
+    // Reads that differ from the RAM behind the device keep DMI off
+    virtual bool read_side_effects() const { return true; }
+};
+
+// Address decoder in front of the RAM array: 256 pages of 256 bytes. Pages
+// without a device have no entry and decode() returns null after one load,
+// so RAM accesses never look at the devices. A page holding a device has a
+// per-byte table of the device and its base, holes in it are RAM.
+class device_bus {
+public:
+    // False if the range leaves the 64KB space or overlaps a mapped device
+    bool map(uint16_t base, uint32_t size, bus_device* device);
+    void unmap(bus_device* device);
+
+    // Device at addr and the offset into it, null for RAM
+    bus_device* decode(uint16_t addr, uint16_t& offset) const {
+        const device_page* page = pages[addr >> 8].get();
+        if (!page) {
+            return nullptr;
+        }
+        const slot_t& slot = page->slot[addr & 0xFF];
+        offset = addr - slot.base;
+        return slot.device;
+    }
+
+    bool is_device(uint16_t addr) const {
+        uint16_t offset;
+        return decode(addr, offset) != nullptr;
+    }
+
+    // No mapped device has read side effects, all reads may come from RAM
+    bool dmi_readable() const;
+
+private:
+    struct slot_t {
+        bus_device* device;
+        uint16_t base;
+    };
+    struct device_page {
+        slot_t slot[256];
+    };
+
+    std::unique_ptr<device_page> pages[256];
+};
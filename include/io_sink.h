@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// Destinations of the output ports 0xFF00-0xFF03. memory hands every port
+// write to an io_sink as a record, sinks format and buffer it as they like
+// and only flush on flush() (CPU halt, end of simulation) or when full.
+//
+// Text of a record, as in the I/O log:
+//   port 0 decimal "42", port 1 hex "0x2a", port 2 character "*",
+//   port 3 binary "00101010"
+// Records are concatenated as is, or one per line as
+// "[cycle] PORT n: text" when stamped with the simulation cycle. A file
+// starts with a three-line header whose "Format:" line names which of the two.
+struct io_record_t {
+    uint64_t cycle;   // clock cycle of the write
+    uint8_t port;     // 0-3
+    uint8_t value;
+};
+
+// Text of the value, returns its length (at most 8, text is not terminated)
+size_t io_port_text(const io_record_t& record, char* text);
+// Text of the record as written to a sink, returns its length (at most 48)
+size_t io_format_record(const io_record_t& record, bool stamp_cycles, char* text);
+// Console message, "PORT 1 (HEX): 0x2a"
+std::string io_port_message(const io_record_t& record);
+
+class io_sink {
+public:
+    virtual ~io_sink() {}
+    virtual void write(const io_record_t& record) = 0;
+    virtual void flush() {}
+};
+
+// Buffered file, the I/O log header first
+class io_file_sink : public io_sink {
+public:
+    io_file_sink(const std::string& path, bool stamp_cycles = false, size_t buffer_size = 1 << 16);
+    ~io_file_sink() override;
+
+    bool is_open() const { return file != nullptr; }
+    void write(const io_record_t& record) override;
+    void flush() override;
+
+private:
+    std::FILE* file;
+    bool stamp_cycles;
+    std::vector<char> buffer;
+    size_t used = 0;
+};
+
+// Any ostream (std::cout), flushed only on flush()
+class io_stream_sink : public io_sink {
+public:
+    explicit io_stream_sink(std::ostream& out, bool stamp_cycles = false) : out(out), stamp_cycles(stamp_cycles) {}
+    void write(const io_record_t& record) override;
+    void flush() override { out.flush(); }
+
+private:
+    std::ostream& out;
+    bool stamp_cycles;
+};
+
+// Kept in memory: the records and the text a file sink would have written
+class io_buffer_sink : public io_sink {
+public:
+    explicit io_buffer_sink(bool stamp_cycles = false) : stamp_cycles(stamp_cycles) {}
+    void write(const io_record_t& record) override;
+    void clear() { records.clear(); text.clear(); }
+
+    std::vector<io_record_t> records;
+    std::string text;
+
+private:
+    bool stamp_cycles;
+};
+
+class io_callback_sink : public io_sink {
+public:
+    explicit io_callback_sink(std::function<void(const io_record_t&)> callback) : callback(std::move(callback)) {}
+    void write(const io_record_t& record) override { callback(record); }
+
+private:
+    std::function<void(const io_record_t&)> callback;
+};
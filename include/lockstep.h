@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cpu6502_core.h"
+#include "device_bus.h"
+
+
+// Architectural state compared when an instruction retires
+struct lockstep_state_t {
+    uint16_t pc;            // address of the next instruction (of BRK once halted)
+    uint8_t a, x, y, s, p;
+};
+
+struct lockstep_write_t {
+    uint16_t addr;
+    uint8_t data;
+};
+
+// Golden reference for the cpu models: cpu6502_core on its own copy of the
+// memory, run in lockstep with the model under test at instruction
+// retirement. The model reports every bus write as it happens (model_write)
+// and its registers whenever instructions retire (retire). The reference then
+// executes as many instructions, and the registers, PC and the sequence of
+// writes have to match. On the first divergence the checker stops comparing
+// and report() describes it.
+//
+// Writes to addresses of devices are compared but not stored, reads there
+// return the RAM behind, as for the output ports. Writes into the model's
+// memory that bypass the bus (loaders, debug writes) are not seen: start()
+// again afterwards.
+class lockstep_checker {
+public:
+    lockstep_checker() : mem(65536), reference(reference_bus{ this, mem.data() }) {}
+    lockstep_checker(const lockstep_checker&) = delete; // the reference bus points back here
+    lockstep_checker& operator=(const lockstep_checker&) = delete;
+
+    // Mapped devices of the model, null when there are none
+    const device_bus* devices = nullptr;
+
+    // Reference from a copy of mem and the model's state, drops pending writes
+    void start(const uint8_t* mem, const lockstep_state_t& state);
+    bool started() const { return running; }
+
+    void model_write(uint16_t addr, uint8_t data) {
+        if (running) {
+            model_writes.push_back(lockstep_write_t{ addr, data });
+        }
+    }
+
+    // n instructions retired on the model, which is now in state. False on
+    // the first divergence, the checker stops until the next start().
+    bool retire(const lockstep_state_t& state, uint64_t n = 1) {
+        if (!running) {
+            return !diverged;
+        }
+        uint16_t pc = reference.pc;
+        reference.run(n);
+        checked += n;
+        if (reference.pc != state.pc || reference.a != state.a || reference.x != state.x ||
+            reference.y != state.y || reference.s != state.s || reference.p != state.p ||
+            (!(model_writes.empty() && reference_writes.empty()) && !same_writes())) {
+            fail(state, pc, n);
+            return false;
+        }
+        model_writes.clear();
+        reference_writes.clear();
+        return true;
+    }
+
+    bool failed() const { return diverged; }
+    uint64_t instructions() const { return checked; }   // compared since start()
+    const std::string& report() const { return text; } // empty until a divergence
+
+private:
+    struct reference_bus {
+        lockstep_checker* owner;
+        uint8_t* mem;
+
+        uint8_t read(uint16_t addr) { return mem[addr]; }
+        void write(uint16_t addr, uint8_t data) {
+            owner->reference_writes.push_back(lockstep_write_t{ addr, data });
+            if (!owner->devices || !owner->devices->is_device(addr)) {
+                mem[addr] = data;
+            }
+        }
+    };
+
+    std::vector<uint8_t> mem;
+    cpu6502_core_t<reference_bus> reference;
+    std::vector<lockstep_write_t> model_writes, reference_writes;
+    bool running = false;
+    bool diverged = false;
+    uint64_t checked = 0;
+    std::string text;
+
+    bool same_writes() const {
+        if (model_writes.size() != reference_writes.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < model_writes.size(); ++i) {
+            if (model_writes[i].addr != reference_writes[i].addr || model_writes[i].data != reference_writes[i].data) {
+                return false;
+            }
+        }
+        return true;
+    }
+    void fail(const lockstep_state_t& state, uint16_t pc, uint64_t n);
+};
@@ -1,13 +1,26 @@
 #pragma once
 #include <systemc.h>
+#include <tlm.h>
+#include <tlm_utils/simple_target_socket.h>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <cstdio>
+#include <cstring>
+#include <memory>
+#include "cpu6502_block_cache.h"
+#include "cpu_defs.h"
+#include "cpu_trace.h"
+#include "trace_file.h"
+#include "io_sink.h"
+#include "device_bus.h"
+#include "program_image.h"
+#include "memory_snapshot.h"
+#include "lockstep.h"
 using namespace std;
 
 
-// 64KB RAM memory module with memory mapped I/O ports
+// 64KB RAM memory module with memory mapped devices (output ports by default)
 SC_MODULE(memory) {
     sc_in<bool> clk;
     sc_in<bool> we; // write enable
@@ -15,93 +28,199 @@ SC_MODULE(memory) {
     sc_in<sc_uint<8>> w_data; // write data bus
     sc_out<sc_uint<8>> r_data; // read data bus
 
-    sc_uint<8> mem[65536]; // 64KB memory array
+    uint8_t mem[65536]; // 64KB memory array, plain bytes so it can be handed out through DMI
+
+    // TLM-2.0 view of the same memory (loosely-timed models, debug access).
+    // b_transport behaves like process(): devices, block cache invalidation.
+    // DMI is granted read-only over the whole array while no device has read
+    // side effects, writes have to stay transactions.
+    tlm_utils::simple_target_socket<memory> socket;
+
+    // Address decoder of the mapped devices, see device_bus.h
+    device_bus bus;
+
+    // Output ports 0xFF00-0xFF03 (decimal, hex, character, binary), write-only:
+    // reads return the RAM behind them
+    struct output_ports : bus_device {
+        memory* owner;
+        explicit output_ports(memory* owner) : owner(owner) {}
+        uint8_t read(uint16_t offset) override { return owner->mem[0xFF00 + offset]; }
+        void write(uint16_t offset, uint8_t data) override { owner->write_io_port((uint8_t)offset, data); }
+        bool read_side_effects() const override { return false; }
+    } io_ports;
+
+    // Decoded code of the block cache model, told about every RAM write (may be null)
+    cpu6502_block_cache* block_cache = nullptr;
+
+    // Golden reference checked by cpu, told about every bus write (may be null)
+    lockstep_checker* lockstep = nullptr;
+
+    // Binary trace, one record per bus cycle of process() (may be null)
+    trace_file_writer* trace_file = nullptr;
     
-    // Static members for I/O file handling
-    static ofstream io_output;
-    static bool io_file_opened;
+    // Output port destination (io_sink.h). When none is set, port writes go to
+    // a buffered file owned by this instance, one record per line stamped with
+    // the clock cycle if io_stamp_cycles is set. The file is io_path, or
+    // ../output/io_output_<name()>.txt when that is empty, so every instance
+    // gets its own. Two instances opening the same file is an error.
+    io_sink* io = nullptr;
+    string io_path;
+    bool io_stamp_cycles = false;
+    std::unique_ptr<io_file_sink> default_io;
+    std::string default_io_file; // claimed by default_io, released on destruction
 
     void process() {
         if (we.read()) {
-            sc_uint<16> address = addr.read();
-            sc_uint<8> data = w_data.read();
-            
-            // Check if its saving to I/O port range
-            if (address == 0xFF00) {
-                // I/O PORT 0: Display value as decimal
-                string output = "PORT 0 (DEC): " + to_string((int)data);
-                cout << "*** OUTPUT " << output << " ***" << endl;
-                write_to_io_file(to_string((int)data));
-            }
-            else if (address == 0xFF01) {
-                // I/O PORT 1: Display value as hex
-                char hex_str[20];
-                char hex_strw[20];
-                sprintf(hex_str, "PORT 1 (HEX): 0x%02x", (int)data);
-                sprintf(hex_strw, "0x%02x", (int)data);
-                string output = hex_str;
-                cout << "*** OUTPUT " << output << " ***" << endl;
-                write_to_io_file(string(hex_strw));
-            }
-            else if (address == 0xFF02) {
-                // I/O PORT 2: Display value as ASCII character
-                string output = "PORT 2 (CHR): '" + string(1, (char)data) + "'";
-                cout << "*** OUTPUT " << output << " ***" << endl;
-                write_to_io_file(string(1, (char)data));
-            }
-            else if (address == 0xFF03) {
-                // I/O PORT 3: Display value as binary
-                string binary = "";
-                for (int i = 7; i >= 0; i--) {
-                    binary += ((data >> i) & 1) ? "1" : "0";
-                }
-                string output = "PORT 3 (BIN): " + binary;
-                cout << "*** OUTPUT " << output << " ***" << endl;
-                write_to_io_file(binary);
-            }
-            else {
-                // Normal write to memory
-                mem[address] = data;
-                cout << "MEMORY WRITE: addr=0x" << hex << address 
-                     << " data=0x" << data << dec << endl;
+            cpu_addr_t address = addr.read();
+            cpu_word_t data = w_data.read();
+            write(address, data);
+            if (trace_file) {
+                trace_file->write(trace_memory_record(clock_cycle(), true, address, data));
             }
+            CPU_TRACE(TRACE_MEMORY, TRACE_VERBOSE, "MEMORY WRITE: addr=0x" << hex << (int)address
+                      << " data=0x" << (int)data);
         } else {
             // Read from memory (only when not writing)
-            r_data.write(mem[addr.read()]);
-            cout << "MEMORY READ: addr=0x" << hex << addr.read() 
-                 << " data=0x" << mem[addr.read()] << dec << endl;
+            cpu_addr_t address = addr.read();
+            uint8_t data = read(address);
+            r_data.write(data);
+            if (trace_file) {
+                trace_file->write(trace_memory_record(clock_cycle(), false, address, data));
+            }
+            CPU_TRACE(TRACE_MEMORY, TRACE_VERBOSE, "MEMORY READ: addr=0x" << hex << (int)address
+                      << " data=0x" << (int)data);
         }
     }
-    
-    void write_to_io_file(const string& output) {
-        if (!io_file_opened) {
-            io_output.open("../output/io_output.txt", ios::out);
-            io_file_opened = true;
-            if (io_output.is_open()) {
-                io_output << "=== CPU - Output Ports Log ===" << endl;
-                io_output << "Format: [TIME] PORT_MESSAGE" << endl;
-                io_output << "=====================================" << endl;
+
+    // Current clock cycle of the system clock, for trace records
+    static uint64_t clock_cycle() {
+        return sc_time_stamp().value() / sc_time(CPU_CLOCK_PERIOD_NS, SC_NS).value();
+    }
+
+    // CPU access as seen on the bus: a mapped device or RAM
+    uint8_t read(cpu_addr_t address) {
+        uint16_t offset;
+        if (bus_device* device = bus.decode(address, offset)) {
+            return device->read(offset);
+        }
+        return mem[address];
+    }
+
+    void write(cpu_addr_t address, cpu_word_t data) {
+        if (lockstep) {
+            lockstep->model_write(address, data);
+        }
+        uint16_t offset;
+        if (bus_device* device = bus.decode(address, offset)) {
+            device->write(offset, data);
+        } else {
+            write_mem(address, data);
+        }
+    }
+
+    // Maps a device over [base, base + size), false if the range is taken.
+    // A device with read side effects revokes the DMI pointer.
+    bool map_device(uint16_t base, uint32_t size, bus_device* device);
+    void unmap_device(bus_device* device);
+
+    // Program segments copied straight into the array (no devices, like debug
+    // writes) and the entry point to the reset vector. Returns the bytes loaded.
+    size_t load_image(const program_image& image) {
+        size_t loaded = copy_program_image(image, mem);
+        contents_replaced();
+        return loaded;
+    }
+
+    // Called after writing straight into mem (loaders, checkpoint restore)
+    void contents_replaced() {
+        snapshots.mark_all();
+        if (block_cache) {
+            block_cache->clear();
+        }
+    }
+
+    // Copy-on-write snapshots of the RAM array (memory_snapshot.h). Every RAM
+    // write marks its page, so snapshot, restore and diff cost O(pages written
+    // since the last snapshot or restore). Devices are not part of a snapshot.
+    memory_page_tracker snapshots;
+
+    memory_snapshot snapshot() {
+        return snapshots.snapshot(mem);
+    }
+
+    // Returns the pages copied back, only their cached blocks are dropped
+    size_t restore(const memory_snapshot& snapshot) {
+        const std::vector<uint8_t>& copied = snapshots.restore(snapshot, mem);
+        if (block_cache) {
+            for (uint8_t page : copied) {
+                block_cache->invalidate_page(page);
             }
         }
-        
-        if (io_output.is_open()) {
-            // Add timestamp (simplified for debugging)
-            static int counter = 0;
-            //io_output << "[" << setfill('0') << setw(4) << ++counter << "] " << output << endl;
-            io_output << output;
-            io_output.flush(); // Immediate write
+        return copied.size();
+    }
+
+    // Pages (address >> 8) where RAM differs from the snapshot
+    std::vector<uint8_t> diff(const memory_snapshot& snapshot) const {
+        return snapshots.diff(snapshot, mem);
+    }
+
+    // TLM-2.0 target interface (src/memory.cpp)
+    void b_transport(tlm::tlm_generic_payload& trans, sc_time& delay);
+    unsigned transport_dbg(tlm::tlm_generic_payload& trans);
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi);
+    
+    // RAM write, also used by the loosely-timed models
+    void write_mem(cpu_addr_t address, cpu_word_t data) {
+        mem[address] = data;
+        snapshots.mark(address);
+        if (block_cache) {
+            block_cache->invalidate_write(address);
         }
-        
     }
 
-    SC_CTOR(memory) {
+    bool is_device(cpu_addr_t address) const {
+        return bus.is_device(address);
+    }
+
+    // Handle a write to one of the output ports
+    void write_io_port(uint8_t port, cpu_word_t data) {
+        io_record_t record = { clock_cycle(), port, (uint8_t)data };
+        io_destination().write(record);
+        CPU_TRACE(TRACE_IO, TRACE_INFO, "*** OUTPUT " << io_port_message(record) << " ***");
+    }
+
+    // Writes buffered by the output destination reach it, called on halt
+    void flush_io() {
+        if (io) {
+            io->flush();
+        } else if (default_io) {
+            default_io->flush();
+        }
+    }
+
+    // io, or the file at io_path opened on the first port write
+    io_sink& io_destination() {
+        if (io) {
+            return *io;
+        }
+        if (!default_io) {
+            open_default_io();
+        }
+        return *default_io;
+    }
+    void open_default_io();
+
+    SC_CTOR(memory) : socket("socket"), io_ports(this) {
+        // Cleared, so a program loaded without an entry point boots from 0x0000
+        memset(mem, 0, sizeof(mem));
+        bus.map(0xFF00, 4, &io_ports);
         SC_METHOD(process);
         sensitive << clk.pos();
+
+        socket.register_b_transport(this, &memory::b_transport);
+        socket.register_transport_dbg(this, &memory::transport_dbg);
+        socket.register_get_direct_mem_ptr(this, &memory::get_direct_mem_ptr);
     }
     
-    ~memory() {
-        if (io_output.is_open()) {
-            io_output.close();
-        }
-    }
+    ~memory();
 };
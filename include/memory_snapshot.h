@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// Copy-on-write snapshots of a flat 64KB array, page by page (256 pages of
+// 256 bytes). A snapshot is a table of immutable pages shared with the
+// snapshots it was taken after; only the pages written in between are new.
+// The array itself stays flat, so reads and the DMI pointer are unaffected.
+struct memory_page {
+    uint8_t bytes[256];
+};
+
+class memory_snapshot {
+public:
+    bool empty() const { return !pages[0]; }
+    uint8_t read(uint16_t addr) const { return pages[addr >> 8]->bytes[addr & 0xFF]; }
+    const uint8_t* page(uint8_t n) const { return pages[n]->bytes; }
+    // Same page object, not just the same contents
+    bool shares_page(const memory_snapshot& other, uint8_t n) const { return pages[n] == other.pages[n]; }
+
+private:
+    friend class memory_page_tracker;
+    std::array<std::shared_ptr<const memory_page>, 256> pages;
+};
+
+// Pages of the array written since the last snapshot or restore, relative to
+// that snapshot (the base). Every RAM write calls mark(), so snapshot, restore
+// and diff copy or compare the dirty pages only, plus a pointer compare per
+// page when restoring or diffing against a snapshot other than the base.
+class memory_page_tracker {
+public:
+    void mark(uint16_t addr) {
+        uint8_t n = addr >> 8;
+        if (!dirty[n]) {
+            dirty[n] = true;
+            dirty_list.push_back(n);
+        }
+    }
+    void mark_all();    // the whole array was replaced
+    size_t dirty_pages() const { return dirty_list.size(); }
+
+    // The first snapshot copies all pages, later ones the dirty pages only
+    memory_snapshot snapshot(const uint8_t* mem);
+    // Array back to the snapshot, which becomes the base. Returns the pages
+    // copied, valid until the next restore.
+    const std::vector<uint8_t>& restore(const memory_snapshot& snapshot, uint8_t* mem);
+    // Pages where the array differs from the snapshot, in address order
+    std::vector<uint8_t> diff(const memory_snapshot& snapshot, const uint8_t* mem) const;
+    // Pages where two snapshots differ
+    static std::vector<uint8_t> diff(const memory_snapshot& a, const memory_snapshot& b);
+
+private:
+    memory_snapshot base;
+    bool dirty[256] = {};
+    std::vector<uint8_t> dirty_list;
+    std::vector<uint8_t> copied;
+
+    void clear_dirty();
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include "cpu6502_opcodes.h"
+
+
+// Per-opcode metadata, generated at compile time from CPU6502_OPCODE_LIST.
+// Decoding an opcode is one indexed load: opcode_table[opcode].
+struct opcode_info_t {
+    uint8_t mnemonic;      // cpu6502_mnemonic_t
+    uint8_t mode;          // cpu6502_mode_t
+    uint8_t length;        // instruction length in bytes
+    uint8_t flags;         // cpu6502_class_t bits
+    uint8_t cycles;        // base cycle count (6502 timing)
+    uint8_t page_penalty;  // extra cycles when indexing crosses a page (or a taken branch does)
+};
+
+struct opcode_table_t {
+    opcode_info_t info[256];
+    constexpr const opcode_info_t& operator[](uint8_t opcode) const { return info[opcode]; }
+};
+
+constexpr uint8_t opcode_length(int mode) {
+    return (mode == AM_IMP || mode == AM_ACC) ? 1
+         : (mode == AM_ABS || mode == AM_ABSX || mode == AM_ABSY || mode == AM_IND) ? 3
+         : 2;
+}
+
+constexpr uint8_t mnemonic_class(int mnemonic) {
+    switch (mnemonic) {
+#define CPU6502_MNEMONIC_CLASS(name, cls) case MN_##name: return cls;
+        CPU6502_MNEMONIC_LIST(CPU6502_MNEMONIC_CLASS)
+#undef CPU6502_MNEMONIC_CLASS
+        default: return 0;
+    }
+}
+
+// 6502 base cycles by mnemonic and addressing mode
+constexpr uint8_t opcode_cycles(int mnemonic, int mode, uint8_t flags) {
+    switch (mnemonic) {
+        case MN_PHA: case MN_PHP: return 3;
+        case MN_PLA: case MN_PLP: return 4;
+        case MN_RTS: case MN_RTI: case MN_JSR: return 6;
+        case MN_BRK: return 7;
+        case MN_JMP: return mode == AM_IND ? 5 : 3;
+        default: break;
+    }
+    bool rmw = flags & OPC_RMW;
+    bool store = flags & OPC_STORE;
+    switch (mode) {
+        case AM_ZP:   return rmw ? 5 : 3;
+        case AM_ZPX:
+        case AM_ZPY:  return rmw ? 6 : 4;
+        case AM_ABS:  return rmw ? 6 : 4;
+        case AM_ABSX:
+        case AM_ABSY: return rmw ? 7 : (store ? 5 : 4);
+        case AM_INDX: return 6;
+        case AM_INDY: return store ? 6 : 5;
+        default:      return 2; // implied, accumulator, immediate, relative
+    }
+}
+
+constexpr opcode_info_t make_opcode_info(int mnemonic, int mode) {
+    uint8_t flags = mnemonic_class(mnemonic) | OPC_LEGAL;
+    if (mode == AM_ACC) {
+        flags &= ~OPC_RMW; // ASL A etc. do not touch memory
+    }
+    bool page_penalty = ((flags & OPC_READ) && (mode == AM_ABSX || mode == AM_ABSY || mode == AM_INDY))
+                      || (flags & OPC_BRANCH);
+    return opcode_info_t{ (uint8_t)mnemonic, (uint8_t)mode, opcode_length(mode), flags,
+                          opcode_cycles(mnemonic, mode, flags), (uint8_t)(page_penalty ? 1 : 0) };
+}
+
+constexpr opcode_table_t make_opcode_table() {
+    opcode_table_t table = {};
+    // Opcodes not decoded by control_unit are 1-byte NOPs
+    for (int i = 0; i < 256; ++i) {
+        table.info[i] = opcode_info_t{ MN_NOP, AM_IMP, 1, 0, 2, 0 };
+    }
+#define CPU6502_OPCODE_INFO(opcode, mnemonic, mode) \
+    table.info[opcode] = make_opcode_info(MN_##mnemonic, mode);
+    CPU6502_OPCODE_LIST(CPU6502_OPCODE_INFO)
+#undef CPU6502_OPCODE_INFO
+    return table;
+}
+
+constexpr opcode_table_t opcode_table = make_opcode_table();
+
+static_assert(opcode_table[0xA9].length == 2 && opcode_table[0xA9].cycles == 2, "LDA #imm");
+static_assert(opcode_table[0xFE].flags & OPC_RMW, "INC abs,X is read-modify-write");
+static_assert(opcode_table[0x00].mnemonic == MN_BRK, "BRK");
+
+// Assembler name of an opcode, "???" for the ones outside CPU6502_OPCODE_LIST
+constexpr const char* opcode_mnemonic_name(uint8_t opcode) {
+    if (!(opcode_table[opcode].flags & OPC_LEGAL)) {
+        return "???";
+    }
+    switch (opcode_table[opcode].mnemonic) {
+#define CPU6502_MNEMONIC_NAME(name, cls) case MN_##name: return #name;
+        CPU6502_MNEMONIC_LIST(CPU6502_MNEMONIC_NAME)
+#undef CPU6502_MNEMONIC_NAME
+        default: return "???";
+    }
+}
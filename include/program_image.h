@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Program to be loaded into the 64KB address space: segments with explicit
+// load addresses and an optional entry point, which the loader writes to the
+// 6502 reset vector ($FFFC/$FFFD) the CPU boots from.
+//
+// File formats, chosen by extension:
+//   .bin         raw bytes, loaded at a given address (0 by default)
+//   .hex .ihex   Intel HEX: data records (00), end (01), extended segment
+//                and linear addresses (02, 04), start addresses (03, 05)
+//                as the entry point
+//   .img         segment image: "CPUIMG01", segment count (u32), entry
+//                (i32, -1 for none), then per segment address (u16),
+//                reserved (u16), length (u32) and the bytes; little-endian
+//   anything else  hex text as in programs/: whitespace separated hex
+//                bytes, '#' starts a comment, loaded at 0
+struct program_segment {
+    uint16_t address;
+    std::vector<uint8_t> bytes;
+};
+
+struct program_image {
+    std::vector<program_segment> segments;
+    int32_t entry = -1;   // reset vector to write, -1 leaves it alone
+
+    size_t size() const;  // bytes over all segments
+};
+
+// Parsers return false with error set. parse_text_program still loads the
+// valid bytes around a bad token, like the old testbench loader did.
+bool parse_text_program(const char* text, size_t length, program_image& image, std::string& error);
+bool parse_intel_hex(const char* text, size_t length, program_image& image, std::string& error);
+bool parse_segment_image(const uint8_t* data, size_t length, program_image& image, std::string& error);
+std::vector<uint8_t> write_segment_image(const program_image& image);
+
+// Reads and parses path by its extension, bin_address is the load address of .bin files
+bool load_program_image(const std::string& path, program_image& image, std::string& error, uint16_t bin_address = 0);
+
+// Copies the segments into a 64KB array and writes the entry to the reset
+// vector, bytes past 0xFFFF are dropped. Returns the bytes copied.
+size_t copy_program_image(const program_image& image, uint8_t* mem);
+
+// FNV-1a over the source bytes, names the cached image
+uint64_t program_hash(const uint8_t* data, size_t length);
+
+// Compiled program cache: hex text and Intel HEX sources are parsed once and
+// stored in dir as a segment image named by the hash of the source bytes.
+// Later loads read the source, hash it and read the image back instead of
+// parsing, an edited source hashes to a new name. Sources that do not parse
+// are never cached, so their errors are reported on every load. Raw binary
+// and segment image files are loaded directly, and so are sources under
+// min_source bytes, which parse faster than the cached image opens.
+class program_cache {
+public:
+    explicit program_cache(const std::string& dir) : dir(dir) {}
+
+    bool load(const std::string& path, program_image& image, std::string& error, uint16_t bin_address = 0);
+    std::string image_path(uint64_t hash, bool intel_hex) const;
+
+    std::string dir;
+    size_t min_source = 4096;
+    unsigned hits = 0;
+    unsigned misses = 0;
+};
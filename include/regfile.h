@@ -1,6 +1,9 @@
 #pragma once
 #include <systemc.h>
 #include <iostream>
+#include "control_word.h"
+#include "cpu_defs.h"
+#include "cpu_trace.h"
 using namespace std;
 
 
@@ -25,63 +28,95 @@ SC_MODULE(regfile) {
     sc_in<bool> clear_decimal;     // clear Decimal Mode flag
     sc_in<bool> clear_overflow;    // clear Overflow flag
 
+    // Optional control word, replaces we, w_addr, r_addr, set_flags and the flag controls when bound
+    control_word_in ctrl;
+
     // Rejestry 6502
-    sc_uint<8> A; // accumulator
-    sc_uint<8> X; // X register
-    sc_uint<8> Y; // Y register
-    sc_uint<8> S; // stack (Stack Pointer)
-    sc_uint<8> P; // status (Processor Status)
+    cpu_word_t A; // accumulator
+    cpu_word_t X; // X register
+    cpu_word_t Y; // Y register
+    cpu_word_t S; // stack (Stack Pointer)
+    cpu_word_t P; // status (Processor Status)
     
     // Internal signal to remember previous we state
     bool prev_we;
 
+    bool bundled;            // ctrl is bound
+    uint32_t prev_strobes;   // flag controls of the last control word seen
+
+    // Control inputs of this cycle, from ctrl or from the discrete ports
+    control_word_t control() {
+        if (bundled) {
+            return ctrl->read();
+        }
+        control_word_t cw;
+        cw.set(CW_REG_WE, we.read()).set(CW_REG_SEL, w_addr.read()).set(CW_REG_SRC, r_addr.read())
+          .set(CW_SET_FLAGS, set_flags.read())
+          .set(CW_SET_CARRY, set_carry.read()).set(CW_CLEAR_CARRY, clear_carry.read())
+          .set(CW_SET_INTERRUPT, set_interrupt.read()).set(CW_CLEAR_INTERRUPT, clear_interrupt.read())
+          .set(CW_SET_DECIMAL, set_decimal.read()).set(CW_CLEAR_DECIMAL, clear_decimal.read())
+          .set(CW_CLEAR_OVERFLOW, clear_overflow.read());
+        return cw;
+    }
+
     void process() {
-        if (we.read()) {
-            switch(w_addr.read()) {
-                case 0: A = w_data.read(); std::cout << "REGFILE: A = 0x" << std::hex << (int)A << std::endl; break;
-                case 1: X = w_data.read(); std::cout << "REGFILE: X = 0x" << std::hex << (int)X << std::endl; break;
-                case 2: Y = w_data.read(); std::cout << "REGFILE: Y = 0x" << std::hex << (int)Y << std::endl; break;
-                case 3: S = w_data.read(); std::cout << "REGFILE: S = 0x" << std::hex << (int)S << std::endl; break;
-                case 4: P = w_data.read(); std::cout << "REGFILE: P = 0x" << std::hex << (int)P << std::endl; break;
+        control_word_t cw = control();
+        if (bundled) {
+            // Same activations as with the discrete ports: clock edge or a flag control change
+            uint32_t strobes = cw.bits & CW_FLAG_STROBES;
+            bool strobe_changed = strobes != prev_strobes;
+            prev_strobes = strobes;
+            if (!clk.posedge() && !strobe_changed) {
+                return;
+            }
+        }
+
+        if (cw.reg_we()) {
+            switch(cw.reg_sel()) {
+                case 0: A = w_data.read(); CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: A = 0x" << std::hex << (int)A); break;
+                case 1: X = w_data.read(); CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: X = 0x" << std::hex << (int)X); break;
+                case 2: Y = w_data.read(); CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Y = 0x" << std::hex << (int)Y); break;
+                case 3: S = w_data.read(); CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: S = 0x" << std::hex << (int)S); break;
+                case 4: P = w_data.read(); CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: P = 0x" << std::hex << (int)P); break;
                 default: break;
             }
             // Set Z and N flags if set_flags
-            if (set_flags.read()) {
+            if (cw.set_flags()) {
                 P = (P & ~0x82) | (zero.read() ? 0x02 : 0) | (negative.read() ? 0x80 : 0);
             }
         }
         
         // Signals for direct control of P flags
-        if (set_carry.read()) {
+        if (cw.bits & CW_SET_CARRY) {
             P |= 0x01;  // set bit 0 (Carry)
-            std::cout << "REGFILE: Set Carry flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Set Carry flag, P = 0x" << std::hex << (int)P);
         }
-        if (clear_carry.read()) {
+        if (cw.bits & CW_CLEAR_CARRY) {
             P &= ~0x01; // clear bit 0 (Carry)
-            std::cout << "REGFILE: Clear Carry flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Clear Carry flag, P = 0x" << std::hex << (int)P);
         }
-        if (set_interrupt.read()) {
+        if (cw.bits & CW_SET_INTERRUPT) {
             P |= 0x04;  // set bit 2 (Interrupt Disable)
-            std::cout << "REGFILE: Set Interrupt flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Set Interrupt flag, P = 0x" << std::hex << (int)P);
         }
-        if (clear_interrupt.read()) {
+        if (cw.bits & CW_CLEAR_INTERRUPT) {
             P &= ~0x04; // clear bit 2 (Interrupt Disable)
-            std::cout << "REGFILE: Clear Interrupt flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Clear Interrupt flag, P = 0x" << std::hex << (int)P);
         }
-        if (set_decimal.read()) {
+        if (cw.bits & CW_SET_DECIMAL) {
             P |= 0x08;  // set bit 3 (Decimal Mode)
-            std::cout << "REGFILE: Set Decimal flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Set Decimal flag, P = 0x" << std::hex << (int)P);
         }
-        if (clear_decimal.read()) {
+        if (cw.bits & CW_CLEAR_DECIMAL) {
             P &= ~0x08; // clear bit 3 (Decimal Mode)
-            std::cout << "REGFILE: Clear Decimal flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Clear Decimal flag, P = 0x" << std::hex << (int)P);
         }
-        if (clear_overflow.read()) {
+        if (cw.bits & CW_CLEAR_OVERFLOW) {
             P &= ~0x40; // clear bit 6 (Overflow)
-            std::cout << "REGFILE: Clear Overflow flag, P = 0x" << std::hex << (int)P << std::endl;
+            CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "REGFILE: Clear Overflow flag, P = 0x" << std::hex << (int)P);
         }
         
-        switch(r_addr.read()) {
+        switch(cw.reg_src()) {
             case 0: r_data.write(A); break;
             case 1: r_data.write(X); break;
             case 2: r_data.write(Y); break;
@@ -91,9 +126,13 @@ SC_MODULE(regfile) {
         }
     }
 
-    SC_CTOR(regfile) : A(0), X(0), Y(0), S(0xFF), P(0x20) {
+    void end_of_elaboration() {
+        bundled = ctrl.size() > 0;
+    }
+
+    SC_CTOR(regfile) : A(0), X(0), Y(0), S(0xFF), P(0x20), bundled(false), prev_strobes(0) {
         SC_METHOD(process);
         sensitive << clk.pos() << set_carry << clear_carry << set_interrupt << clear_interrupt 
-                  << set_decimal << clear_decimal << clear_overflow;
+                  << set_decimal << clear_decimal << clear_overflow << ctrl;
     }
 };
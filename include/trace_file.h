@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+// Binary execution trace: a 16-byte header followed by fixed-size 24-byte
+// records in host byte order (little-endian on every supported host).
+//
+//   TRACE_INSTRUCTION  one per retired instruction: PC, opcode and the two
+//                      bytes after it, effective address (0 for implied
+//                      operands), A/X/Y/S/P after retirement
+//   TRACE_READ/WRITE   one per memory bus cycle: addr and data (operand[0])
+//
+// Written by the signal-level cpu and memory (cpu::set_trace_file), decoded
+// offline by tools/tracedump.
+#define TRACE_FILE_MAGIC "CPUTRACE"
+#define TRACE_FILE_VERSION 1
+
+enum trace_record_kind_t : uint8_t {
+    TRACE_INSTRUCTION = 0,
+    TRACE_READ        = 1,
+    TRACE_WRITE       = 2
+};
+
+struct trace_file_header_t {
+    char magic[8];          // TRACE_FILE_MAGIC, not terminated
+    uint32_t version;       // TRACE_FILE_VERSION
+    uint32_t record_size;   // sizeof(trace_record_t)
+};
+
+struct trace_record_t {
+    uint64_t cycle;         // clock cycle (SystemC time / CPU_CLOCK_PERIOD_NS)
+    uint16_t pc;            // instruction address, 0 for memory records
+    uint16_t addr;          // effective address or bus address
+    uint8_t kind;           // trace_record_kind_t
+    uint8_t opcode;
+    uint8_t operand[2];     // instruction bytes after the opcode, data byte of memory records
+    uint8_t a, x, y, s, p;  // registers after retirement, 0 for memory records
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(trace_file_header_t) == 16, "trace header layout");
+static_assert(sizeof(trace_record_t) == 24, "trace record layout");
+
+inline trace_record_t trace_memory_record(uint64_t cycle, bool write, uint16_t addr, uint8_t data) {
+    trace_record_t record = {};
+    record.cycle = cycle;
+    record.kind = write ? TRACE_WRITE : TRACE_READ;
+    record.addr = addr;
+    record.operand[0] = data;
+    return record;
+}
+
+// Collects records in a large buffer and writes it out in one fwrite when
+// full, on flush() and on close. A failed write (disk full, I/O error) drops
+// the buffer and sets failed(); flush() and close() return false from then on.
+class trace_file_writer {
+public:
+    explicit trace_file_writer(size_t buffer_records = 1 << 16);
+    ~trace_file_writer();
+
+    bool open(const std::string& path);   // false if the file cannot be created
+    bool close();
+    bool is_open() const { return file != nullptr; }
+
+    void write(const trace_record_t& record) {
+        buffer[used++] = record;
+        if (used == buffer.size()) {
+            flush();
+        }
+    }
+    bool flush();
+    bool failed() const { return write_error; }
+    uint64_t records() const { return written + used; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<trace_record_t> buffer;
+    size_t used = 0;
+    uint64_t written = 0;
+    bool write_error = false;
+};
+
+class trace_file_reader {
+public:
+    ~trace_file_reader();
+
+    // False if the file is missing or not a trace of this version
+    bool open(const std::string& path);
+    // Up to count records, 0 at the end of the file
+    size_t read(trace_record_t* records, size_t count);
+
+private:
+    std::FILE* file = nullptr;
+};
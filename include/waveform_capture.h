@@ -0,0 +1,109 @@
+#pragma once
+#include <systemc.h>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "control_word.h"
+#include "cpu_defs.h"
+
+
+// Windowed VCD capture of selected signals. Every probe is sampled once per
+// clock cycle at the falling edge, but samples only reach the file while the
+// window is open:
+//
+//   cycle window   [start_cycle, stop_cycle)
+//   PC match       opened when the pc probe equals start_pc
+//   trigger        opened by trigger(), e.g. from a failing check
+//
+// A window opened by PC or trigger lasts post_cycles cycles (and never past
+// stop_cycle). With pre_cycles set, the last pre_cycles samples before the
+// window opens are kept in a ring buffer and written out when it opens,
+// nothing is written for a trigger that never fires. The window opens once.
+// trigger() writes the buffered samples at once, so they reach the file even
+// when the caller stops the simulation right after it.
+// Cycle numbers are SystemC time / CPU_CLOCK_PERIOD_NS, as in the binary trace.
+struct waveform_window_t {
+    uint64_t start_cycle = 0;
+    uint64_t stop_cycle = UINT64_MAX;
+    int start_pc = -1;                 // >= 0: open on this PC (needs the "pc" probe)
+    bool on_trigger = false;           // open on trigger()
+    uint64_t pre_cycles = 0;           // ring buffer depth
+    uint64_t post_cycles = UINT64_MAX; // length of a PC or trigger window
+};
+
+inline uint64_t waveform_value(bool value) { return value; }
+inline uint64_t waveform_value(const control_word_t& cw) { return cw.bits; }
+template <int W>
+inline uint64_t waveform_value(const sc_uint<W>& value) { return value.to_uint64(); }
+
+SC_MODULE(waveform_capture) {
+    sc_in<bool> clk;
+
+    waveform_window_t window;
+
+    // Probes in VCD order, call before the simulation starts
+    template <typename T>
+    void add(const sc_signal_in_if<T>& signal, const std::string& name, int width) {
+        probes.emplace_back(new signal_probe<T>(signal, name, width));
+        if (name == "pc") {
+            pc_probe = probes.back().get();
+        }
+    }
+
+    // Deepest pre-trigger ring, a few hundred MB with all cpu signals
+    static constexpr uint64_t MAX_PRE_CYCLES = 1000000;
+
+    // False if the file cannot be created or pre_cycles is above MAX_PRE_CYCLES
+    bool open(const std::string& path);
+    void trigger();
+    bool opened() const { return state != ARMED; }
+    uint64_t samples_written() const { return written; }
+
+    SC_CTOR(waveform_capture) {
+        SC_METHOD(sample);
+        sensitive << clk.neg();
+        dont_initialize();
+    }
+    ~waveform_capture();
+
+private:
+    struct probe_base {
+        std::string name;
+        int width;
+        probe_base(const std::string& name, int width) : name(name), width(width) {}
+        virtual ~probe_base() {}
+        virtual uint64_t read() const = 0;
+    };
+    template <typename T>
+    struct signal_probe : probe_base {
+        const sc_signal_in_if<T>& signal;
+        signal_probe(const sc_signal_in_if<T>& signal, const std::string& name, int width)
+            : probe_base(name, width), signal(signal) {}
+        uint64_t read() const override { return waveform_value(signal.read()); }
+    };
+
+    enum state_t { ARMED, OPEN, CLOSED };
+
+    std::vector<std::unique_ptr<probe_base>> probes;
+    const probe_base* pc_probe = nullptr;
+    std::ofstream vcd;
+    state_t state = ARMED;
+    bool triggered = false;
+    uint64_t close_cycle = UINT64_MAX;
+    uint64_t written = 0;
+
+    // Pre-window samples, ring of pre_cycles entries of probes.size() values
+    std::vector<uint64_t> ring;
+    std::vector<uint64_t> ring_time;
+    size_t ring_next = 0, ring_used = 0;
+
+    std::vector<uint64_t> current, last; // this cycle's and the last written values
+
+    void sample();
+    bool opens(uint64_t cycle) const;
+    void open_window(uint64_t cycle);
+    void write_header();
+    void write_sample(uint64_t time_ns, const uint64_t* values);
+};
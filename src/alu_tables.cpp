@@ -0,0 +1,54 @@
+#include "alu_tables.h"
+#include <memory>
+
+// Same computation as the switch in alu::process
+static alu_result_t compute(unsigned op, unsigned a, unsigned b, unsigned carry) {
+    unsigned res = 0;
+    bool c = false, v = false;
+    switch (op) {
+        case ALU_ADC: {
+            unsigned tmp = a + b + carry;
+            res = tmp & 0xFF;
+            c = tmp & 0x100;
+            v = (~(a ^ b) & (a ^ res)) & 0x80;
+            break;
+        }
+        case ALU_SBC: {
+            unsigned tmp = (a - b - (1 - carry)) & 0x1FF;
+            res = tmp & 0xFF;
+            c = !(tmp & 0x100);
+            v = ((a ^ b) & (a ^ res)) & 0x80;
+            break;
+        }
+        case ALU_INC: res = (a + 1) & 0xFF; break;
+        case ALU_DEC: res = (a - 1) & 0xFF; break;
+        case ALU_ASL: res = (a << 1) & 0xFF; c = a & 0x80; break;
+        case ALU_LSR: res = a >> 1; c = a & 0x01; break;
+        case ALU_ROL: res = ((a << 1) | carry) & 0xFF; c = a & 0x80; break;
+        case ALU_ROR: res = (a >> 1) | (carry << 7); c = a & 0x01; break;
+        default: break;
+    }
+    uint8_t flags = (res & FLAG_N) | (res == 0 ? FLAG_Z : 0) | (c ? FLAG_C : 0) | (v ? FLAG_V : 0);
+    return alu_result_t{ (uint8_t)res, flags };
+}
+
+static const alu_tables_t* build_tables() {
+    alu_tables_t* tables = new alu_tables_t;
+    for (unsigned carry = 0; carry < 2; ++carry) {
+        for (unsigned a = 0; a < 256; ++a) {
+            for (unsigned b = 0; b < 256; ++b) {
+                tables->adc[carry][a][b] = compute(ALU_ADC, a, b, carry);
+                tables->sbc[carry][a][b] = compute(ALU_SBC, a, b, carry);
+            }
+            for (unsigned op = ALU_INC; op <= ALU_ROR; ++op) {
+                tables->unary[op - ALU_INC][carry][a] = compute(op, a, 0, carry);
+            }
+        }
+    }
+    return tables;
+}
+
+const alu_tables_t& alu_tables() {
+    static const std::unique_ptr<const alu_tables_t> tables(build_tables());
+    return *tables;
+}
@@ -0,0 +1,123 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const size_t PAGE_SIZE = 256;
+static const size_t PAGES = 65536 / PAGE_SIZE;
+
+std::vector<uint8_t> write_checkpoint(const checkpoint_state_t& state, const uint8_t* mem) {
+    checkpoint_header_t header;
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.state_size = sizeof(checkpoint_state_t);
+
+    uint8_t page_map[PAGES / 8] = {};
+    size_t stored = 0;
+    for (size_t page = 0; page < PAGES; ++page) {
+        const uint8_t* bytes = mem + page * PAGE_SIZE;
+        if (std::any_of(bytes, bytes + PAGE_SIZE, [](uint8_t b) { return b != 0; })) {
+            page_map[page / 8] |= 1 << (page % 8);
+            stored++;
+        }
+    }
+
+    std::vector<uint8_t> out(sizeof(header) + sizeof(state) + sizeof(page_map) + stored * PAGE_SIZE);
+    uint8_t* p = out.data();
+    std::memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    std::memcpy(p, &state, sizeof(state));
+    p += sizeof(state);
+    std::memcpy(p, page_map, sizeof(page_map));
+    p += sizeof(page_map);
+    for (size_t page = 0; page < PAGES; ++page) {
+        if (page_map[page / 8] & (1 << (page % 8))) {
+            std::memcpy(p, mem + page * PAGE_SIZE, PAGE_SIZE);
+            p += PAGE_SIZE;
+        }
+    }
+    return out;
+}
+
+bool parse_checkpoint(const uint8_t* data, size_t length, checkpoint_state_t& state, uint8_t* mem,
+                      std::string& error) {
+    checkpoint_header_t header;
+    if (length < sizeof(header)) {
+        error = "truncated checkpoint";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not a checkpoint";
+        return false;
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        error = "unsupported checkpoint version " + std::to_string(header.version);
+        return false;
+    }
+    size_t offset = sizeof(header);
+    if (length - offset < header.state_size + PAGES / 8) {
+        error = "truncated checkpoint";
+        return false;
+    }
+    const uint8_t* page_map = data + offset + header.state_size;
+    size_t stored = 0;
+    for (size_t i = 0; i < PAGES / 8; ++i) {
+        for (uint8_t bits = page_map[i]; bits; bits &= bits - 1) {
+            stored++;
+        }
+    }
+    if (length - offset - header.state_size - PAGES / 8 < stored * PAGE_SIZE) {
+        error = "truncated checkpoint";
+        return false;
+    }
+
+    // Fields this reader does not know are skipped, missing ones read as zero
+    state = checkpoint_state_t();
+    std::memcpy(&state, data + offset, std::min<size_t>(header.state_size, sizeof(state)));
+    const uint8_t* bytes = page_map + PAGES / 8;
+    for (size_t page = 0; page < PAGES; ++page) {
+        if (page_map[page / 8] & (1 << (page % 8))) {
+            std::memcpy(mem + page * PAGE_SIZE, bytes, PAGE_SIZE);
+            bytes += PAGE_SIZE;
+        } else {
+            std::memset(mem + page * PAGE_SIZE, 0, PAGE_SIZE);
+        }
+    }
+    return true;
+}
+
+bool save_checkpoint_file(const std::string& path, const checkpoint_state_t& state, const uint8_t* mem,
+                          std::string& error) {
+    std::vector<uint8_t> contents = write_checkpoint(state, mem);
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "Cannot create checkpoint: " + path;
+        return false;
+    }
+    bool ok = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    ok &= std::fclose(file) == 0;
+    if (!ok) {
+        error = "Cannot write checkpoint: " + path;
+    }
+    return ok;
+}
+
+bool load_checkpoint_file(const std::string& path, checkpoint_state_t& state, uint8_t* mem, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "Cannot open checkpoint: " + path;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    std::vector<uint8_t> contents(size > 0 ? size : 0);
+    bool ok = size >= 0 && std::fread(contents.data(), 1, contents.size(), file) == contents.size();
+    std::fclose(file);
+    if (!ok) {
+        error = "Cannot read checkpoint: " + path;
+        return false;
+    }
+    return parse_checkpoint(contents.data(), contents.size(), state, mem, error);
+}
@@ -1,84 +1,64 @@
 #include "cpu.h"
 
+// Addressing mode as seen by the fetch/execute FSM for every ISA mode.
+// Branches and accumulator shifts have no operand fetch, JMP (ind) fetches
+// its address like an absolute instruction.
+static const cpu::addressing_mode_t fsm_mode[] = {
+	cpu::IMPLIED,     // AM_IMP
+	cpu::IMPLIED,     // AM_ACC
+	cpu::IMMEDIATE,   // AM_IMM
+	cpu::ZERO_PAGE,   // AM_ZP
+	cpu::ZERO_PAGE_X, // AM_ZPX
+	cpu::ZERO_PAGE_Y, // AM_ZPY
+	cpu::ABSOLUTE,    // AM_ABS
+	cpu::ABSOLUTE_X,  // AM_ABSX
+	cpu::ABSOLUTE_Y,  // AM_ABSY
+	cpu::ABSOLUTE,    // AM_IND
+	cpu::INDIRECT_X,  // AM_INDX
+	cpu::INDIRECT_Y,  // AM_INDY
+	cpu::IMPLIED      // AM_REL
+};
+
+// Bytes the FSM steps over. It has no branch logic (control_rom has no rule
+// for the PC of a branch), so a branch moves the PC past its opcode only, as
+// before opcode_table existed, not past its 2 ISA bytes.
+static int fsm_length(const opcode_info_t& info) {
+	return info.mode == AM_REL ? 1 : info.length;
+}
+
+// 6502 reset: PC from the vector at $FFFC (low) / $FFFD (high), read without a bus cycle
+uint16_t cpu::reset_vector() const {
+	return memory_i->mem[0xFFFC] | memory_i->mem[0xFFFD] << 8;
+}
+
 // Helper functions for addressing modes and instruction lengths
-cpu::addressing_mode_t cpu::get_addressing_mode(sc_uint<8> opcode) {
-    switch (opcode) {
-        // Immediate
-        case 0xA9: case 0xA2: case 0xA0: case 0x29: case 0x09: case 0x49: case 0x69: case 0xE9: case 0xC9: case 0xE0: case 0xC0:
-            return IMMEDIATE;
-        
-        // Zero Page
-        case 0xA5: case 0xA6: case 0xA4: case 0x85: case 0x86: case 0x84: case 0x25: case 0x05: case 0x45: case 0x65: case 0xE5:
-        case 0xC5: case 0xE4: case 0xC4: case 0x06: case 0x46: case 0x26: case 0x66: case 0xE6: case 0xC6:
-            return ZERO_PAGE;
-            
-        // Zero Page,X
-        case 0xB5: case 0x95: case 0x35: case 0x15: case 0x55: case 0x75: case 0xF5: case 0xD5: case 0x16: case 0x56:
-        case 0x36: case 0x76: case 0xF6: case 0xD6: case 0x94:
-            return ZERO_PAGE_X;
-            
-        // Zero Page,Y
-        case 0xB6: case 0x96: case 0xB4:
-            return ZERO_PAGE_Y;
-            
-        // Absolute
-        case 0xAD: case 0xAE: case 0xAC: case 0x8D: case 0x8E: case 0x8C: case 0x2D: case 0x0D: case 0x4D: case 0x6D:
-        case 0xED: case 0xCD: case 0xEC: case 0xCC: case 0x0E: case 0x4E: case 0x2E: case 0x6E: case 0xEE: case 0xCE:
-        case 0x20: case 0x4C: case 0x6C:
-            return ABSOLUTE;
-            
-        // Absolute,X
-        case 0xBD: case 0x9D: case 0x3D: case 0x1D: case 0x5D: case 0x7D: case 0xFD: case 0xDD: case 0x1E: case 0x5E:
-        case 0x3E: case 0x7E: case 0xFE: case 0xDE: case 0xBC:
-            return ABSOLUTE_X;
-            
-        // Absolute,Y
-        case 0xB9: case 0x99: case 0x39: case 0x19: case 0x59: case 0x79: case 0xF9: case 0xD9: case 0xBE:
-            return ABSOLUTE_Y;
-            
-        // (Zero Page,X)
-        case 0xA1: case 0x81: case 0x21: case 0x01: case 0x41: case 0x61: case 0xE1: case 0xC1:
-            return INDIRECT_X;
-            
-        // (Zero Page),Y
-        case 0xB1: case 0x91: case 0x31: case 0x11: case 0x51: case 0x71: case 0xF1: case 0xD1:
-            return INDIRECT_Y;
-
-        // Implied (all others)
-        default:
-            return IMPLIED;
-    }
-}
-
-int cpu::get_instruction_length(sc_uint<8> opcode) {
-    addressing_mode_t mode = get_addressing_mode(opcode);
-    switch (mode) {
-        case IMPLIED: return 1;
-        case IMMEDIATE: case ZERO_PAGE: case ZERO_PAGE_X: case ZERO_PAGE_Y: 
-        case INDIRECT_X: case INDIRECT_Y: return 2;
-        case ABSOLUTE: case ABSOLUTE_X: case ABSOLUTE_Y: return 3;
-        default: return 1;
-    }
-}
-
-bool cpu::needs_operand(sc_uint<8> opcode) {
-    return get_addressing_mode(opcode) != IMPLIED;
-}
-
-bool cpu::is_store_instruction(sc_uint<8> opcode) {
-    // Instructions STA, STX, STY do not read operand from memory,
-    // they only write to memory at the calculated address
-    switch (opcode) {
-        // STA variants
-        case 0x85: case 0x95: case 0x8D: case 0x9D: case 0x99: case 0x81: case 0x91:
-        // STX variants  
-        case 0x86: case 0x96: case 0x8E:
-        // STY variants
-        case 0x84: case 0x94: case 0x8C:
-            return true;
-        default:
-            return false;
-    }
+cpu::addressing_mode_t cpu::get_addressing_mode(cpu_word_t opcode) {
+	return fsm_mode[opcode_table[opcode].mode];
+}
+
+int cpu::get_instruction_length(cpu_word_t opcode) {
+	return fsm_length(opcode_table[opcode]);
+}
+
+bool cpu::needs_operand(cpu_word_t opcode) {
+	return get_addressing_mode(opcode) != IMPLIED;
+}
+
+bool cpu::is_store_instruction(cpu_word_t opcode) {
+	// Instructions STA, STX, STY do not read operand from memory,
+	// they only write to memory at the calculated address
+	return opcode_table[opcode].flags & OPC_STORE;
+}
+
+control_word_t cpu::current_control() {
+	if (model == BUNDLED_CONTROL) {
+		return control_word.read();
+	}
+	control_word_t cw;
+	cw.set(CW_ALU_OP, alu_op.read()).set(CW_ALU_ENABLE, alu_enable.read())
+	  .set(CW_REG_WE, reg_we.read()).set(CW_REG_SEL, reg_w_addr.read())
+	  .set(CW_PC_INC, pc_inc.read()).set(CW_PC_LOAD, pc_load.read());
+	return cw;
 }
 
 
@@ -89,14 +69,23 @@ void cpu::fetch_execute() {
 	
 	if (reset.read()) {
 		state = FETCH;
-		pc_val = 0x0000;
+		pc_val = reset_vector();
 		ir_val = 0x00;
+		ir_info = &opcode_table[0x00];
+		ir_mode = IMPLIED;
 		operand = 0x00;
 		effective_addr = 0x0000;
 		pc.write(pc_val);
 		ir.write(ir_val);
+		trace_pending_valid = false;
+		brk_reached = false;
+		lockstep_sync = true;
 		return;
 	}
+	if (coverage) {
+		coverage->transition(ir_val, coverage_state, state);
+		coverage_state = state;
+	}
 
 	switch (state) {
 		case FETCH:
@@ -107,6 +96,12 @@ void cpu::fetch_execute() {
 			
 		case WAIT_INSTRUCTION:
 			// Wait for one cycle to read instruction from memory
+			if (trace_pending_valid) {
+				trace_commit();
+			}
+			if (lockstep) {
+				lockstep_retire(1);
+			}
 			state = DECODE;
 			break;
 			
@@ -115,18 +110,37 @@ void cpu::fetch_execute() {
 			ir_val = mem_r_data.read();
 			ir.write(ir_val);
 			opcode.write(ir_val);
-			std::cout << "DECODE: Fetch instruction 0x" << std::hex << (int)ir_val << " from address 0x" << (int)pc_val << std::endl;
+			CPU_TRACE(TRACE_FETCH, TRACE_DEBUG, "DECODE: Fetch instruction 0x" << std::hex << (int)ir_val << " from address 0x" << (int)pc_val);
+
+			if (trace_file && !brk_reached) {
+				trace_decode();
+			}
 
 			// Check BRK instruction (halt)
 			if (ir_val == 0x00) {
-				std::cout << "CPU: BRK - simulation stopped" << std::endl;
+				if (!brk_reached) {
+					if (trace_file) {
+						ir_mode = IMPLIED;
+						trace_retire();
+						trace_commit();
+					}
+					if (lockstep) {
+						lockstep_retire(1);
+					}
+					memory_i->flush_io();
+					brk_reached = true;
+					brk_event.notify(SC_ZERO_TIME);
+				}
+				CPU_TRACE(TRACE_DECODE, TRACE_INFO, "CPU: BRK - simulation stopped");
 				//sc_stop(); //comment for running cpu_tb tests
 				return;
 			}
 			
-			addressing_mode_t mode = get_addressing_mode(ir_val);
+			// Decode once, later states use ir_info/ir_mode
+			ir_info = &opcode_table[ir_val];
+			ir_mode = fsm_mode[ir_info->mode];
 			
-			switch (mode) {
+			switch (ir_mode) {
 				case IMPLIED:
 					// Instructions without operands (TAX, PHA, etc.)
 					state = EXECUTE;
@@ -178,8 +192,8 @@ void cpu::fetch_execute() {
 			
 		case PROCESS_ADDR_LOW: {
 			// Fetch first byte of address (LSB for absolute, only byte for zero page)
-			sc_uint<8> addr_low = mem_r_data.read();
-			addressing_mode_t mode = get_addressing_mode(ir_val);
+			cpu_word_t addr_low = mem_r_data.read();
+			addressing_mode_t mode = ir_mode;
 			//std::cout << "PROCESS_ADDR_LOW: Fetched addr_low=0x" << std::hex << (int)addr_low << " mode=" << mode << std::endl;
 
 			if (mode == ABSOLUTE || mode == ABSOLUTE_X || mode == ABSOLUTE_Y) {
@@ -218,8 +232,8 @@ void cpu::fetch_execute() {
 		}
 			
 		case PROCESS_ADDR_HIGH: {
-			sc_uint<8> addr_high = mem_r_data.read();
-			addressing_mode_t mode = get_addressing_mode(ir_val);
+			cpu_word_t addr_high = mem_r_data.read();
+			addressing_mode_t mode = ir_mode;
 			//std::cout << "PROCESS_ADDR_HIGH: Fetched addr_high=0x" << std::hex << (int)addr_high << " mode=" << mode << std::endl;
 			
 			if (mode == ABSOLUTE || mode == ABSOLUTE_X || mode == ABSOLUTE_Y) {
@@ -243,28 +257,29 @@ void cpu::fetch_execute() {
 			break;
 		}
 		case EXECUTE: {
-			addressing_mode_t mode = get_addressing_mode(ir_val);
+			addressing_mode_t mode = ir_mode;
 			
 			// Fetch operand if needed (does not apply to STORE instructions)
-			if (needs_operand(ir_val) && !is_store_instruction(ir_val)) {
+			if (mode != IMPLIED && !(ir_info->flags & OPC_STORE)) {
 				if (mode == IMMEDIATE || mode == ZERO_PAGE || mode == ZERO_PAGE_X || mode == ZERO_PAGE_Y ||
 					mode == ABSOLUTE || mode == ABSOLUTE_X || mode == ABSOLUTE_Y) {
 					operand = mem_r_data.read();
-					std::cout << "EXECUTE: Fetched operand 0x" << std::hex << (int)operand << " from address 0x" << (int)effective_addr << std::endl;
+					CPU_TRACE(TRACE_FETCH, TRACE_DEBUG, "EXECUTE: Fetched operand 0x" << std::hex << (int)operand << " from address 0x" << (int)effective_addr);
 				}
 			}
 			
 			// Execute actions based on control_unit signals
-			std::cout << "EXECUTE: reg_we=" << reg_we.read() << ", reg_w_addr=" << (int)reg_w_addr.read() << std::endl;
+			control_word_t cw = current_control();
+			CPU_TRACE(TRACE_DECODE, TRACE_VERBOSE, "EXECUTE: reg_we=" << cw.reg_we() << ", reg_w_addr=" << (int)cw.reg_sel());
 			
 			// Prepare ALU if needed (before writing to register)
-			if (alu_enable.read()) {
+			if (cw.alu_enable()) {
 				// NOTE: we cannot write to reg_r_addr - it is controlled by control_unit
 				bool carry_flag = alu_carry_in.read() != 0;
 
 				// Set ALU parameters
 				// For MOV operations (LDA/LDX/LDY), pass operand through ALU input 'a'
-				if (alu_op.read() == 0xB) {
+				if (cw.alu_op() == 0xB) {
 					alu_a.write(operand);       // For MOV: pass operand through 'a' input
 					alu_b.write(0);             // 'b' is unused for MOV
 				} else {
@@ -273,19 +288,19 @@ void cpu::fetch_execute() {
 				}
 				alu_carry_in.write(carry_flag ? 1 : 0);  // Use true Carry flag
 
-				std::cout << "EXECUTE: Setting ALU - A=0x" << std::hex << (int)alu_a.read()
-				          << " op=0x" << (int)alu_op.read() << " operand=0x" << (int)operand << std::endl;
+				CPU_TRACE(TRACE_ALU, TRACE_DEBUG, "EXECUTE: Setting ALU - A=0x" << std::hex << (int)alu_a.read()
+				          << " op=0x" << (int)cw.alu_op() << " operand=0x" << (int)operand);
 
 				// Wait for one cycle to compute ALU
 				state = WAIT_ALU;
 				break;
 			}
 			
-			if (reg_we.read()) {
+			if (cw.reg_we()) {
 				// Determine what to write to register
-				sc_uint<8> data_to_write;
+				cpu_word_t data_to_write;
 				
-				if (alu_enable.read()) {
+				if (cw.alu_enable()) {
 					// Use ALU result (for ADC, AND, ORA, EOR, SBC, CMP)
 					data_to_write = alu_result.read();
 					//std::cout << "EXECUTE: Using ALU result = 0x" << std::hex << (int)data_to_write << std::endl;
@@ -296,64 +311,72 @@ void cpu::fetch_execute() {
 				}
 				
 				reg_w_data.write(data_to_write);
-				std::cout << "EXECUTE: Writing 0x" << std::hex << (int)data_to_write << " to register " << (int)reg_w_addr.read() << std::endl;
+				CPU_TRACE(TRACE_REGFILE, TRACE_DEBUG, "EXECUTE: Writing 0x" << std::hex << (int)data_to_write << " to register " << (int)cw.reg_sel());
 
 				// Update tracked A register value
-				if (reg_w_addr.read() == 0) {
+				if (cw.reg_sel() == 0) {
 					reg_a_val = data_to_write;
 				}
 			}
 			
 			// Handle memory write (for STORE instructions)
-			if (is_store_instruction(ir_val)) {
+			if (ir_info->flags & OPC_STORE) {
 				// CPU controls mem_we for STORE instructions
-				sc_uint<8> data_to_store = reg_r_data.read(); // reg_r_addr is already set by control_unit
+				cpu_word_t data_to_store = reg_r_data.read(); // reg_r_addr is already set by control_unit
 
 				mem_we.write(true);       // CPU enables memory write
 				mem_w_data.write(data_to_store);
-				std::cout << "EXECUTE: STORE - Writing 0x" << std::hex << (int)data_to_store << " to address 0x" << (int)effective_addr << std::endl;
+				CPU_TRACE(TRACE_MEMORY, TRACE_DEBUG, "EXECUTE: STORE - Writing 0x" << std::hex << (int)data_to_store << " to address 0x" << (int)effective_addr);
 			}
 			
 			// Update PC
-			int instr_length = get_instruction_length(ir_val);
-			if (pc_load.read()) {
+			int instr_length = fsm_length(*ir_info);
+			if (cw.pc_load()) {
 				pc_val = pc_new.read();
-			} else if (pc_inc.read()) {
+			} else if (cw.pc_inc()) {
 				pc_val = pc_val + instr_length;
 			}
 			pc.write(pc_val);
 			//std::cout << "EXECUTE: New PC = 0x" << std::hex << (int)pc_val << std::endl;
+			if (trace_file) {
+				trace_retire();
+			}
 			
 			state = FETCH;
 			break;
 		}
 		
 		case WAIT_ALU: {
+			control_word_t cw = current_control();
+
 			// ALU has correct parameters, we can read the result
 			//std::cout << "WAIT_ALU: ALU result=0x" << std::hex << (int)alu_result.read() << std::endl;
 
-			if (reg_we.read()) {
-				sc_uint<8> data_to_write = alu_result.read();
+			if (cw.reg_we()) {
+				cpu_word_t data_to_write = alu_result.read();
 				//std::cout << "WAIT_ALU: Using ALU result = 0x" << std::hex << (int)data_to_write << std::endl;
 
 				reg_w_data.write(data_to_write);
-				//std::cout << "WAIT_ALU: Writing 0x" << std::hex << (int)data_to_write << " to register " << (int)reg_w_addr.read() << std::endl;
+				//std::cout << "WAIT_ALU: Writing 0x" << std::hex << (int)data_to_write << " to register " << (int)cw.reg_sel() << std::endl;
 
 				// Update tracked A register value
-				if (reg_w_addr.read() == 0) {
+				if (cw.reg_sel() == 0) {
 					reg_a_val = data_to_write;
 				}
 			}
 			
 			// Update PC
-			int instr_length = get_instruction_length(ir_val);
-			if (pc_load.read()) {
+			int instr_length = fsm_length(*ir_info);
+			if (cw.pc_load()) {
 				pc_val = pc_new.read();
-			} else if (pc_inc.read()) {
+			} else if (cw.pc_inc()) {
 				pc_val = pc_val + instr_length;
 			}
 			pc.write(pc_val);
 			//std::cout << "WAIT_ALU: New PC = 0x" << std::hex << (int)pc_val << std::endl;
+			if (trace_file) {
+				trace_retire();
+			}
 			
 			state = FETCH;
 			break;
@@ -361,9 +384,383 @@ void cpu::fetch_execute() {
 	}
 }
 
+// --- Waveforms ---
+
+void cpu::trace_signals(sc_trace_file* tf) {
+#define CPU_SC_TRACE(signal, bits) sc_trace(tf, signal, std::string(name()) + "." #signal);
+	CPU_WAVEFORM_SIGNALS(CPU_SC_TRACE)
+#undef CPU_SC_TRACE
+}
+
+void cpu::add_waveform_probes(waveform_capture& capture) {
+#define CPU_WAVEFORM_PROBE(signal, bits) capture.add(signal, #signal, bits);
+	CPU_WAVEFORM_SIGNALS(CPU_WAVEFORM_PROBE)
+#undef CPU_WAVEFORM_PROBE
+}
+
+// --- Coverage ---
+
+void cpu::set_coverage(cpu_coverage* map) {
+	coverage = map;
+	control_unit_i->coverage = map;
+}
+
+// --- Lockstep ---
+
+void cpu::set_lockstep(lockstep_checker* checker) {
+	lockstep = checker;
+	memory_i->lockstep = checker;
+	if (checker) {
+		checker->devices = &memory_i->bus;
+	}
+	lockstep_sync = true;
+}
+
+// Starts the reference after a reset or restore, otherwise n instructions
+// retired since the last call. Registers are read from regfile_i, which the
+// LT models keep in step.
+void cpu::lockstep_retire(uint64_t n) {
+	lockstep_state_t model_state = { (uint16_t)pc_val, (uint8_t)regfile_i->A, (uint8_t)regfile_i->X,
+		(uint8_t)regfile_i->Y, (uint8_t)regfile_i->S, (uint8_t)regfile_i->P };
+	if (lockstep_sync) {
+		lockstep->start(memory_i->mem, model_state);
+		lockstep_sync = false;
+		return;
+	}
+	if (lockstep->started() && !lockstep->retire(model_state, n)) {
+		std::cout << lockstep->report() << std::flush;
+		if (divergence_capture) {
+			divergence_capture->trigger();
+		}
+		sc_stop();
+	}
+}
+
+// --- Binary execution trace ---
+
+void cpu::set_trace_file(trace_file_writer* writer) {
+	trace_file = writer;
+	memory_i->trace_file = writer;
+	trace_pending_valid = false;
+}
+
+void cpu::trace_decode() {
+	trace_pending = {};
+	trace_pending.kind = TRACE_INSTRUCTION;
+	trace_pending.pc = pc_val;
+	trace_pending.opcode = ir_val;
+	trace_pending.operand[0] = memory_i->mem[(uint16_t)(pc_val + 1)];
+	trace_pending.operand[1] = memory_i->mem[(uint16_t)(pc_val + 2)];
+}
+
+void cpu::trace_retire() {
+	trace_pending.cycle = memory::clock_cycle();
+	trace_pending.addr = ir_mode == IMPLIED ? 0 : (uint16_t)effective_addr;
+	trace_pending_valid = true;
+}
+
+void cpu::trace_commit() {
+	trace_pending.a = regfile_i->A;
+	trace_pending.x = regfile_i->X;
+	trace_pending.y = regfile_i->Y;
+	trace_pending.s = regfile_i->S;
+	trace_pending.p = regfile_i->P;
+	trace_file->write(trace_pending);
+	trace_pending_valid = false;
+}
+
+// --- Checkpoints ---
+
+bool cpu::at_instruction_boundary() const {
+	// The LT thread only yields between instructions. The FSM has committed the
+	// last instruction's register and memory writes once it waits for the next opcode.
+	return loosely_timed() || state == WAIT_INSTRUCTION || (brk_reached && state == DECODE);
+}
+
+checkpoint_state_t cpu::checkpoint_state() const {
+	checkpoint_state_t saved = {};
+	saved.cycle = memory::clock_cycle();
+	saved.model = model;
+	saved.state = WAIT_INSTRUCTION;
+	saved.halted = loosely_timed() ? lt_core.halted : brk_reached;
+	saved.ir = ir_val;
+	saved.pc = pc_val;
+	saved.effective_addr = effective_addr;
+	saved.operand = operand;
+	saved.reg_a = reg_a_val;
+	saved.a = regfile_i->A;
+	saved.x = regfile_i->X;
+	saved.y = regfile_i->Y;
+	saved.s = regfile_i->S;
+	saved.p = regfile_i->P;
+	return saved;
+}
+
+void cpu::restore_state(const checkpoint_state_t& saved) {
+	pc_val = saved.pc;
+	ir_val = saved.ir;
+	operand = saved.operand;
+	effective_addr = saved.effective_addr;
+	reg_a_val = saved.reg_a;
+	ir_info = &opcode_table[ir_val];
+	ir_mode = fsm_mode[ir_info->mode];
+	regfile_i->A = saved.a;
+	regfile_i->X = saved.x;
+	regfile_i->Y = saved.y;
+	regfile_i->S = saved.s;
+	regfile_i->P = saved.p;
+	trace_pending_valid = false;
+	lockstep_sync = true;
+
+	if (loosely_timed()) {
+		lt_core.a = saved.a;
+		lt_core.x = saved.x;
+		lt_core.y = saved.y;
+		lt_core.s = saved.s;
+		lt_core.p = saved.p;
+		lt_core.pc = saved.pc;
+		lt_core.halted = saved.halted;
+		lt_resume.notify(SC_ZERO_TIME);
+		return;
+	}
+	// Resume waiting for the opcode at pc. Opcode 0 holds the control unit's
+	// register writes off until DECODE, reg_w_data is still from before the restore.
+	state = WAIT_INSTRUCTION;
+	coverage_state = state;
+	brk_reached = saved.halted;
+	mem_we.write(false);
+	mem_addr.write(pc_val);
+	opcode.write(0x00);
+	pc.write(pc_val);
+	ir.write(ir_val);
+}
+
+bool cpu::save_checkpoint(const std::string& path, std::string& error) const {
+	if (!at_instruction_boundary()) {
+		error = "not at an instruction boundary";
+		return false;
+	}
+	return save_checkpoint_file(path, checkpoint_state(), memory_i->mem, error);
+}
+
+bool cpu::restore_checkpoint(const std::string& path, std::string& error) {
+	checkpoint_state_t saved;
+	if (!load_checkpoint_file(path, saved, memory_i->mem, error)) {
+		return false;
+	}
+	memory_i->contents_replaced();
+	restore_state(saved);
+	return true;
+}
+
+// --- Loosely-timed model ---
+
+// Clock cycles the signal-level FSM spends on one instruction of each addressing mode
+// (FETCH, WAIT_INSTRUCTION, DECODE, operand/address states, EXECUTE, WAIT_ALU)
+static const int lt_mode_cycles[] = {
+	5,  // AM_IMP
+	5,  // AM_ACC
+	6,  // AM_IMM
+	8,  // AM_ZP
+	8,  // AM_ZPX
+	8,  // AM_ZPY
+	10, // AM_ABS
+	10, // AM_ABSX
+	10, // AM_ABSY
+	10, // AM_IND
+	9,  // AM_INDX
+	9,  // AM_INDY
+	5   // AM_REL
+};
+
+// Cost of the n instructions straight from pc, the time of one cached block.
+// Read back from memory after the block ran: a store that rewrites an
+// instruction already executed in its own block times the new opcode.
+static int lt_block_cycles(const uint8_t* mem, uint16_t pc, uint64_t n) {
+	int cycles = 0;
+	for (uint64_t i = 0; i < n; ++i) {
+		const opcode_info_t& info = opcode_table[mem[pc]];
+		cycles += lt_mode_cycles[info.mode];
+		pc += info.length;
+	}
+	return cycles;
+}
+
+void cpu::loosely_timed_thread() {
+	const sc_time clock_period(CPU_CLOCK_PERIOD_NS, SC_NS);
+
+	while (true) {
+		if (reset.read()) {
+			lt_reset();
+			wait(reset.negedge_event());
+			continue;
+		}
+		if (lt_core.halted) {
+			// Stay on BRK until next reset
+			if (decoupled()) {
+				quantum_keeper.sync();
+			}
+			memory_i->flush_io();
+			brk_event.notify(SC_ZERO_TIME);
+			wait(reset.posedge_event() | lt_resume);
+			continue;
+		}
+
+		int cycles = lt_step();
+		if (decoupled()) {
+			quantum_keeper.inc(clock_period * cycles);
+			if (quantum_keeper.need_sync()) {
+				quantum_keeper.sync();
+			}
+		} else {
+			wait(clock_period * cycles, reset.posedge_event());
+		}
+	}
+}
+
+void cpu::set_quantum(const sc_time& q) {
+	quantum = q;
+	tlm_utils::tlm_quantumkeeper::set_global_quantum(q);
+	quantum_keeper.reset();
+}
+
+// Device accesses (port output) are observable, they have to happen at the
+// CPU's local time (start of the instruction), not ahead of the kernel
+void cpu::sync_before_io() {
+	if (decoupled() && quantum_keeper.get_local_time() != SC_ZERO_TIME) {
+		quantum_keeper.sync();
+	}
+}
+
+// --- TLM-2.0 memory access ---
+
+uint8_t lt_memory_bus::transport(tlm::tlm_command command, uint16_t addr, uint8_t data) {
+	tlm::tlm_generic_payload trans;
+	sc_time delay = SC_ZERO_TIME;
+	trans.set_command(command);
+	trans.set_address(addr);
+	trans.set_data_ptr(&data);
+	trans.set_data_length(1);
+	trans.set_streaming_width(1);
+	trans.set_byte_enable_ptr(nullptr);
+	trans.set_dmi_allowed(false);
+	trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+	if (cpu_i->memory_i->is_device(addr)) {
+		cpu_i->sync_before_io();
+	}
+	cpu_i->mem_socket->b_transport(trans, delay);
+	if (trans.is_response_error()) {
+		SC_REPORT_ERROR("cpu", trans.get_response_string().c_str());
+	}
+	if (trans.is_dmi_allowed() && !dmi) {
+		cpu_i->request_dmi();
+	}
+	return data;
+}
+
+bool cpu::request_dmi() {
+	tlm::tlm_generic_payload trans;
+	tlm::tlm_dmi dmi;
+	trans.set_command(tlm::TLM_READ_COMMAND);
+	trans.set_address(0);
+	lt_core.bus.dmi = nullptr;
+	// Only a read grant covering the whole address space replaces the transactions
+	if (mem_socket->get_direct_mem_ptr(trans, dmi) && dmi.is_read_allowed()
+		&& dmi.get_start_address() == 0 && dmi.get_end_address() >= 0xFFFF) {
+		lt_core.bus.dmi = dmi.get_dmi_ptr();
+	}
+	return lt_core.bus.dmi != nullptr;
+}
+
+void cpu::invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end) {
+	(void)start;
+	(void)end;
+	lt_core.bus.dmi = nullptr;
+}
+
+static unsigned debug_transport(cpu& c, tlm::tlm_command command, uint16_t addr, uint8_t* data, unsigned length) {
+	tlm::tlm_generic_payload trans;
+	trans.set_command(command);
+	trans.set_address(addr);
+	trans.set_data_ptr(data);
+	trans.set_data_length(length);
+	trans.set_streaming_width(length);
+	return c.mem_socket->transport_dbg(trans);
+}
+
+unsigned cpu::debug_write(uint16_t addr, const uint8_t* data, unsigned length) {
+	return debug_transport(*this, tlm::TLM_WRITE_COMMAND, addr, const_cast<uint8_t*>(data), length);
+}
+
+unsigned cpu::debug_read(uint16_t addr, uint8_t* data, unsigned length) {
+	return debug_transport(*this, tlm::TLM_READ_COMMAND, addr, data, length);
+}
+
+void cpu::lt_reset() {
+	// Same as the signal-level reset: PC from the reset vector, IR cleared, register file keeps its contents
+	lt_core.reset(reset_vector());
+	quantum_keeper.reset();
+	lt_core.a = regfile_i->A;
+	lt_core.x = regfile_i->X;
+	lt_core.y = regfile_i->Y;
+	lt_core.s = regfile_i->S;
+	lt_core.p = regfile_i->P;
+	pc_val = lt_core.pc;
+	ir_val = 0x00;
+	operand = 0x00;
+	effective_addr = 0x0000;
+	// Memory may have been loaded behind the cache's back
+	block_cache.clear();
+	lockstep_sync = true;
+	if (!lt_core.bus.dmi) {
+		request_dmi();
+	}
+}
+
+int cpu::lt_step() {
+	if (lockstep && lockstep_sync) {
+		lockstep_retire(0); // start from the state before this instruction
+	}
+	ir_val = lt_core.bus.read(lt_core.pc);
+	if (model == BLOCK_CACHED) {
+		// Whole block at once, timed like LOOSELY_TIMED instruction by instruction
+		// With coverage on, blocks run one instruction per step so every
+		// instruction is recorded with its own outcome
+		uint16_t start_pc = lt_core.pc;
+		uint64_t done = lt_core.run_block(block_cache, coverage ? 1 : UINT64_MAX);
+		lt_sync_regfile();
+		if (coverage) {
+			coverage->retire(ir_val, lt_core.p);
+		}
+		if (lockstep) {
+			lockstep_retire(done);
+		}
+		return lt_block_cycles(memory_i->mem, start_pc, done);
+	}
+	lt_core.step();
+	lt_sync_regfile();
+	if (coverage) {
+		coverage->retire(ir_val, lt_core.p);
+	}
+	if (lockstep) {
+		lockstep_retire(1);
+	}
+	return lt_mode_cycles[opcode_table[ir_val].mode];
+}
+
+void cpu::lt_sync_regfile() {
+	regfile_i->A = lt_core.a;
+	regfile_i->X = lt_core.x;
+	regfile_i->Y = lt_core.y;
+	regfile_i->S = lt_core.s;
+	regfile_i->P = lt_core.p;
+	reg_a_val = lt_core.a;
+	pc_val = lt_core.pc;
+}
+
 SC_HAS_PROCESS(cpu);
 
-cpu::cpu(sc_module_name name) : sc_module(name) {
+cpu::cpu(sc_module_name name, cpu_model_t model) : sc_module(name), mem_socket("mem_socket"), model(model) {
 	// Creating submodule instances
 	alu_i = new alu("alu_i");
 	regfile_i = new regfile("regfile_i");
@@ -381,8 +778,21 @@ cpu::cpu(sc_module_name name) : sc_module(name) {
 	alu_i->negative(alu_negative);
 	alu_i->overflow(alu_overflow);
 
+	mem_socket.bind(memory_i->socket);
+	mem_socket.register_invalidate_direct_mem_ptr(this, &cpu::invalidate_direct_mem_ptr);
+	lt_core.bus.cpu_i = this;
+	if (model == BLOCK_CACHED) {
+		memory_i->block_cache = &block_cache;
+	}
+
 	// --- Register file connections ---
-	regfile_i->clk(clk);
+	// In LT mode the submodules only hold state, so their clocked
+	// processes are tied to a clock that never toggles
+	if (loosely_timed()) {
+		regfile_i->clk(lt_idle_clk);
+	} else {
+		regfile_i->clk(clk);
+	}
 	regfile_i->we(reg_we);
 	regfile_i->w_addr(reg_w_addr);
 	regfile_i->w_data(reg_w_data);
@@ -402,14 +812,22 @@ cpu::cpu(sc_module_name name) : sc_module(name) {
 	regfile_i->clear_overflow(clear_overflow);
 
 	// --- Memory connections ---
-	memory_i->clk(clk);
+	if (loosely_timed()) {
+		memory_i->clk(lt_idle_clk);
+	} else {
+		memory_i->clk(clk);
+	}
 	memory_i->we(mem_we);
 	memory_i->addr(mem_addr);
 	memory_i->w_data(mem_w_data);
 	memory_i->r_data(mem_r_data);
 
 	// --- Control unit connections ---
-	control_unit_i->clk(clk);
+	if (loosely_timed()) {
+		control_unit_i->clk(lt_idle_clk);
+	} else {
+		control_unit_i->clk(clk);
+	}
 	control_unit_i->opcode(opcode);
 	control_unit_i->alu_op(alu_op);
 	control_unit_i->alu_enable(alu_enable);
@@ -436,8 +854,20 @@ cpu::cpu(sc_module_name name) : sc_module(name) {
 	control_unit_i->clear_decimal(clear_decimal);
 	control_unit_i->clear_overflow(clear_overflow);
 
-	SC_METHOD(fetch_execute);
-	sensitive << clk.pos();
-	dont_initialize();
+	// Bundled mode: one control word signal instead of the discrete ones above
+	if (model == BUNDLED_CONTROL) {
+		control_unit_i->ctrl(control_word);
+		alu_i->ctrl(control_word);
+		regfile_i->ctrl(control_word);
+	}
+
+	if (loosely_timed()) {
+		// Whole fetch/decode/execute loop in one thread
+		SC_THREAD(loosely_timed_thread);
+	} else {
+		SC_METHOD(fetch_execute);
+		sensitive << clk.pos();
+		dont_initialize();
+	}
 }
 
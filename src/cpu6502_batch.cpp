@@ -0,0 +1,524 @@
+#include "cpu6502_batch.h"
+#include <algorithm>
+#include <cstring>
+
+#if !CPU6502_BATCH_SCALAR && defined(__AVX2__)
+#include <immintrin.h>
+#define CPU6502_BATCH_AVX2 1
+#elif !CPU6502_BATCH_SCALAR && defined(__SSE2__)
+#include <emmintrin.h>
+#define CPU6502_BATCH_SSE2 1
+#endif
+
+namespace {
+
+// One byte per lane, all MAX_LANES lanes. Every backend provides the same
+// operations, the batch kernels below are written once on top of them.
+//     name    AVX2                 SSE2 (two halves)   scalar, per byte
+#define CPU6502_LANES_BINARY(X) \
+    X(add,    _mm256_add_epi8,     _mm_add_epi8,      x + y) \
+    X(sub,    _mm256_sub_epi8,     _mm_sub_epi8,      x - y) \
+    X(and_,   _mm256_and_si256,    _mm_and_si128,     x & y) \
+    X(or_,    _mm256_or_si256,     _mm_or_si128,      x | y) \
+    X(xor_,   _mm256_xor_si256,    _mm_xor_si128,     x ^ y) \
+    X(andnot, _mm256_andnot_si256, _mm_andnot_si128,  ~x & y) \
+    X(eq,     _mm256_cmpeq_epi8,   _mm_cmpeq_epi8,    x == y ? 0xFF : 0) \
+    X(max_u,  _mm256_max_epu8,     _mm_max_epu8,      x > y ? x : y)
+
+#if CPU6502_BATCH_AVX2
+struct lanes_t { __m256i v; };
+
+inline lanes_t load(const uint8_t* p) { return { _mm256_load_si256((const __m256i*)p) }; }
+inline void store(uint8_t* p, lanes_t x) { _mm256_store_si256((__m256i*)p, x.v); }
+inline lanes_t splat(uint8_t b) { return { _mm256_set1_epi8((char)b) }; }
+#define CPU6502_LANES_FN(name, avx2, sse2, scalar) \
+    inline lanes_t name(lanes_t x, lanes_t y) { return { avx2(x.v, y.v) }; }
+CPU6502_LANES_BINARY(CPU6502_LANES_FN)
+#undef CPU6502_LANES_FN
+// No byte shifts in AVX2: shift 16-bit words and drop the bit from the neighbour
+inline lanes_t shr1(lanes_t x) { return { _mm256_and_si256(_mm256_srli_epi16(x.v, 1), _mm256_set1_epi8(0x7F)) }; }
+inline uint32_t movemask(lanes_t x) { return (uint32_t)_mm256_movemask_epi8(x.v); }
+const char* simd_name = "AVX2";
+
+#elif CPU6502_BATCH_SSE2
+struct lanes_t { __m128i lo, hi; };
+
+inline lanes_t load(const uint8_t* p) {
+    return { _mm_load_si128((const __m128i*)p), _mm_load_si128((const __m128i*)(p + 16)) };
+}
+inline void store(uint8_t* p, lanes_t x) {
+    _mm_store_si128((__m128i*)p, x.lo);
+    _mm_store_si128((__m128i*)(p + 16), x.hi);
+}
+inline lanes_t splat(uint8_t b) { return { _mm_set1_epi8((char)b), _mm_set1_epi8((char)b) }; }
+#define CPU6502_LANES_FN(name, avx2, sse2, scalar) \
+    inline lanes_t name(lanes_t x, lanes_t y) { return { sse2(x.lo, y.lo), sse2(x.hi, y.hi) }; }
+CPU6502_LANES_BINARY(CPU6502_LANES_FN)
+#undef CPU6502_LANES_FN
+inline lanes_t shr1(lanes_t x) {
+    __m128i low7 = _mm_set1_epi8(0x7F);
+    return { _mm_and_si128(_mm_srli_epi16(x.lo, 1), low7), _mm_and_si128(_mm_srli_epi16(x.hi, 1), low7) };
+}
+inline uint32_t movemask(lanes_t x) {
+    return (uint32_t)_mm_movemask_epi8(x.lo) | ((uint32_t)_mm_movemask_epi8(x.hi) << 16);
+}
+const char* simd_name = "SSE2";
+
+#else
+struct lanes_t { uint8_t b[cpu6502_batch::MAX_LANES]; };
+
+inline lanes_t load(const uint8_t* p) { lanes_t r; memcpy(r.b, p, sizeof(r.b)); return r; }
+inline void store(uint8_t* p, lanes_t x) { memcpy(p, x.b, sizeof(x.b)); }
+inline lanes_t splat(uint8_t b) { lanes_t r; memset(r.b, b, sizeof(r.b)); return r; }
+#define CPU6502_LANES_FN(name, avx2, sse2, scalar) \
+    inline lanes_t name(lanes_t xs, lanes_t ys) { \
+        lanes_t r; \
+        for (int i = 0; i < cpu6502_batch::MAX_LANES; ++i) { \
+            uint8_t x = xs.b[i], y = ys.b[i]; \
+            r.b[i] = (uint8_t)(scalar); \
+        } \
+        return r; \
+    }
+CPU6502_LANES_BINARY(CPU6502_LANES_FN)
+#undef CPU6502_LANES_FN
+inline lanes_t shr1(lanes_t x) {
+    for (uint8_t& b : x.b) b >>= 1;
+    return x;
+}
+inline uint32_t movemask(lanes_t x) {
+    uint32_t mask = 0;
+    for (int i = 0; i < cpu6502_batch::MAX_LANES; ++i) mask |= (uint32_t)(x.b[i] >> 7) << i;
+    return mask;
+}
+const char* simd_name = "scalar";
+#endif
+
+#undef CPU6502_LANES_BINARY
+
+inline lanes_t not_(lanes_t x) { return xor_(x, splat(0xFF)); }
+inline lanes_t ge_u(lanes_t x, lanes_t y) { return eq(max_u(x, y), x); }  // unsigned x >= y
+inline lanes_t lt_u(lanes_t x, lanes_t y) { return not_(ge_u(x, y)); }
+inline lanes_t shl1(lanes_t x) { return add(x, x); }
+inline lanes_t select(lanes_t mask, lanes_t x, lanes_t y) { return or_(and_(mask, x), andnot(mask, y)); }
+inline lanes_t nz(lanes_t value) {
+    return or_(and_(value, splat(FLAG_N)), and_(eq(value, splat(0)), splat(FLAG_Z)));
+}
+
+// 0xFF in byte i for every bit i of an 8-lane mask
+struct lane_bytes_t {
+    uint8_t bytes[256][8];
+};
+
+constexpr lane_bytes_t make_lane_bytes() {
+    lane_bytes_t table = {};
+    for (int mask = 0; mask < 256; ++mask) {
+        for (int i = 0; i < 8; ++i) {
+            table.bytes[mask][i] = (mask >> i) & 1 ? 0xFF : 0x00;
+        }
+    }
+    return table;
+}
+
+constexpr lane_bytes_t lane_bytes = make_lane_bytes();
+
+inline lanes_t lane_select(uint32_t group) {
+    alignas(32) uint8_t mask[cpu6502_batch::MAX_LANES];
+    for (int i = 0; i < cpu6502_batch::MAX_LANES / 8; ++i) {
+        memcpy(mask + 8 * i, lane_bytes.bytes[(group >> (8 * i)) & 0xFF], 8);
+    }
+    return load(mask);
+}
+
+inline int lowest_lane(uint32_t lanes) {
+#if defined(__GNUC__)
+    return __builtin_ctz(lanes);
+#else
+    int i = 0;
+    while (!(lanes & 1)) { lanes >>= 1; i++; }
+    return i;
+#endif
+}
+
+inline int lane_count_of(uint32_t lanes) {
+#if defined(__GNUC__)
+    return __builtin_popcount(lanes);
+#else
+    int n = 0;
+    for (; lanes; lanes &= lanes - 1) n++;
+    return n;
+#endif
+}
+
+// How each opcode is executed by the batch
+enum batch_kind_t {
+    BK_SCALAR,  // lane by lane on cpu6502_core: stack, jumps, BRK
+    BK_BRANCH,  // taken when (P & flag) == set
+    BK_FLAG,    // P = (P & ~flag) | set
+    BK_NOP,
+    BK_LDA, BK_LDX, BK_LDY,
+    BK_AND, BK_ORA, BK_EOR, BK_ADC, BK_SBC,
+    BK_CMP, BK_CPX, BK_CPY,
+    BK_TAX, BK_TAY, BK_TSX, BK_TXA, BK_TXS, BK_TYA,
+    BK_STA, BK_STX, BK_STY,
+    BK_INC, BK_DEC,
+    BK_ASL, BK_LSR, BK_ROL, BK_ROR  // on A or memory
+};
+
+struct batch_op_t {
+    uint8_t kind;  // batch_kind_t
+    uint8_t flag;
+    uint8_t set;
+};
+
+struct batch_table_t {
+    batch_op_t op[256];
+    constexpr const batch_op_t& operator[](uint8_t opcode) const { return op[opcode]; }
+};
+
+constexpr batch_op_t make_batch_op(const opcode_info_t& info) {
+    switch (info.mnemonic) {
+        case MN_LDA: return { BK_LDA, 0, 0 };
+        case MN_LDX: return { BK_LDX, 0, 0 };
+        case MN_LDY: return { BK_LDY, 0, 0 };
+        case MN_AND: return { BK_AND, 0, 0 };
+        case MN_ORA: return { BK_ORA, 0, 0 };
+        case MN_EOR: return { BK_EOR, 0, 0 };
+        case MN_ADC: return { BK_ADC, 0, 0 };
+        case MN_SBC: return { BK_SBC, 0, 0 };
+        case MN_CMP: return { BK_CMP, 0, 0 };
+        case MN_CPX: return { BK_CPX, 0, 0 };
+        case MN_CPY: return { BK_CPY, 0, 0 };
+        case MN_TAX: return { BK_TAX, 0, 0 };
+        case MN_TAY: return { BK_TAY, 0, 0 };
+        case MN_TSX: return { BK_TSX, 0, 0 };
+        case MN_TXA: return { BK_TXA, 0, 0 };
+        case MN_TXS: return { BK_TXS, 0, 0 };
+        case MN_TYA: return { BK_TYA, 0, 0 };
+        case MN_STA: return { BK_STA, 0, 0 };
+        case MN_STX: return { BK_STX, 0, 0 };
+        case MN_STY: return { BK_STY, 0, 0 };
+        case MN_INC: return { BK_INC, 0, 0 };
+        case MN_DEC: return { BK_DEC, 0, 0 };
+        case MN_ASL: return { BK_ASL, 0, 0 };
+        case MN_LSR: return { BK_LSR, 0, 0 };
+        case MN_ROL: return { BK_ROL, 0, 0 };
+        case MN_ROR: return { BK_ROR, 0, 0 };
+        case MN_CLC: return { BK_FLAG, FLAG_C, 0 };
+        case MN_SEC: return { BK_FLAG, FLAG_C, FLAG_C };
+        case MN_CLI: return { BK_FLAG, FLAG_I, 0 };
+        case MN_SEI: return { BK_FLAG, FLAG_I, FLAG_I };
+        case MN_CLV: return { BK_FLAG, FLAG_V, 0 };
+        case MN_CLD: return { BK_FLAG, FLAG_D, 0 };
+        case MN_SED: return { BK_FLAG, FLAG_D, FLAG_D };
+        case MN_BPL: return { BK_BRANCH, FLAG_N, 0 };
+        case MN_BMI: return { BK_BRANCH, FLAG_N, FLAG_N };
+        case MN_BVC: return { BK_BRANCH, FLAG_V, 0 };
+        case MN_BVS: return { BK_BRANCH, FLAG_V, FLAG_V };
+        case MN_BCC: return { BK_BRANCH, FLAG_C, 0 };
+        case MN_BCS: return { BK_BRANCH, FLAG_C, FLAG_C };
+        case MN_BNE: return { BK_BRANCH, FLAG_Z, 0 };
+        case MN_BEQ: return { BK_BRANCH, FLAG_Z, FLAG_Z };
+        case MN_NOP: return { BK_NOP, 0, 0 };
+        default:     return { BK_SCALAR, 0, 0 };
+    }
+}
+
+constexpr batch_table_t make_batch_table() {
+    batch_table_t table = {};
+    for (int i = 0; i < 256; ++i) {
+        table.op[i] = make_batch_op(opcode_table[(uint8_t)i]);
+    }
+    return table;
+}
+
+constexpr batch_table_t batch_table = make_batch_table();
+
+static_assert(batch_table[0x69].kind == BK_ADC && batch_table[0x48].kind == BK_SCALAR, "ADC batched, PHA per lane");
+
+} // namespace
+
+cpu6502_batch::cpu6502_batch(int lanes)
+    : lane_count(std::min(std::max(lanes, 1), MAX_LANES)),
+      lane_mask(lane_count == 32 ? 0xFFFFFFFFu : (1u << lane_count) - 1),
+      mem(lane_count * LANE_STRIDE) {
+    memset(opcode, 0, sizeof(opcode));
+    reset();
+    reset_counters();
+}
+
+const char* cpu6502_batch::simd() {
+    return simd_name;
+}
+
+void cpu6502_batch::reset(uint16_t start_pc) {
+    memset(a, 0, sizeof(a));
+    memset(x, 0, sizeof(x));
+    memset(y, 0, sizeof(y));
+    memset(s, 0xFF, sizeof(s));
+    memset(p, FLAG_U, sizeof(p));
+    std::fill(pc, pc + MAX_LANES, start_pc);
+    halted = 0;
+    memset(instructions, 0, sizeof(instructions));
+    memset(cycles, 0, sizeof(cycles));
+}
+
+uint64_t cpu6502_batch::run(uint64_t n) {
+    // Lanes only drop out during a run: count their instructions when they
+    // stop, the rest once at the end
+    uint64_t total = 0;
+    uint64_t k = 0;
+    for (; k < n; ++k) {
+        uint32_t lanes = running();
+        if (!lanes) break;
+        step(lanes);
+        total += lane_count_of(lanes);
+        for (uint32_t stopped = lanes & halted; stopped; stopped &= stopped - 1) {
+            instructions[lowest_lane(stopped)] += k + 1;
+        }
+    }
+    for (uint32_t rest = running(); rest; rest &= rest - 1) {
+        instructions[lowest_lane(rest)] += k;
+    }
+    return total;
+}
+
+// One instruction on every lane in lanes, one group of lanes per distinct opcode
+void cpu6502_batch::step(uint32_t lanes) {
+    for (uint32_t rest = lanes; rest; rest &= rest - 1) {
+        int lane = lowest_lane(rest);
+        opcode[lane] = memory(lane)[pc[lane]];
+    }
+    lanes_t opcodes = load(opcode);
+    uint32_t pending = lanes;
+    while (pending) {
+        uint8_t op = opcode[lowest_lane(pending)];
+        uint32_t group = movemask(eq(opcodes, splat(op))) & pending;
+        pending &= ~group;
+        switch (batch_table[op].kind) {
+            case BK_SCALAR: execute_scalar(group); scalar_groups++; break;
+            case BK_BRANCH: execute_branch(op, group); vector_groups++; break;
+            default:        execute_batched(op, group); vector_groups++; break;
+        }
+    }
+}
+
+// Same effective address as cpu6502_core_t::operand_address, pc at the opcode
+template <int Mode>
+uint16_t cpu6502_batch::operand_address(const uint8_t* m, int lane) {
+    uint16_t at = pc[lane];
+    uint16_t operand = m[(uint16_t)(at + 1)];
+    if (opcode_length(Mode) == 3) operand |= m[(uint16_t)(at + 2)] << 8;
+    switch (Mode) {
+        case AM_IMM:  return at + 1;
+        case AM_ZP:   return operand;
+        case AM_ZPX:  return (uint8_t)(operand + x[lane]);
+        case AM_ZPY:  return (uint8_t)(operand + y[lane]);
+        case AM_ABS:  return operand;
+        case AM_ABSX: return (uint16_t)(operand + x[lane]);
+        case AM_ABSY: return (uint16_t)(operand + y[lane]);
+        case AM_INDX: {
+            uint8_t zp = operand + x[lane];
+            return m[zp] | (m[(uint8_t)(zp + 1)] << 8);
+        }
+        case AM_INDY: {
+            uint8_t zp = operand;
+            return (uint16_t)((m[zp] | (m[(uint8_t)(zp + 1)] << 8)) + y[lane]);
+        }
+        default:      return 0;
+    }
+}
+
+// Operand address and value of every lane in group, steps pc and counts cycles
+template <int Mode>
+void cpu6502_batch::gather(const opcode_info_t& info, uint32_t group, uint16_t* addr, uint8_t* value) {
+    for (uint32_t rest = group; rest; rest &= rest - 1) {
+        int lane = lowest_lane(rest);
+        uint8_t* m = memory(lane);
+        if (Mode != AM_IMP && Mode != AM_ACC) {
+            addr[lane] = operand_address<Mode>(m, lane);
+            value[lane] = m[addr[lane]];
+            if (info.page_penalty && (Mode == AM_ABSX || Mode == AM_ABSY || Mode == AM_INDY)) {
+                uint16_t base = addr[lane] - (Mode == AM_ABSX ? x[lane] : y[lane]);
+                if ((base ^ addr[lane]) & 0xFF00) cycles[lane] += info.page_penalty;
+            }
+        }
+        pc[lane] += info.length;
+        cycles[lane] += info.cycles;
+    }
+}
+
+// Everything but stack and jumps: operands are gathered lane by lane, the
+// operation runs on all lanes and is merged back under the group mask,
+// memory results are scattered back lane by lane
+void cpu6502_batch::execute_batched(uint8_t op, uint32_t group) {
+    const opcode_info_t& info = opcode_table[op];
+    const batch_op_t& batch = batch_table[op];
+    bool rmw = info.flags & OPC_RMW;
+    alignas(32) uint8_t value[MAX_LANES] = {};
+    uint16_t addr[MAX_LANES];
+
+    switch (info.mode) {
+        case AM_IMM:  gather<AM_IMM>(info, group, addr, value); break;
+        case AM_ZP:   gather<AM_ZP>(info, group, addr, value); break;
+        case AM_ZPX:  gather<AM_ZPX>(info, group, addr, value); break;
+        case AM_ZPY:  gather<AM_ZPY>(info, group, addr, value); break;
+        case AM_ABS:  gather<AM_ABS>(info, group, addr, value); break;
+        case AM_ABSX: gather<AM_ABSX>(info, group, addr, value); break;
+        case AM_ABSY: gather<AM_ABSY>(info, group, addr, value); break;
+        case AM_INDX: gather<AM_INDX>(info, group, addr, value); break;
+        case AM_INDY: gather<AM_INDY>(info, group, addr, value); break;
+        default:      gather<AM_IMP>(info, group, addr, value); break;
+    }
+    if (batch.kind == BK_NOP) return;
+
+    lanes_t mask = lane_select(group);
+    lanes_t A = load(a), X = load(x), Y = load(y), S = load(s), P = load(p), V = load(value);
+    if (batch.kind == BK_FLAG) {
+        store(p, select(mask, or_(andnot(splat(batch.flag), P), splat(batch.set)), P));
+        return;
+    }
+    if (batch.kind == BK_STA || batch.kind == BK_STX || batch.kind == BK_STY) {
+        const uint8_t* reg = batch.kind == BK_STA ? a : batch.kind == BK_STX ? x : y;
+        for (uint32_t rest = group; rest; rest &= rest - 1) {
+            int lane = lowest_lane(rest);
+            memory(lane)[addr[lane]] = reg[lane];
+        }
+        return;
+    }
+    // Shifts and rotates work on A in accumulator mode, on memory otherwise
+    lanes_t operand = rmw ? V : A;
+
+    lanes_t res = splat(0);
+    lanes_t flags = splat(0);          // C and V of the result
+    uint8_t changed = FLAG_N | FLAG_Z; // flags written by the opcode
+    uint8_t* target = rmw ? nullptr : a; // register receiving res, nullptr for compares and memory
+    switch (batch.kind) {
+        case BK_LDA: res = V; break;
+        case BK_LDX: res = V; target = x; break;
+        case BK_LDY: res = V; target = y; break;
+        case BK_AND: res = and_(A, V); break;
+        case BK_ORA: res = or_(A, V); break;
+        case BK_EOR: res = xor_(A, V); break;
+        case BK_ADC: {
+            // Same carry/overflow rules as alu::process: C from bit 8 of a + b + c,
+            // V when both operands have the same sign and the result does not
+            lanes_t sum = add(A, V);
+            lanes_t carry = lt_u(sum, A);
+            res = add(sum, and_(P, splat(FLAG_C)));
+            carry = or_(carry, lt_u(res, sum));
+            lanes_t overflow = andnot(xor_(A, V), xor_(A, res));
+            flags = or_(and_(carry, splat(FLAG_C)), and_(shr1(overflow), splat(FLAG_V)));
+            changed |= FLAG_C | FLAG_V;
+            break;
+        }
+        case BK_SBC: {
+            // C clear when a - b - (1 - c) borrows
+            lanes_t borrow_in = xor_(and_(P, splat(FLAG_C)), splat(1));
+            lanes_t diff = sub(A, V);
+            lanes_t borrow = lt_u(A, V);
+            res = sub(diff, borrow_in);
+            borrow = or_(borrow, lt_u(diff, borrow_in));
+            lanes_t overflow = and_(xor_(A, V), xor_(A, res));
+            flags = or_(andnot(borrow, splat(FLAG_C)), and_(shr1(overflow), splat(FLAG_V)));
+            changed |= FLAG_C | FLAG_V;
+            break;
+        }
+        case BK_CMP:
+        case BK_CPX:
+        case BK_CPY: {
+            lanes_t reg = batch.kind == BK_CMP ? A : batch.kind == BK_CPX ? X : Y;
+            res = sub(reg, V);
+            flags = and_(ge_u(reg, V), splat(FLAG_C));
+            changed |= FLAG_C;
+            target = nullptr;
+            break;
+        }
+        case BK_TAX: res = A; target = x; break;
+        case BK_TAY: res = A; target = y; break;
+        case BK_TSX: res = S; target = x; break;
+        case BK_TXA: res = X; break;
+        case BK_TXS: res = X; target = s; changed = 0; break;
+        case BK_TYA: res = Y; break;
+        case BK_INC: res = add(V, splat(1)); break;
+        case BK_DEC: res = sub(V, splat(1)); break;
+        case BK_ASL:
+            res = shl1(operand);
+            flags = and_(ge_u(operand, splat(0x80)), splat(FLAG_C));
+            changed |= FLAG_C;
+            break;
+        case BK_LSR:
+            res = shr1(operand);
+            flags = and_(operand, splat(FLAG_C));
+            changed |= FLAG_C;
+            break;
+        case BK_ROL:
+            res = or_(shl1(operand), and_(P, splat(FLAG_C)));
+            flags = and_(ge_u(operand, splat(0x80)), splat(FLAG_C));
+            changed |= FLAG_C;
+            break;
+        case BK_ROR:
+            res = or_(shr1(operand), and_(eq(and_(P, splat(FLAG_C)), splat(FLAG_C)), splat(0x80)));
+            flags = and_(operand, splat(FLAG_C));
+            changed |= FLAG_C;
+            break;
+        default:
+            break;
+    }
+    if (target) {
+        store(target, select(mask, res, load(target)));
+    } else if (rmw) {
+        alignas(32) uint8_t result[MAX_LANES];
+        store(result, res);
+        for (uint32_t rest = group; rest; rest &= rest - 1) {
+            int lane = lowest_lane(rest);
+            memory(lane)[addr[lane]] = result[lane];
+        }
+    }
+    if (changed) {
+        lanes_t new_p = or_(andnot(splat(changed), P), or_(flags, nz(res)));
+        store(p, select(mask, new_p, P));
+    }
+}
+
+// Condition for the whole group at once, the target per lane
+void cpu6502_batch::execute_branch(uint8_t op, uint32_t group) {
+    const opcode_info_t& info = opcode_table[op];
+    const batch_op_t& batch = batch_table[op];
+    uint32_t taken = movemask(eq(and_(load(p), splat(batch.flag)), splat(batch.set))) & group;
+    for (uint32_t rest = group; rest; rest &= rest - 1) {
+        int lane = lowest_lane(rest);
+        uint16_t offset_addr = pc[lane] + 1;
+        pc[lane] += info.length;
+        cycles[lane] += info.cycles;
+        if (taken & (1u << lane)) {
+            uint16_t target = pc[lane] + (int8_t)memory(lane)[offset_addr];
+            cycles[lane] += ((pc[lane] ^ target) & 0xFF00) ? 2 : 1;
+            pc[lane] = target;
+        }
+    }
+}
+
+// Stack, jumps and BRK, one lane at a time
+void cpu6502_batch::execute_scalar(uint32_t group) {
+    for (uint32_t rest = group; rest; rest &= rest - 1) {
+        int lane = lowest_lane(rest);
+        scalar.bus.mem = memory(lane);
+        scalar.a = a[lane];
+        scalar.x = x[lane];
+        scalar.y = y[lane];
+        scalar.s = s[lane];
+        scalar.p = p[lane];
+        scalar.pc = pc[lane];
+        scalar.cycles = cycles[lane];
+        scalar.halted = false;
+        scalar.step();
+        a[lane] = scalar.a;
+        x[lane] = scalar.x;
+        y[lane] = scalar.y;
+        s[lane] = scalar.s;
+        p[lane] = scalar.p;
+        pc[lane] = scalar.pc;
+        cycles[lane] = scalar.cycles;
+        if (scalar.halted) halted |= 1u << lane;
+    }
+}
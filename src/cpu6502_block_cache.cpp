@@ -0,0 +1,62 @@
+#include "cpu6502_block_cache.h"
+#include <algorithm>
+
+// Pages covered by a block, wrapping at the end of the address space
+template <class F>
+static void for_each_page(const cpu6502_block_t& block, F f) {
+    uint8_t page = block.start >> 8;
+    uint8_t last = (uint16_t)(block.start + block.size - 1) >> 8;
+    while (true) {
+        f(page);
+        if (page == last) break;
+        page++;
+    }
+}
+
+cpu6502_block_cache::cpu6502_block_cache() : generation(0), blocks(65536) {
+    reset_counters();
+}
+
+cpu6502_block_t* cpu6502_block_cache::insert(cpu6502_block_t&& block) {
+    uint16_t start = block.start;
+    if (blocks[start]) {
+        remove(start);
+    }
+    blocks[start].reset(new cpu6502_block_t(std::move(block)));
+    for_each_page(*blocks[start], [&](uint8_t page) { page_blocks[page].push_back(start); });
+    return blocks[start].get();
+}
+
+void cpu6502_block_cache::invalidate_page(uint8_t page) {
+    // remove() edits the page lists, work on a copy
+    std::vector<uint16_t> starts = page_blocks[page];
+    for (uint16_t start : starts) {
+        remove(start);
+        invalidations++;
+    }
+    generation++;
+}
+
+void cpu6502_block_cache::remove(uint16_t start) {
+    for_each_page(*blocks[start], [&](uint8_t page) {
+        std::vector<uint16_t>& list = page_blocks[page];
+        list.erase(std::remove(list.begin(), list.end(), start), list.end());
+    });
+    blocks[start].reset();
+}
+
+void cpu6502_block_cache::clear() {
+    for (int page = 0; page < 256; ++page) {
+        for (uint16_t start : page_blocks[page]) {
+            blocks[start].reset();
+        }
+        page_blocks[page].clear();
+    }
+    generation++;
+}
+
+void cpu6502_block_cache::reset_counters() {
+    hits = 0;
+    misses = 0;
+    invalidations = 0;
+}
@@ -0,0 +1,4 @@
+#include "cpu6502_core.h"
+
+// Flat-memory core used by batch tools and tests
+template class cpu6502_core_t<flat_memory_bus>;
@@ -0,0 +1,656 @@
+#include "cpu6502_jit.h"
+#include <cstring>
+#include <vector>
+#include "opcode_table.h"
+
+#if CPU6502_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Worst case code for one guest instruction with its exits, plus the block
+// prologue. The arena is flushed when a block might not fit.
+static const size_t MAX_INSN_CODE = 320;
+static const size_t MAX_BLOCK_CODE = cpu6502_block_cache::MAX_BLOCK_INSNS * MAX_INSN_CODE + 256;
+
+#if CPU6502_JIT
+
+namespace {
+
+enum host_reg_t {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R12 = 12, R13 = 13, R14 = 14, R15 = 15,
+    NO_INDEX = -1
+};
+
+// Register use of the translated code:
+//   rbx  core             r12  guest memory
+//   r13  A   r14  X   r15  Y   (zero-extended bytes)
+//   rbp  last N/Z result while the N/Z bits of P are stale
+//   rax, rcx, rdx, rsi, rdi scratch
+//   [rsp]   instructions of the loop iterations already done
+//   [rsp+8] instruction budget
+const int REG_CORE = RBX, REG_MEM = R12, REG_A = R13, REG_X = R14, REG_Y = R15, REG_NZ = RBP;
+
+enum alu_t { ALU_ADD = 0, ALU_OR = 1, ALU_ADC = 2, ALU_SBB = 3, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7 };
+enum shift_t { SH_RCL = 2, SH_RCR = 3, SH_SHL = 4, SH_SHR = 5 };
+enum cond_t { CC_O = 0x0, CC_C = 0x2, CC_NC = 0x3, CC_Z = 0x4, CC_NZ = 0x5, CC_A = 0x7, CC_S = 0x8, CC_NS = 0x9 };
+
+// Just the x86-64 encodings the translator needs. Memory operands are always
+// [base + index + disp32] through a SIB byte; byte operations always carry a
+// REX prefix so registers 4-7 mean spl/bpl/sil/dil.
+class x64_emitter {
+public:
+    uint8_t* code;
+    size_t size;
+
+    explicit x64_emitter(uint8_t* code) : code(code), size(0) {}
+
+    void byte(uint8_t b) { code[size++] = b; }
+    void word(uint16_t w) { memcpy(code + size, &w, 2); size += 2; }
+    void dword(uint32_t d) { memcpy(code + size, &d, 4); size += 4; }
+    void qword(uint64_t q) { memcpy(code + size, &q, 8); size += 8; }
+
+    void rex(bool w, int reg, int index, int base, bool force) {
+        uint8_t r = 0x40 | (w << 3) | ((reg >> 3) & 1) << 2 | (((index < 0 ? 0 : index) >> 3) & 1) << 1
+                  | ((base >> 3) & 1);
+        if (r != 0x40 || force) byte(r);
+    }
+    void modrm_mem(int reg, int base, int index, int32_t disp) {
+        byte(0x84 | (reg & 7) << 3);
+        byte((index < 0 ? 4 : index & 7) << 3 | (base & 7));
+        dword(disp);
+    }
+    void modrm_reg(int reg, int rm) { byte(0xC0 | (reg & 7) << 3 | (rm & 7)); }
+
+    // op reg, [base + index + disp]
+    void op_mem(uint8_t op0, int op1, int reg, int base, int index, int32_t disp, bool w, bool byte_op) {
+        rex(w, reg, index, base, byte_op);
+        byte(op0);
+        if (op1 >= 0) byte(op1);
+        modrm_mem(reg, base, index, disp);
+    }
+    // op rm, reg
+    void op_reg(uint8_t op0, int op1, int reg, int rm, bool w, bool byte_op) {
+        rex(w, reg, 0, rm, byte_op);
+        byte(op0);
+        if (op1 >= 0) byte(op1);
+        modrm_reg(reg, rm);
+    }
+
+    void movzx8(int dst, int base, int index, int32_t disp) { op_mem(0x0F, 0xB6, dst, base, index, disp, false, false); }
+    void movzx8_reg(int dst, int src) { op_reg(0x0F, 0xB6, dst, src, false, true); }
+    void movzx16_reg(int dst, int src) { op_reg(0x0F, 0xB7, dst, src, false, false); }
+    void store8(int base, int32_t disp, int src) { op_mem(0x88, -1, src, base, NO_INDEX, disp, false, true); }
+    void store16(int base, int32_t disp, int src) { byte(0x66); op_mem(0x89, -1, src, base, NO_INDEX, disp, false, false); }
+    void store16_imm(int base, int32_t disp, uint16_t imm) {
+        byte(0x66); op_mem(0xC7, -1, 0, base, NO_INDEX, disp, false, false); word(imm);
+    }
+    void mov32(int dst, int src) { op_reg(0x89, -1, src, dst, false, false); }
+    void mov64(int dst, int src) { op_reg(0x89, -1, src, dst, true, false); }
+    void mov32_imm(int dst, uint32_t imm) { rex(false, 0, 0, dst, false); byte(0xB8 + (dst & 7)); dword(imm); }
+    void mov64_imm(int dst, uint64_t imm) { rex(true, 0, 0, dst, false); byte(0xB8 + (dst & 7)); qword(imm); }
+    void lea32(int dst, int base, int32_t disp) { op_mem(0x8D, -1, dst, base, NO_INDEX, disp, false, false); }
+
+    void alu8(alu_t op, int dst, int src) { op_reg(op << 3, -1, src, dst, false, true); }
+    void alu8_imm(alu_t op, int dst, uint8_t imm) { op_reg(0x80, -1, op, dst, false, true); byte(imm); }
+    void alu32(alu_t op, int dst, int src) { op_reg((op << 3) | 1, -1, src, dst, false, false); }
+    void alu32_imm(alu_t op, int dst, uint32_t imm) { op_reg(0x81, -1, op, dst, false, false); dword(imm); }
+    void alu8_mem_imm(alu_t op, int base, int32_t disp, uint8_t imm) {
+        op_mem(0x80, -1, op, base, NO_INDEX, disp, false, false); byte(imm);
+    }
+    void or8_mem(int base, int32_t disp, int src) { op_mem(0x08, -1, src, base, NO_INDEX, disp, false, true); }
+    void add64_mem_imm(int base, int32_t disp, uint32_t imm) {
+        op_mem(0x81, -1, ALU_ADD, base, NO_INDEX, disp, true, false); dword(imm);
+    }
+    void inc8_mem(int base, int32_t disp) { op_mem(0xFE, -1, 0, base, NO_INDEX, disp, false, false); }
+    void dec8_mem(int base, int32_t disp) { op_mem(0xFE, -1, 1, base, NO_INDEX, disp, false, false); }
+    void test8(int a, int b) { op_reg(0x84, -1, b, a, false, true); }
+    void test32(int a, int b) { op_reg(0x85, -1, b, a, false, false); }
+    void test8_mem_imm(int base, int32_t disp, uint8_t imm) {
+        op_mem(0xF6, -1, 0, base, NO_INDEX, disp, false, false); byte(imm);
+    }
+    void shift8_1(shift_t op, int dst) { op_reg(0xD0, -1, op, dst, false, true); }
+    void shl8_imm(int dst, uint8_t imm) { op_reg(0xC0, -1, SH_SHL, dst, false, true); byte(imm); }
+    void shl32_imm(int dst, uint8_t imm) { op_reg(0xC1, -1, SH_SHL, dst, false, false); byte(imm); }
+    void bt32_imm(int dst, uint8_t bit) { op_reg(0x0F, 0xBA, 4, dst, false, false); byte(bit); }
+    void cmc() { byte(0xF5); }
+    void setcc(cond_t cc, int dst) { op_reg(0x0F, 0x90 + cc, 0, dst, false, true); }
+
+    void load64(int dst, int base, int32_t disp) { op_mem(0x8B, -1, dst, base, NO_INDEX, disp, true, false); }
+    void store64(int base, int32_t disp, int src) { op_mem(0x89, -1, src, base, NO_INDEX, disp, true, false); }
+    void add64_from_mem(int dst, int base, int32_t disp) { op_mem(0x03, -1, dst, base, NO_INDEX, disp, true, false); }
+    void cmp64_from_mem(int dst, int base, int32_t disp) { op_mem(0x3B, -1, dst, base, NO_INDEX, disp, true, false); }
+    void add64_imm(int dst, uint32_t imm) { op_reg(0x81, -1, ALU_ADD, dst, true, false); dword(imm); }
+    void store64_imm(int base, int32_t disp, uint32_t imm) {
+        op_mem(0xC7, -1, 0, base, NO_INDEX, disp, true, false); dword(imm);
+    }
+
+    void push(int reg) { rex(false, 0, 0, reg, false); byte(0x50 + (reg & 7)); }
+    void pop(int reg) { rex(false, 0, 0, reg, false); byte(0x58 + (reg & 7)); }
+    void sub_rsp(uint8_t imm) { byte(0x48); byte(0x83); byte(0xEC); byte(imm); }
+    void add_rsp(uint8_t imm) { byte(0x48); byte(0x83); byte(0xC4); byte(imm); }
+    void call(const void* target) { mov64_imm(RAX, (uint64_t)target); byte(0xFF); byte(0xD0); }
+    void ret() { byte(0xC3); }
+
+    // Forward jumps, returns the position of the rel32 to patch()
+    size_t jcc(cond_t cc) { byte(0x0F); byte(0x80 + cc); dword(0); return size - 4; }
+    void jmp_back(size_t target) { byte(0xE9); dword((uint32_t)(int32_t)(target - (size + 4))); }
+    void patch(size_t rel32) { int32_t rel = (int32_t)(size - (rel32 + 4)); memcpy(code + rel32, &rel, 4); }
+};
+
+class translator {
+public:
+    translator(uint8_t* code, const cpu6502_jit_layout_t& layout, cpu6502_block_cache* cache)
+        : e(code), layout(layout), cache(cache), nz_pending(false), cycles(0) {}
+
+    // Returns the code size, 0 when not even the first instruction can be translated
+    size_t translate(const cpu6502_block_t& block) {
+        if (!supported(block.insns[0].opcode)) return 0;
+        start = block.start;
+        length = (uint32_t)block.insns.size();
+        prologue();
+        body = e.size;
+        uint16_t pc = block.start;
+        uint32_t count = 0;
+        for (const cpu6502_decoded_insn_t& insn : block.insns) {
+            if (!supported(insn.opcode)) {
+                // Interpreter takes over at this instruction
+                exit(count, pc);
+                break;
+            }
+            const opcode_info_t& info = opcode_table[insn.opcode];
+            uint16_t next = pc + info.length;
+            cycles += info.cycles;
+            count++;
+            if (!instruction(insn, info, next, count)) {
+                break; // block ended with a jump or branch
+            }
+            pc = next;
+            if (count == block.insns.size()) {
+                exit(count, pc);
+            }
+        }
+        // Exits after stores that invalidated code
+        for (const smc_exit_t& smc : smc_exits) {
+            e.patch(smc.jump);
+            nz_pending = smc.nz_pending;
+            cycles = smc.cycles;
+            exit(smc.count, smc.pc);
+        }
+        return e.size;
+    }
+
+private:
+    struct smc_exit_t {
+        size_t jump;
+        uint32_t count;
+        uint16_t pc;
+        uint64_t cycles;
+        bool nz_pending;
+    };
+
+    x64_emitter e;
+    const cpu6502_jit_layout_t& layout;
+    cpu6502_block_cache* cache;
+    uint16_t start;    // guest pc of the block
+    uint32_t length;   // instructions in the block
+    size_t body;       // code offset of the first instruction, target of loops
+    bool nz_pending;   // N/Z of P are stale, the value is in REG_NZ
+    uint64_t cycles;   // static cycles of the instructions translated so far
+    std::vector<smc_exit_t> smc_exits;
+
+    static bool supported(uint8_t opcode) {
+        const opcode_info_t& info = opcode_table[opcode];
+        return !(info.mnemonic == MN_RTI || info.mnemonic == MN_BRK || info.mode == AM_IND);
+    }
+
+    int32_t reg_offset(size_t offset) const { return (int32_t)offset; }
+
+    void prologue() {
+        e.push(RBX); e.push(RBP); e.push(R12); e.push(R13); e.push(R14); e.push(R15);
+        e.sub_rsp(24); // loop counters, keeps the stack 16-byte aligned for the store callback
+        e.store64_imm(RSP, 0, 0);
+        e.store64(RSP, 8, RDX);
+        e.mov64(REG_CORE, RDI);
+        e.mov64(REG_MEM, RSI);
+        e.movzx8(REG_A, REG_CORE, NO_INDEX, reg_offset(layout.a));
+        e.movzx8(REG_X, REG_CORE, NO_INDEX, reg_offset(layout.x));
+        e.movzx8(REG_Y, REG_CORE, NO_INDEX, reg_offset(layout.y));
+        e.alu32(ALU_XOR, REG_NZ, REG_NZ);
+    }
+
+    // Fold the pending N/Z result into P, clobbers eax and ecx
+    void materialize_nz() {
+        if (!nz_pending) return;
+        int32_t p = reg_offset(layout.p);
+        e.alu8_mem_imm(ALU_AND, REG_CORE, p, (uint8_t)~(FLAG_N | FLAG_Z));
+        e.mov32(RAX, REG_NZ);
+        e.alu32_imm(ALU_AND, RAX, FLAG_N);
+        e.test8(REG_NZ, REG_NZ);
+        e.setcc(CC_Z, RCX);
+        e.movzx8_reg(RCX, RCX);
+        e.alu32(ALU_ADD, RCX, RCX); // FLAG_Z
+        e.alu32(ALU_OR, RAX, RCX);
+        e.or8_mem(REG_CORE, p, RAX);
+        nz_pending = false;
+    }
+
+    void set_nz(int reg) {
+        e.movzx8_reg(REG_NZ, reg);
+        nz_pending = true;
+    }
+
+    // Leave the block: pc is either a constant or already stored
+    void exit(uint32_t count, uint16_t pc, bool store_pc = true, uint32_t extra_cycles = 0) {
+        if (store_pc) e.store16_imm(REG_CORE, reg_offset(layout.pc), pc);
+        materialize_nz();
+        if (cycles + extra_cycles) e.add64_mem_imm(REG_CORE, reg_offset(layout.cycles), (uint32_t)(cycles + extra_cycles));
+        e.store8(REG_CORE, reg_offset(layout.a), REG_A);
+        e.store8(REG_CORE, reg_offset(layout.x), REG_X);
+        e.store8(REG_CORE, reg_offset(layout.y), REG_Y);
+        e.mov32_imm(RAX, count);
+        e.add64_from_mem(RAX, RSP, 0);
+        e.add_rsp(24);
+        e.pop(R15); e.pop(R14); e.pop(R13); e.pop(R12); e.pop(RBP); e.pop(RBX);
+        e.ret();
+    }
+
+    // Jump of the last instruction back to the start of the block: run it again
+    // natively while the budget has room for one more iteration, else leave
+    void loop_or_exit(uint32_t count, uint32_t extra_cycles) {
+        e.load64(RAX, RSP, 0);
+        e.add64_imm(RAX, 2 * length);
+        e.cmp64_from_mem(RAX, RSP, 8);
+        size_t over = e.jcc(CC_A);
+        bool pending = nz_pending;
+        materialize_nz();
+        e.add64_mem_imm(RSP, 0, length);
+        e.add64_mem_imm(REG_CORE, reg_offset(layout.cycles), (uint32_t)(cycles + extra_cycles));
+        e.jmp_back(body);
+        e.patch(over);
+        nz_pending = pending;
+        exit(count, start, true, extra_cycles);
+    }
+
+    void add_cycle_if_index_crosses(int index, uint8_t low) {
+        // (low + index) > 0xFF  <=>  index >= 0x100 - low
+        if (low == 0) return;
+        e.alu32_imm(ALU_CMP, index, 0x100 - low);
+        size_t skip = e.jcc(CC_C);
+        e.add64_mem_imm(REG_CORE, reg_offset(layout.cycles), 1);
+        e.patch(skip);
+    }
+
+    // Effective address into ecx (not for AM_IMM, AM_ACC, AM_IMP)
+    void address(const cpu6502_decoded_insn_t& insn, const opcode_info_t& info) {
+        uint16_t operand = insn.operand;
+        switch (info.mode) {
+            case AM_ZP:
+            case AM_ABS:
+                e.mov32_imm(RCX, operand);
+                break;
+            case AM_ZPX:
+            case AM_ZPY:
+                e.lea32(RCX, info.mode == AM_ZPX ? REG_X : REG_Y, operand);
+                e.movzx8_reg(RCX, RCX);
+                break;
+            case AM_ABSX:
+            case AM_ABSY: {
+                int index = info.mode == AM_ABSX ? REG_X : REG_Y;
+                if (info.page_penalty) add_cycle_if_index_crosses(index, operand & 0xFF);
+                e.lea32(RCX, index, operand);
+                e.movzx16_reg(RCX, RCX);
+                break;
+            }
+            case AM_INDX:
+                e.lea32(RCX, REG_X, operand);
+                e.movzx8_reg(RCX, RCX);
+                e.movzx8(RAX, REG_MEM, RCX, 0);
+                e.alu8_imm(ALU_ADD, RCX, 1); // pointer wraps in the zero page
+                e.movzx8(RCX, REG_MEM, RCX, 0);
+                e.shl32_imm(RCX, 8);
+                e.alu32(ALU_OR, RCX, RAX);
+                break;
+            case AM_INDY:
+                e.movzx8(RCX, REG_MEM, NO_INDEX, operand & 0xFF);
+                e.movzx8(RAX, REG_MEM, NO_INDEX, (operand + 1) & 0xFF);
+                if (info.page_penalty) {
+                    e.mov32(RDX, RCX);
+                    e.alu32(ALU_ADD, RDX, REG_Y);
+                    e.alu32_imm(ALU_CMP, RDX, 0x100);
+                    size_t skip = e.jcc(CC_C);
+                    e.add64_mem_imm(REG_CORE, reg_offset(layout.cycles), 1);
+                    e.patch(skip);
+                }
+                e.shl32_imm(RAX, 8);
+                e.alu32(ALU_OR, RCX, RAX);
+                e.alu32(ALU_ADD, RCX, REG_Y);
+                e.movzx16_reg(RCX, RCX);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Operand value into eax, address (if any) stays in ecx
+    void load_operand(const cpu6502_decoded_insn_t& insn, const opcode_info_t& info) {
+        if (info.mode == AM_IMM) {
+            e.mov32_imm(RAX, insn.operand & 0xFF);
+        } else if (info.mode == AM_ZP || info.mode == AM_ABS) {
+            if (info.flags & OPC_RMW) e.mov32_imm(RCX, insn.operand);
+            e.movzx8(RAX, REG_MEM, NO_INDEX, insn.operand);
+        } else {
+            address(insn, info);
+            e.movzx8(RAX, REG_MEM, RCX, 0);
+        }
+    }
+
+    // Store value (any register but rdi/rsi/rcx) to the address in esi
+    void call_write(int value) {
+        e.mov32(RDX, value);
+        e.mov64(RDI, REG_CORE);
+        e.mov64_imm(RCX, (uint64_t)cache);
+        e.call((const void*)layout.write);
+    }
+
+    // Store to the address in ecx, leaves the block when cached code was hit
+    void store(int value, uint32_t count, uint16_t next, bool check) {
+        e.mov32(RSI, RCX);
+        call_write(value);
+        if (check) smc_check(count, next);
+    }
+
+    void smc_check(uint32_t count, uint16_t next) {
+        e.test32(RAX, RAX);
+        smc_exits.push_back(smc_exit_t{ e.jcc(CC_NZ), count, next, cycles, nz_pending });
+    }
+
+    // Copy flag bit 0 (C) of P into the host carry
+    void load_carry(bool inverted) {
+        e.movzx8(RDX, REG_CORE, NO_INDEX, reg_offset(layout.p));
+        e.bt32_imm(RDX, 0);
+        if (inverted) e.cmc();
+    }
+
+    // P.C from the host carry (inverted for subtraction), P.V from the host overflow
+    void store_carry(bool inverted, bool overflow) {
+        int32_t p = reg_offset(layout.p);
+        e.setcc(inverted ? CC_NC : CC_C, RDX);
+        if (overflow) {
+            e.setcc(CC_O, RSI);
+            e.shl8_imm(RSI, 6); // FLAG_V
+            e.alu8_mem_imm(ALU_AND, REG_CORE, p, (uint8_t)~(FLAG_C | FLAG_V));
+            e.or8_mem(REG_CORE, p, RSI);
+        } else {
+            e.alu8_mem_imm(ALU_AND, REG_CORE, p, (uint8_t)~FLAG_C);
+        }
+        e.or8_mem(REG_CORE, p, RDX);
+    }
+
+    // Stack address 0x0100 | s into esi
+    void stack_address() {
+        e.movzx8(RSI, REG_CORE, NO_INDEX, reg_offset(layout.s));
+        e.alu32_imm(ALU_OR, RSI, 0x100);
+    }
+
+    // s++, pulled byte into dst
+    void pull(int dst) {
+        int32_t s = reg_offset(layout.s);
+        e.inc8_mem(REG_CORE, s);
+        e.movzx8(RAX, REG_CORE, NO_INDEX, s);
+        e.movzx8(dst, REG_MEM, RAX, 0x100);
+    }
+
+    void flag(uint8_t mask, bool set) {
+        if (set) e.alu8_mem_imm(ALU_OR, REG_CORE, reg_offset(layout.p), mask);
+        else     e.alu8_mem_imm(ALU_AND, REG_CORE, reg_offset(layout.p), (uint8_t)~mask);
+    }
+
+    // Branch condition, returns the host condition meaning "taken"
+    cond_t branch_condition(uint8_t mnemonic) {
+        uint8_t mask = 0;
+        bool taken_if_set = false;
+        switch (mnemonic) {
+            case MN_BPL: mask = FLAG_N; taken_if_set = false; break;
+            case MN_BMI: mask = FLAG_N; taken_if_set = true;  break;
+            case MN_BVC: mask = FLAG_V; taken_if_set = false; break;
+            case MN_BVS: mask = FLAG_V; taken_if_set = true;  break;
+            case MN_BCC: mask = FLAG_C; taken_if_set = false; break;
+            case MN_BCS: mask = FLAG_C; taken_if_set = true;  break;
+            case MN_BNE: mask = FLAG_Z; taken_if_set = false; break;
+            case MN_BEQ: mask = FLAG_Z; taken_if_set = true;  break;
+        }
+        if (nz_pending && (mask & (FLAG_N | FLAG_Z))) {
+            // Straight from the lazy result, no need to build P first
+            e.test8(REG_NZ, REG_NZ);
+            if (mask == FLAG_Z) return taken_if_set ? CC_Z : CC_NZ;
+            return taken_if_set ? CC_S : CC_NS;
+        }
+        e.test8_mem_imm(REG_CORE, reg_offset(layout.p), mask);
+        return taken_if_set ? CC_NZ : CC_Z;
+    }
+
+    // Emit one instruction, returns false when it ended the block
+    bool instruction(const cpu6502_decoded_insn_t& insn, const opcode_info_t& info, uint16_t next, uint32_t count) {
+        switch (info.mnemonic) {
+            case MN_LDA: load_operand(insn, info); e.mov32(REG_A, RAX); set_nz(REG_A); break;
+            case MN_LDX: load_operand(insn, info); e.mov32(REG_X, RAX); set_nz(REG_X); break;
+            case MN_LDY: load_operand(insn, info); e.mov32(REG_Y, RAX); set_nz(REG_Y); break;
+
+            case MN_STA:
+            case MN_STX:
+            case MN_STY:
+                address(insn, info);
+                store(info.mnemonic == MN_STA ? REG_A : info.mnemonic == MN_STX ? REG_X : REG_Y, count, next, true);
+                break;
+
+            case MN_TAX: e.mov32(REG_X, REG_A); set_nz(REG_X); break;
+            case MN_TAY: e.mov32(REG_Y, REG_A); set_nz(REG_Y); break;
+            case MN_TXA: e.mov32(REG_A, REG_X); set_nz(REG_A); break;
+            case MN_TYA: e.mov32(REG_A, REG_Y); set_nz(REG_A); break;
+            case MN_TSX: e.movzx8(REG_X, REG_CORE, NO_INDEX, reg_offset(layout.s)); set_nz(REG_X); break;
+            case MN_TXS: e.store8(REG_CORE, reg_offset(layout.s), REG_X); break;
+
+            case MN_PHA:
+            case MN_PHP:
+                if (info.mnemonic == MN_PHP) {
+                    materialize_nz();
+                    e.movzx8(RAX, REG_CORE, NO_INDEX, reg_offset(layout.p));
+                    e.alu32_imm(ALU_OR, RAX, FLAG_B | FLAG_U);
+                }
+                stack_address();
+                e.dec8_mem(REG_CORE, reg_offset(layout.s));
+                call_write(info.mnemonic == MN_PHA ? REG_A : RAX);
+                smc_check(count, next);
+                break;
+            case MN_PLA: pull(REG_A); set_nz(REG_A); break;
+            case MN_PLP:
+                pull(RAX);
+                e.alu32_imm(ALU_AND, RAX, (uint8_t)~FLAG_B);
+                e.alu32_imm(ALU_OR, RAX, FLAG_U);
+                e.store8(REG_CORE, reg_offset(layout.p), RAX);
+                nz_pending = false; // P is whole again
+                break;
+
+            case MN_AND: load_operand(insn, info); e.alu8(ALU_AND, REG_A, RAX); set_nz(REG_A); break;
+            case MN_ORA: load_operand(insn, info); e.alu8(ALU_OR, REG_A, RAX); set_nz(REG_A); break;
+            case MN_EOR: load_operand(insn, info); e.alu8(ALU_XOR, REG_A, RAX); set_nz(REG_A); break;
+
+            // 6502 carry is the inverted x86 borrow, the overflow flags match
+            case MN_ADC:
+            case MN_SBC: {
+                bool sbc = info.mnemonic == MN_SBC;
+                load_operand(insn, info);
+                load_carry(sbc);
+                e.alu8(sbc ? ALU_SBB : ALU_ADC, REG_A, RAX);
+                store_carry(sbc, true);
+                set_nz(REG_A);
+                break;
+            }
+
+            case MN_CMP:
+            case MN_CPX:
+            case MN_CPY:
+                load_operand(insn, info);
+                e.mov32(RDX, info.mnemonic == MN_CMP ? REG_A : info.mnemonic == MN_CPX ? REG_X : REG_Y);
+                e.alu8(ALU_SUB, RDX, RAX);
+                e.setcc(CC_NC, RSI);
+                flag(FLAG_C, false);
+                e.or8_mem(REG_CORE, reg_offset(layout.p), RSI);
+                set_nz(RDX);
+                break;
+
+            case MN_INC:
+            case MN_DEC:
+                load_operand(insn, info);
+                e.alu8_imm(info.mnemonic == MN_INC ? ALU_ADD : ALU_SUB, RAX, 1);
+                set_nz(RAX);
+                store(RAX, count, next, true);
+                break;
+
+            case MN_ASL:
+            case MN_LSR:
+            case MN_ROL:
+            case MN_ROR: {
+                shift_t op = info.mnemonic == MN_ASL ? SH_SHL : info.mnemonic == MN_LSR ? SH_SHR
+                           : info.mnemonic == MN_ROL ? SH_RCL : SH_RCR;
+                int reg = info.mode == AM_ACC ? REG_A : RAX;
+                if (info.mode != AM_ACC) load_operand(insn, info);
+                if (op == SH_RCL || op == SH_RCR) load_carry(false);
+                e.shift8_1(op, reg);
+                store_carry(false, false);
+                set_nz(reg);
+                if (info.mode != AM_ACC) store(RAX, count, next, true);
+                break;
+            }
+
+            case MN_CLC: flag(FLAG_C, false); break;
+            case MN_SEC: flag(FLAG_C, true); break;
+            case MN_CLI: flag(FLAG_I, false); break;
+            case MN_SEI: flag(FLAG_I, true); break;
+            case MN_CLV: flag(FLAG_V, false); break;
+            case MN_CLD: flag(FLAG_D, false); break;
+            case MN_SED: flag(FLAG_D, true); break;
+            case MN_NOP: break;
+
+            case MN_JMP:
+                if (insn.operand == start) loop_or_exit(count, 0);
+                else exit(count, insn.operand);
+                return false;
+            case MN_JSR: {
+                // Pushes can only invalidate code, the block ends here anyway
+                uint16_t ret = next - 1;
+                stack_address();
+                e.dec8_mem(REG_CORE, reg_offset(layout.s));
+                e.mov32_imm(RAX, ret >> 8);
+                call_write(RAX);
+                stack_address();
+                e.dec8_mem(REG_CORE, reg_offset(layout.s));
+                e.mov32_imm(RAX, ret & 0xFF);
+                call_write(RAX);
+                exit(count, insn.operand);
+                return false;
+            }
+            case MN_RTS:
+                pull(RCX);
+                pull(RDX);
+                e.shl32_imm(RDX, 8);
+                e.alu32(ALU_OR, RDX, RCX);
+                e.alu32_imm(ALU_ADD, RDX, 1);
+                e.store16(REG_CORE, reg_offset(layout.pc), RDX);
+                exit(count, 0, false);
+                return false;
+
+            case MN_BPL: case MN_BMI: case MN_BVC: case MN_BVS:
+            case MN_BCC: case MN_BCS: case MN_BNE: case MN_BEQ: {
+                uint16_t target = next + (int8_t)insn.operand;
+                size_t taken = e.jcc(branch_condition(info.mnemonic));
+                bool pending = nz_pending;
+                exit(count, next);
+                e.patch(taken);
+                nz_pending = pending;
+                uint32_t extra = ((next ^ target) & 0xFF00) ? 2 : 1;
+                if (target == start) loop_or_exit(count, extra);
+                else exit(count, target, true, extra);
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+cpu6502_jit::cpu6502_jit(cpu6502_block_cache& cache, unsigned threshold, size_t arena_size, bool perf_map)
+    : cache(cache), threshold(threshold), arena(nullptr), arena_size(arena_size), used(0), epoch(1),
+      perf_map(nullptr) {
+    reset_counters();
+    void* mem = mmap(nullptr, arena_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem != MAP_FAILED && arena_size >= MAX_BLOCK_CODE) {
+        arena = (uint8_t*)mem;
+    } else if (mem != MAP_FAILED) {
+        munmap(mem, arena_size);
+    }
+    if (arena && perf_map) {
+        char name[64];
+        snprintf(name, sizeof(name), "/tmp/perf-%d.map", (int)getpid());
+        this->perf_map = fopen(name, "a");
+    }
+}
+
+cpu6502_jit::~cpu6502_jit() {
+    if (perf_map) fclose(perf_map);
+    if (arena) munmap(arena, arena_size);
+}
+
+cpu6502_jit::native_fn cpu6502_jit::translate(cpu6502_block_t& block, const cpu6502_jit_layout_t& layout) {
+    if (arena_size - used < MAX_BLOCK_CODE) {
+        flush();
+    }
+    translator t(arena + used, layout, &cache);
+    size_t size = t.translate(block);
+    if (size == 0) {
+        block.jit_failed = true;
+        return nullptr;
+    }
+    block.native = arena + used;
+    block.native_epoch = epoch;
+    if (perf_map) {
+        fprintf(perf_map, "%lx %zx cpu6502_block_%04X\n", (unsigned long)(uintptr_t)block.native, size, block.start);
+        fflush(perf_map);
+    }
+    used = (used + size + 15) & ~(size_t)15;
+    translations++;
+    native_runs++;
+    return (native_fn)block.native;
+}
+
+#else
+
+cpu6502_jit::cpu6502_jit(cpu6502_block_cache& cache, unsigned threshold, size_t arena_size, bool)
+    : cache(cache), threshold(threshold), arena(nullptr), arena_size(arena_size), used(0), epoch(1),
+      perf_map(nullptr) {
+    reset_counters();
+}
+
+cpu6502_jit::~cpu6502_jit() {}
+
+cpu6502_jit::native_fn cpu6502_jit::translate(cpu6502_block_t&, const cpu6502_jit_layout_t&) {
+    return nullptr;
+}
+
+#endif
+
+void cpu6502_jit::flush() {
+    // Blocks still pointing into the arena see an old epoch and translate again
+    used = 0;
+    epoch++;
+    flushes++;
+}
+
+void cpu6502_jit::reset_counters() {
+    translations = 0;
+    flushes = 0;
+    native_runs = 0;
+}
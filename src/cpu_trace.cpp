@@ -0,0 +1,56 @@
+#include "cpu_trace.h"
+#include <sstream>
+
+cpu_trace_config cpu_trace;
+
+static const struct {
+    const char* name;
+    unsigned mask;
+} trace_names[] = {
+    { "fetch",   TRACE_FETCH },
+    { "decode",  TRACE_DECODE },
+    { "alu",     TRACE_ALU },
+    { "regfile", TRACE_REGFILE },
+    { "memory",  TRACE_MEMORY },
+    { "io",      TRACE_IO },
+    { "all",     TRACE_ALL }
+};
+
+bool cpu_trace_parse(const std::string& spec) {
+    if (spec == "off") {
+        cpu_trace.categories = 0;
+        cpu_trace.level = TRACE_OFF;
+        return true;
+    }
+
+    std::string names = spec;
+    unsigned level = TRACE_DEBUG;
+    size_t colon = spec.find(':');
+    if (colon != std::string::npos) {
+        names = spec.substr(0, colon);
+        std::string level_str = spec.substr(colon + 1);
+        if (level_str.size() != 1 || level_str[0] < '0' || level_str[0] > '3') {
+            return false;
+        }
+        level = level_str[0] - '0';
+    }
+
+    unsigned categories = 0;
+    std::istringstream iss(names);
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        bool known = false;
+        for (const auto& entry : trace_names) {
+            if (name == entry.name) {
+                categories |= entry.mask;
+                known = true;
+            }
+        }
+        if (!known) {
+            return false;
+        }
+    }
+    cpu_trace.categories = categories;
+    cpu_trace.level = level;
+    return true;
+}
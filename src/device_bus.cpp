@@ -0,0 +1,50 @@
+#include "device_bus.h"
+
+bool device_bus::map(uint16_t base, uint32_t size, bus_device* device) {
+    if (!device || size == 0 || base + size > 0x10000) {
+        return false;
+    }
+    uint16_t offset;
+    for (uint32_t addr = base; addr < base + size; ++addr) {
+        if (decode(addr, offset)) {
+            return false;
+        }
+    }
+    for (uint32_t addr = base; addr < base + size; ++addr) {
+        std::unique_ptr<device_page>& page = pages[addr >> 8];
+        if (!page) {
+            page.reset(new device_page());
+        }
+        page->slot[addr & 0xFF] = slot_t{ device, base };
+    }
+    return true;
+}
+
+void device_bus::unmap(bus_device* device) {
+    for (std::unique_ptr<device_page>& page : pages) {
+        if (!page) continue;
+        bool used = false;
+        for (slot_t& slot : page->slot) {
+            if (slot.device == device) {
+                slot = slot_t{ nullptr, 0 };
+            }
+            used |= slot.device != nullptr;
+        }
+        // Back to the RAM fast path
+        if (!used) {
+            page.reset();
+        }
+    }
+}
+
+bool device_bus::dmi_readable() const {
+    for (const std::unique_ptr<device_page>& page : pages) {
+        if (!page) continue;
+        for (const slot_t& slot : page->slot) {
+            if (slot.device && slot.device->read_side_effects()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
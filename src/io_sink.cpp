@@ -0,0 +1,81 @@
+#include "io_sink.h"
+#include <cstring>
+
+size_t io_port_text(const io_record_t& record, char* text) {
+    switch (record.port) {
+        case 0: return std::snprintf(text, 9, "%d", record.value);
+        case 1: return std::snprintf(text, 9, "0x%02x", record.value);
+        case 2: text[0] = (char)record.value; return 1;
+        default:
+            for (int i = 7; i >= 0; --i) {
+                text[7 - i] = ((record.value >> i) & 1) ? '1' : '0';
+            }
+            return 8;
+    }
+}
+
+size_t io_format_record(const io_record_t& record, bool stamp_cycles, char* text) {
+    if (!stamp_cycles) {
+        return io_port_text(record, text);
+    }
+    size_t length = std::snprintf(text, 40, "[%llu] PORT %d: ", (unsigned long long)record.cycle, record.port);
+    length += io_port_text(record, text + length);
+    text[length++] = '\n';
+    return length;
+}
+
+std::string io_port_message(const io_record_t& record) {
+    static const char* const kind[] = { "DEC", "HEX", "CHR", "BIN" };
+    char text[9];
+    std::string value(text, io_port_text(record, text));
+    if (record.port == 2) {
+        value = "'" + value + "'";
+    }
+    return "PORT " + std::to_string(record.port) + " (" + kind[record.port & 3] + "): " + value;
+}
+
+io_file_sink::io_file_sink(const std::string& path, bool stamp_cycles, size_t buffer_size)
+    : file(std::fopen(path.c_str(), "w")), stamp_cycles(stamp_cycles), buffer(buffer_size < 64 ? 64 : buffer_size) {
+    if (file) {
+        std::fprintf(file, "=== CPU - Output Ports Log ===\n");
+        std::fprintf(file, stamp_cycles ? "Format: [CYCLE] PORT n: VALUE\n" : "Format: VALUE (port values concatenated)\n");
+        std::fprintf(file, "=====================================\n");
+    }
+}
+
+io_file_sink::~io_file_sink() {
+    if (file) {
+        flush();
+        std::fclose(file);
+    }
+}
+
+void io_file_sink::write(const io_record_t& record) {
+    if (!file) {
+        return;
+    }
+    if (buffer.size() - used < 48) {
+        std::fwrite(buffer.data(), 1, used, file);
+        used = 0;
+    }
+    used += io_format_record(record, stamp_cycles, &buffer[used]);
+}
+
+void io_file_sink::flush() {
+    if (file) {
+        std::fwrite(buffer.data(), 1, used, file);
+        std::fflush(file);
+    }
+    used = 0;
+}
+
+void io_stream_sink::write(const io_record_t& record) {
+    char text[48];
+    out.write(text, io_format_record(record, stamp_cycles, text));
+}
+
+void io_buffer_sink::write(const io_record_t& record) {
+    char line[48];
+    records.push_back(record);
+    text.append(line, io_format_record(record, stamp_cycles, line));
+}
@@ -0,0 +1,73 @@
+#include "lockstep.h"
+#include <cstdio>
+#include <cstring>
+
+void lockstep_checker::start(const uint8_t* model_mem, const lockstep_state_t& state) {
+    std::memcpy(mem.data(), model_mem, mem.size());
+    reference.reset(state.pc);
+    reference.a = state.a;
+    reference.x = state.x;
+    reference.y = state.y;
+    reference.s = state.s;
+    reference.p = state.p;
+    model_writes.clear();
+    reference_writes.clear();
+    running = true;
+    diverged = false;
+    checked = 0;
+    text.clear();
+}
+
+static std::string describe(const char* who, uint8_t a, uint8_t x, uint8_t y, uint8_t s, uint8_t p, uint16_t pc,
+                            const std::vector<lockstep_write_t>& writes) {
+    char line[96];
+    std::snprintf(line, sizeof(line), "  %-9s A=%02X X=%02X Y=%02X S=%02X P=%02X PC=%04X  writes", who, a, x, y, s,
+                  p, pc);
+    std::string out = line;
+    if (writes.empty()) {
+        out += " none";
+    }
+    for (const lockstep_write_t& w : writes) {
+        std::snprintf(line, sizeof(line), " [%04X]=%02X", w.addr, w.data);
+        out += line;
+    }
+    return out + "\n";
+}
+
+// One header line with the instruction (block) that diverged, both states,
+// and what differs:
+//   lockstep divergence at instruction 12, $0007: 9D 00 02  STA
+//     reference A=05 X=01 Y=00 S=FF P=20 PC=000A  writes [0201]=05
+//     model     A=05 X=01 Y=00 S=FF P=20 PC=000A  writes [0200]=05
+//     differs:  writes
+void lockstep_checker::fail(const lockstep_state_t& state, uint16_t pc, uint64_t n) {
+    running = false;
+    diverged = true;
+
+    uint8_t opcode = mem[pc];
+    const opcode_info_t& info = opcode_table[opcode];
+    char line[128];
+    int used = n == 1 ? std::snprintf(line, sizeof(line), "lockstep divergence at instruction %llu, $%04X:",
+                                      (unsigned long long)checked, pc)
+                      : std::snprintf(line, sizeof(line), "lockstep divergence in the %llu instructions up to %llu, from $%04X:",
+                                      (unsigned long long)n, (unsigned long long)checked, pc);
+    for (int i = 0; i < 3; ++i) {
+        used += i < info.length ? std::snprintf(line + used, sizeof(line) - used, " %02X", mem[(uint16_t)(pc + i)])
+                                : std::snprintf(line + used, sizeof(line) - used, "   ");
+    }
+    std::snprintf(line + used, sizeof(line) - used, "  %s\n", opcode_mnemonic_name(opcode));
+    text = line;
+    text += describe("reference", reference.a, reference.x, reference.y, reference.s, reference.p, reference.pc,
+                     reference_writes);
+    text += describe("model", state.a, state.x, state.y, state.s, state.p, state.pc, model_writes);
+
+    text += "  differs: ";
+    if (reference.a != state.a) text += " A";
+    if (reference.x != state.x) text += " X";
+    if (reference.y != state.y) text += " Y";
+    if (reference.s != state.s) text += " S";
+    if (reference.p != state.p) text += " P";
+    if (reference.pc != state.pc) text += " PC";
+    if (!same_writes()) text += " writes";
+    text += "\n";
+}
@@ -4,6 +4,7 @@
 #include <vector>
 #include <string>
 #include <iomanip>
+#include <climits>
 #include "cpu.h"
 #include "cpu_defs.h"
 
@@ -12,53 +13,31 @@ SC_MODULE(testbench) {
     sc_signal<bool> reset;
     cpu* cpu_i;
     std::string program_file_path;
+    uint16_t load_address = 0; // of .bin programs
+    std::string program_cache_dir; // compiled images of text programs, empty parses every run
+    std::string save_path;         // checkpoint written after the run
+    std::string restore_path;      // checkpoint started from instead of the program
 
-    // Function to load program from file
+    // Load a program file (hex text, .bin, Intel HEX or segment image, see
+    // program_image.h) straight into the memory array
     bool load_program(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cout << "ERROR: Cannot open file: " << filename << std::endl;
+        program_image image;
+        std::string error;
+        program_cache cache(program_cache_dir);
+        bool ok = program_cache_dir.empty() ? load_program_image(filename, image, error, load_address)
+                                            : cache.load(filename, image, error, load_address);
+        if (!ok && image.segments.empty()) {
+            std::cout << "ERROR: " << error << std::endl;
             return false;
         }
-        
-        std::vector<uint8_t> program_bytes;
-        std::string line;
-        
-        std::cout << "Loading program: " << filename << std::endl;
-
-        while (std::getline(file, line)) {
-            // Skip comments and empty lines
-            if (line.empty() || line[0] == '#') continue;
-            // Parse hex bytes
-            std::istringstream iss(line);
-            std::string hex_byte;
-            
-            while (iss >> hex_byte) {
-                if (hex_byte[0] == '#') break; // line comment skip
-                
-                try {
-                    uint8_t byte = std::stoi(hex_byte, nullptr, 16);
-                    program_bytes.push_back(byte);
-                } catch (const std::exception& e) {
-                    std::cout << "ERROR parsing: " << hex_byte << std::endl;
-                }
-            }
+        if (!error.empty()) {
+            std::cout << "ERROR parsing: " << error << std::endl;
         }
-        
-        // Załaduj do pamięci CPU
-        for (size_t i = 0; i < program_bytes.size() && i < 65536; ++i) {
-            cpu_i->memory_i->mem[i] = program_bytes[i];
-        }
-        
-        std::cout << "Loaded " << program_bytes.size() << " bytes:" << std::endl;
-        /*
-        for (size_t i = 0; i < program_bytes.size() && i < 16; ++i) {
-            std::cout << "Memory[0x" << std::hex << std::setfill('0') << std::setw(4) 
-                      << i << "] = 0x" << std::setw(2) << (int)program_bytes[i] << std::endl;
-        }
-        */
-        
-        file.close();
+
+        size_t loaded = cpu_i->memory_i->load_image(image);
+        std::cout << "Loaded " << loaded << " bytes in " << image.segments.size() << " segment(s)"
+                  << (cache.hits ? " from the program cache" : "") << ", boot from 0x"
+                  << std::hex << cpu_i->reset_vector() << std::dec << std::endl;
         return true;
     }
 
@@ -74,19 +53,34 @@ SC_MODULE(testbench) {
     void run() {
         std::cout << "=== Start CPU Simulation ===" << std::endl;
 
-        // Load program from file (path from command line arguments)
-        std::cout << "Loading program: " << program_file_path << std::endl;
+        if (restore_path.empty()) {
+            // Load program from file (path from command line arguments)
+            std::cout << "Loading program: " << program_file_path << std::endl;
 
-        if (!load_program(program_file_path)) {
-            std::cout << "Fallback: Failed to load program, stopping simulation" << std::endl;
-            // Fallback - hardcoded program
-            cpu_i->memory_i->mem[0x0002] = 0x00; // BRK (halt)
+            if (!load_program(program_file_path)) {
+                std::cout << "Fallback: Failed to load program, stopping simulation" << std::endl;
+                // Fallback - hardcoded program
+                uint8_t brk = 0x00;
+                cpu_i->debug_write(0x0002, &brk, 1); // BRK (halt)
+            }
         }
         
         // Reset AFTER loading program
         reset.write(true);
         wait(20, SC_NS);
         reset.write(false);
+
+        // Warm start: memory and CPU state from the checkpoint instead of the program
+        if (!restore_path.empty()) {
+            std::string error;
+            if (!cpu_i->restore_checkpoint(restore_path, error)) {
+                std::cout << "ERROR: " << error << std::endl;
+                sc_stop();
+                return;
+            }
+            std::cout << "Restored checkpoint: " << restore_path << ", PC 0x" << std::hex << cpu_i->pc_val
+                      << std::dec << std::endl;
+        }
         wait(10, SC_NS);
 
         // Simulation for a specified number of cycles
@@ -94,21 +88,43 @@ SC_MODULE(testbench) {
             wait(10, SC_NS);
         }
 
+        if (!save_path.empty()) {
+            // The FSM reaches the next instruction boundary within one instruction
+            for (int i = 0; i < 16 && !cpu_i->at_instruction_boundary(); ++i) {
+                wait(10, SC_NS);
+            }
+            std::string error;
+            if (cpu_i->save_checkpoint(save_path, error)) {
+                std::cout << "Saved checkpoint: " << save_path << std::endl;
+            } else {
+                std::cout << "ERROR: " << error << std::endl;
+            }
+        }
+
         // Print A register value
         std::cout << "=== Simulation Result ===" << std::endl;
         std::cout << "A Register: 0x" << std::hex << (int)cpu_i->regfile_i->A << std::endl;
         std::cout << "PC: 0x" << std::hex << (int)cpu_i->pc_val << std::endl;
         std::cout << "Operand (debug): 0x" << std::hex << (int)cpu_i->operand << std::endl;
         std::cout << "IR: 0x" << std::hex << (int)cpu_i->ir_val << std::endl;
+        if (cpu_i->model == cpu::BLOCK_CACHED) {
+            const cpu6502_block_cache& cache = cpu_i->block_cache;
+            std::cout << "Block cache: hits=" << std::dec << cache.hits << " misses=" << cache.misses
+                      << " invalidations=" << cache.invalidations << std::endl;
+        }
         sc_stop();
     }
 
-    testbench(sc_module_name name, const std::string& prog_file) : sc_module(name), program_file_path(prog_file) {
-        cpu_i = new cpu("cpu_i");
+    testbench(sc_module_name name, const std::string& prog_file, cpu::cpu_model_t model = cpu::SIGNAL_LEVEL)
+        : sc_module(name), program_file_path(prog_file) {
+        cpu_i = new cpu("cpu_i", model);
         cpu_i->clk(clk);
         cpu_i->reset(reset);        
         
-        SC_THREAD(clock_gen);
+        // LT model advances time on its own, no clock needed
+        if (!cpu_i->loosely_timed()) {
+            SC_THREAD(clock_gen);
+        }
         SC_THREAD(run);
     }
     
@@ -127,17 +143,179 @@ SC_MODULE(testbench) {
     }
 };
 
+// Whole-string number of an option, false on bad input
+static bool parse_number(const std::string& text, uint64_t& value, int base = 10) {
+    size_t used = 0;
+    try {
+        value = std::stoull(text, &used, base);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return used == text.size() && text[0] != '-';
+}
+
+static bool parse_vcd_window(const std::string& text, waveform_window_t& window) {
+    size_t colon = text.find(':');
+    uint64_t start = 0, stop = UINT64_MAX;
+    if (!parse_number(text.substr(0, colon), start) ||
+        (colon != std::string::npos && !parse_number(text.substr(colon + 1), stop)) || start >= stop) {
+        return false;
+    }
+    window.start_cycle = start;
+    window.stop_cycle = stop;
+    return true;
+}
+
 int sc_main(int argc, char* argv[]) {
     std::string program_file = FALLBACK_PROGRAM; // default program
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    bool program_given = false;
 
-    // Check CLI arguments for program file
-    if (argc > 1) {
-        program_file = argv[1];
-    } else {
+    int quantum_cycles = 0;
+    int load_address = 0;
+    std::string program_cache_dir;
+    std::string save_path;
+    std::string restore_path;
+    bool alu_tables = false;
+    bool lockstep = false;
+    std::string trace_path;
+    std::string vcd_path;
+    std::string io_path = "../output/io_output.txt";
+    bool io_cycles = false;
+    waveform_window_t vcd_window;
+
+    // Check CLI arguments: [--lt | --bundled | --fast] [--quantum cycles] [--alu-tables]
+    //                      [--trace categories[:level]] [--trace-file path] [--io-file path|-] [--io-cycles]
+    //                      [--vcd path [--vcd-window start:stop] [--vcd-pc addr] [--vcd-pre n] [--vcd-post n]
+    //                            [--vcd-trigger]]
+    //                      [--load-address addr] [--program-cache dir]
+    //                      [--save-checkpoint path] [--restore-checkpoint path] [--lockstep] [program file]
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool vcd_ok = true;
+        if (arg == "--trace" && i + 1 < argc) {
+            if (!cpu_trace_parse(argv[++i])) {
+                std::cout << "ERROR: bad --trace " << argv[i]
+                          << ", expected fetch,decode,alu,regfile,memory,io or all with an optional :0-3 level" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--trace-file" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--io-file" && i + 1 < argc) {
+            io_path = argv[++i];
+        } else if (arg == "--io-cycles") {
+            io_cycles = true;
+        } else if (arg == "--vcd" && i + 1 < argc) {
+            vcd_path = argv[++i];
+        } else if (arg == "--vcd-window" && i + 1 < argc) {
+            vcd_ok = parse_vcd_window(argv[++i], vcd_window);
+        } else if (arg == "--vcd-pc" && i + 1 < argc) {
+            uint64_t pc = 0;
+            vcd_ok = parse_number(argv[++i], pc, 16) && pc <= 0xFFFF;
+            vcd_window.start_pc = (int)pc;
+        } else if (arg == "--vcd-pre" && i + 1 < argc) {
+            vcd_ok = parse_number(argv[++i], vcd_window.pre_cycles) &&
+                     vcd_window.pre_cycles <= waveform_capture::MAX_PRE_CYCLES;
+        } else if (arg == "--vcd-post" && i + 1 < argc) {
+            vcd_ok = parse_number(argv[++i], vcd_window.post_cycles);
+        } else if (arg == "--vcd-trigger") {
+            vcd_window.on_trigger = true;
+        } else if (arg == "--load-address" && i + 1 < argc) {
+            uint64_t address = 0;
+            if (!parse_number(argv[++i], address, 0) || address > 0xFFFF) {
+                std::cout << "ERROR: bad --load-address " << argv[i] << ", usage: --load-address addr (0 to 0xFFFF)"
+                          << std::endl;
+                return 1;
+            }
+            load_address = (int)address;
+        } else if (arg == "--program-cache" && i + 1 < argc) {
+            program_cache_dir = argv[++i];
+        } else if (arg == "--save-checkpoint" && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (arg == "--restore-checkpoint" && i + 1 < argc) {
+            restore_path = argv[++i];
+        } else if (arg == "--quantum" && i + 1 < argc) {
+            uint64_t cycles = 0;
+            if (!parse_number(argv[++i], cycles) || cycles == 0 || cycles > INT_MAX / CPU_CLOCK_PERIOD_NS) {
+                std::cout << "ERROR: bad --quantum " << argv[i] << ", usage: --quantum cycles (1 or more)" << std::endl;
+                return 1;
+            }
+            quantum_cycles = (int)cycles;
+        } else if (arg == "--alu-tables") {
+            alu_tables = true;
+        } else if (arg == "--lockstep") {
+            lockstep = true;
+        } else if (arg == "--lt") {
+            model = cpu::LOOSELY_TIMED;
+        } else if (arg == "--bundled") {
+            model = cpu::BUNDLED_CONTROL;
+        } else if (arg == "--fast") {
+            model = cpu::BLOCK_CACHED;
+        } else {
+            program_file = arg;
+            program_given = true;
+        }
+        if (!vcd_ok) {
+            std::cout << "ERROR: bad " << arg << " " << argv[i] << ", usage: --vcd path [--vcd-window start:stop] "
+                         "[--vcd-pc addr] [--vcd-pre n] [--vcd-post n] [--vcd-trigger], --vcd-pre at most "
+                      << waveform_capture::MAX_PRE_CYCLES << std::endl;
+            return 1;
+        }
+    }
+    if (!program_given) {
         std::cout << "Using default program: " << program_file << std::endl;
     }
     
-    testbench tb("tb", program_file);
+    io_stream_sink io_stdout(std::cout, io_cycles); // outlives tb, memory flushes it
+    testbench tb("tb", program_file, model);
+    tb.load_address = (uint16_t)load_address;
+    tb.program_cache_dir = program_cache_dir;
+    tb.save_path = save_path;
+    tb.restore_path = restore_path;
+    tb.cpu_i->alu_i->table_driven = alu_tables;
+    tb.cpu_i->memory_i->io_stamp_cycles = io_cycles;
+    if (io_path == "-") {
+        tb.cpu_i->memory_i->io = &io_stdout;
+    } else {
+        tb.cpu_i->memory_i->io_path = io_path;
+    }
+    lockstep_checker checker;
+    if (lockstep) {
+        tb.cpu_i->set_lockstep(&checker);
+    }
+    trace_file_writer trace_writer;
+    if (!trace_path.empty()) {
+        if (!trace_writer.open(trace_path)) {
+            std::cout << "ERROR: Cannot create trace file: " << trace_path << std::endl;
+            return 1;
+        }
+        tb.cpu_i->set_trace_file(&trace_writer);
+    }
+    std::unique_ptr<waveform_capture> waveform;
+    if (!vcd_path.empty()) {
+        waveform.reset(new waveform_capture("waveform"));
+        waveform->clk(tb.clk);
+        waveform->window = vcd_window;
+        tb.cpu_i->add_waveform_probes(*waveform);
+        tb.cpu_i->divergence_capture = waveform.get();
+        if (!waveform->open(vcd_path)) {
+            std::cout << "ERROR: Cannot create VCD file: " << vcd_path << std::endl;
+            return 1;
+        }
+    }
+    if (quantum_cycles > 0 && tb.cpu_i->loosely_timed()) {
+        tb.cpu_i->set_quantum(sc_time(CPU_CLOCK_PERIOD_NS * quantum_cycles, SC_NS));
+    }
     sc_start();
+    tb.cpu_i->memory_i->flush_io();
+    if (!trace_path.empty() && !trace_writer.close()) {
+        std::cout << "ERROR: Cannot write trace file: " << trace_path << std::endl;
+        return 1;
+    }
+    if (lockstep) {
+        std::cout << "Lockstep: " << std::dec << checker.instructions() << " instructions checked"
+                  << (checker.failed() ? ", diverged" : "") << std::endl;
+        return checker.failed() ? 1 : 0;
+    }
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,115 @@
 #include "memory.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <set>
 
-// Static member initialization
-ofstream memory::io_output;
-bool memory::io_file_opened = false;
+// Checks shared by b_transport and transport_dbg: single-beat, no byte enables,
+// inside the 64KB array. Returns false with the error status set.
+static bool check_payload(tlm::tlm_generic_payload& trans, sc_dt::uint64 size) {
+    sc_dt::uint64 address = trans.get_address();
+    unsigned length = trans.get_data_length();
+    if (address >= size || length > size - address) {
+        trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+        return false;
+    }
+    if (trans.get_byte_enable_ptr()) {
+        trans.set_response_status(tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE);
+        return false;
+    }
+    if (trans.get_streaming_width() < length) {
+        trans.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+        return false;
+    }
+    return true;
+}
+
+// Memory has no latency of its own, the CPU models time whole instructions
+void memory::b_transport(tlm::tlm_generic_payload& trans, sc_time& delay) {
+    (void)delay;
+    if (!check_payload(trans, sizeof(mem))) return;
+
+    sc_dt::uint64 address = trans.get_address();
+    unsigned char* data = trans.get_data_ptr();
+    unsigned length = trans.get_data_length();
+    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+        for (unsigned i = 0; i < length; ++i) {
+            data[i] = read(address + i);
+        }
+    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+        for (unsigned i = 0; i < length; ++i) {
+            write(address + i, data[i]);
+        }
+    }
+    trans.set_dmi_allowed(bus.dmi_readable());
+    trans.set_response_status(tlm::TLM_OK_RESPONSE);
+}
+
+// Debug access: raw RAM contents, devices are not touched. Writes still reach the block cache.
+unsigned memory::transport_dbg(tlm::tlm_generic_payload& trans) {
+    sc_dt::uint64 address = trans.get_address();
+    if (address >= sizeof(mem)) return 0;
+    unsigned length = (unsigned)std::min<sc_dt::uint64>(trans.get_data_length(), sizeof(mem) - address);
+    unsigned char* data = trans.get_data_ptr();
+    if (trans.get_command() == tlm::TLM_READ_COMMAND) {
+        memcpy(data, &mem[address], length);
+    } else if (trans.get_command() == tlm::TLM_WRITE_COMMAND) {
+        for (unsigned i = 0; i < length; ++i) {
+            write_mem(address + i, data[i]);
+        }
+    }
+    return length;
+}
+
+// Read-only DMI over the whole array: writes must go through b_transport for
+// the devices and the block cache. Refused while a device has read side effects.
+bool memory::get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi) {
+    (void)trans;
+    if (!bus.dmi_readable()) {
+        return false;
+    }
+    dmi.allow_read();
+    dmi.set_dmi_ptr(mem);
+    dmi.set_start_address(0);
+    dmi.set_end_address(sizeof(mem) - 1);
+    dmi.set_read_latency(SC_ZERO_TIME);
+    return true;
+}
+
+bool memory::map_device(uint16_t base, uint32_t size, bus_device* device) {
+    if (!bus.map(base, size, device)) {
+        return false;
+    }
+    if (device->read_side_effects()) {
+        socket->invalidate_direct_mem_ptr(0, sizeof(mem) - 1);
+    }
+    return true;
+}
+
+void memory::unmap_device(bus_device* device) {
+    bus.unmap(device);
+}
+
+// Files held by the default sinks of all instances, by absolute path
+static std::set<std::string>& default_io_files() {
+    static std::set<std::string> files;
+    return files;
+}
+
+void memory::open_default_io() {
+    std::string path = io_path.empty() ? "../output/io_output_" + std::string(name()) + ".txt" : io_path;
+    std::string file = std::filesystem::absolute(path).lexically_normal().string();
+    if (!default_io_files().insert(file).second) {
+        SC_REPORT_ERROR(name(), ("port output file " + path + " is already written by another memory, "
+                                 "give every instance its own io or io_path").c_str());
+    }
+    default_io_file = file;
+    default_io.reset(new io_file_sink(path, io_stamp_cycles));
+}
+
+memory::~memory() {
+    flush_io();
+    if (!default_io_file.empty()) {
+        default_io_files().erase(default_io_file);
+    }
+}
@@ -0,0 +1,78 @@
+#include "memory_snapshot.h"
+#include <cstring>
+
+void memory_page_tracker::mark_all() {
+    for (unsigned n = 0; n < 256; ++n) {
+        mark(n << 8);
+    }
+}
+
+void memory_page_tracker::clear_dirty() {
+    for (uint8_t n : dirty_list) {
+        dirty[n] = false;
+    }
+    dirty_list.clear();
+}
+
+memory_snapshot memory_page_tracker::snapshot(const uint8_t* mem) {
+    if (base.empty()) {
+        mark_all();
+    }
+    memory_snapshot result = base;
+    for (uint8_t n : dirty_list) {
+        const uint8_t* bytes = mem + (n << 8);
+        // A page written back to its old contents stays shared
+        if (result.pages[n] && std::memcmp(result.pages[n]->bytes, bytes, 256) == 0) {
+            continue;
+        }
+        std::shared_ptr<memory_page> page = std::make_shared<memory_page>();
+        std::memcpy(page->bytes, bytes, 256);
+        result.pages[n] = page;
+    }
+    base = result;
+    clear_dirty();
+    return result;
+}
+
+const std::vector<uint8_t>& memory_page_tracker::restore(const memory_snapshot& snapshot, uint8_t* mem) {
+    copied.clear();
+    if (snapshot.empty()) {
+        return copied;
+    }
+    for (unsigned n = 0; n < 256; ++n) {
+        if (base.empty() || dirty[n] || snapshot.pages[n] != base.pages[n]) {
+            std::memcpy(mem + (n << 8), snapshot.pages[n]->bytes, 256);
+            copied.push_back(n);
+        }
+    }
+    base = snapshot;
+    clear_dirty();
+    return copied;
+}
+
+std::vector<uint8_t> memory_page_tracker::diff(const memory_snapshot& snapshot, const uint8_t* mem) const {
+    std::vector<uint8_t> pages;
+    if (snapshot.empty()) {
+        return pages;
+    }
+    for (unsigned n = 0; n < 256; ++n) {
+        if ((base.empty() || dirty[n] || snapshot.pages[n] != base.pages[n]) &&
+            std::memcmp(mem + (n << 8), snapshot.pages[n]->bytes, 256) != 0) {
+            pages.push_back(n);
+        }
+    }
+    return pages;
+}
+
+std::vector<uint8_t> memory_page_tracker::diff(const memory_snapshot& a, const memory_snapshot& b) {
+    std::vector<uint8_t> pages;
+    if (a.empty() || b.empty()) {
+        return pages;
+    }
+    for (unsigned n = 0; n < 256; ++n) {
+        if (a.pages[n] != b.pages[n] && std::memcmp(a.pages[n]->bytes, b.pages[n]->bytes, 256) != 0) {
+            pages.push_back(n);
+        }
+    }
+    return pages;
+}
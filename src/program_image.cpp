@@ -0,0 +1,349 @@
+#include "program_image.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+size_t program_image::size() const {
+    size_t total = 0;
+    for (const program_segment& segment : segments) {
+        total += segment.bytes.size();
+    }
+    return total;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Appends to the last segment when contiguous, starts a new one otherwise
+static void append_bytes(program_image& image, uint32_t address, const uint8_t* bytes, size_t count) {
+    if (image.segments.empty()) {
+        image.segments.push_back(program_segment{ (uint16_t)address, {} });
+    } else {
+        const program_segment& last = image.segments.back();
+        if (last.address + last.bytes.size() != address) {
+            image.segments.push_back(program_segment{ (uint16_t)address, {} });
+        }
+    }
+    std::vector<uint8_t>& out = image.segments.back().bytes;
+    out.insert(out.end(), bytes, bytes + count);
+}
+
+bool parse_text_program(const char* text, size_t length, program_image& image, std::string& error) {
+    image = program_image();
+    program_segment segment{ 0x0000, {} };
+    const char* p = text;
+    const char* end = text + length;
+    bool ok = true;
+    while (p < end) {
+        // One token, '#' comments out the rest of the line
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+        if (p == end) break;
+        if (*p == '#') {
+            while (p < end && *p != '\n') ++p;
+            continue;
+        }
+        const char* token = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ++p;
+        // Leading hex digits of the token (an optional 0x prefix), like std::stoi(token, 16)
+        const char* digit = token;
+        if (p - token > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X') && hex_digit(token[2]) >= 0) {
+            digit += 2;
+        }
+        unsigned value = 0;
+        int digits = 0;
+        for (; digit < p && hex_digit(*digit) >= 0; ++digit, ++digits) {
+            value = (value << 4) | hex_digit(*digit);
+        }
+        if (digits == 0) {
+            if (ok) {
+                error = "bad byte: " + std::string(token, p);
+            }
+            ok = false;
+            continue;
+        }
+        segment.bytes.push_back((uint8_t)value);
+    }
+    if (segment.bytes.size() > 0x10000) {
+        segment.bytes.resize(0x10000);
+    }
+    image.segments.push_back(std::move(segment));
+    return ok;
+}
+
+bool parse_intel_hex(const char* text, size_t length, program_image& image, std::string& error) {
+    image = program_image();
+    uint32_t upper = 0; // extended segment or linear address
+    const char* p = text;
+    const char* end = text + length;
+    int line = 0;
+    while (p < end) {
+        const char* eol = std::find(p, end, '\n');
+        const char* record = p;
+        p = eol < end ? eol + 1 : end;
+        ++line;
+        while (eol > record && (eol[-1] == '\r' || eol[-1] == ' ')) --eol;
+        if (record == eol) continue;
+
+        // :LLAAAATT<data>CC, the length byte LL fixes the record size before
+        // anything is stored
+        uint8_t bytes[5 + 255];
+        size_t count = (eol - record - 1) / 2;
+        bool valid = record[0] == ':' && (eol - record) % 2 == 1 && count >= 5;
+        if (valid) {
+            int hi = hex_digit(record[1]), lo = hex_digit(record[2]);
+            valid = hi >= 0 && lo >= 0 && count == 5u + (unsigned)(hi << 4 | lo);
+        }
+        uint8_t checksum = 0;
+        for (size_t i = 0; valid && i < count; ++i) {
+            int hi = hex_digit(record[1 + 2 * i]), lo = hex_digit(record[2 + 2 * i]);
+            valid = hi >= 0 && lo >= 0;
+            bytes[i] = (uint8_t)(hi << 4 | lo);
+            checksum += bytes[i];
+        }
+        if (!valid || checksum != 0) {
+            error = "bad Intel HEX record on line " + std::to_string(line);
+            return false;
+        }
+        const uint8_t* data = bytes + 4;
+        uint32_t address = upper + (bytes[1] << 8 | bytes[2]);
+        uint8_t type = bytes[3];
+        // Address records carry exactly 2 (segment, linear) or 4 (start) bytes
+        if ((type == 0x02 || type == 0x04) && bytes[0] != 2) {
+            error = "bad Intel HEX address record length on line " + std::to_string(line);
+            return false;
+        }
+        if ((type == 0x03 || type == 0x05) && bytes[0] != 4) {
+            error = "bad Intel HEX start address record length on line " + std::to_string(line);
+            return false;
+        }
+        uint32_t start = 0;
+        switch (type) {
+            case 0x00:
+                if (address + bytes[0] > 0x10000) {
+                    error = "Intel HEX data past 0xFFFF on line " + std::to_string(line);
+                    return false;
+                }
+                append_bytes(image, address, data, bytes[0]);
+                break;
+            case 0x01:
+                return true;
+            case 0x02:
+                upper = (data[0] << 8 | data[1]) << 4;
+                break;
+            case 0x03:
+                start = ((data[0] << 8 | data[1]) << 4) + (data[2] << 8 | data[3]);
+                break;
+            case 0x04:
+                upper = (uint32_t)(data[0] << 8 | data[1]) << 16;
+                break;
+            case 0x05:
+                start = (uint32_t)data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+                break;
+            default:
+                error = "unknown Intel HEX record type on line " + std::to_string(line);
+                return false;
+        }
+        if (type == 0x03 || type == 0x05) {
+            if (start > 0xFFFF) {
+                error = "Intel HEX start address past 0xFFFF on line " + std::to_string(line);
+                return false;
+            }
+            image.entry = (int32_t)start;
+        }
+    }
+    error = "Intel HEX without end record";
+    return false;
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+bool parse_segment_image(const uint8_t* data, size_t length, program_image& image, std::string& error) {
+    image = program_image();
+    if (length < 16 || std::memcmp(data, "CPUIMG01", 8) != 0) {
+        error = "not a segment image";
+        return false;
+    }
+    uint32_t count = get_u32(data + 8);
+    image.entry = (int32_t)get_u32(data + 12);
+    size_t offset = 16;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (length - offset < 8) {
+            error = "truncated segment image";
+            return false;
+        }
+        uint16_t address = data[offset] | data[offset + 1] << 8;
+        uint32_t size = get_u32(data + offset + 4);
+        offset += 8;
+        if (length - offset < size || address + size > 0x10000) {
+            error = "bad segment " + std::to_string(i);
+            return false;
+        }
+        image.segments.push_back(program_segment{ address, std::vector<uint8_t>(data + offset, data + offset + size) });
+        offset += size;
+    }
+    if (image.entry < -1 || image.entry > 0xFFFF) {
+        error = "bad entry point";
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> write_segment_image(const program_image& image) {
+    std::vector<uint8_t> out((const uint8_t*)"CPUIMG01", (const uint8_t*)"CPUIMG01" + 8);
+    out.reserve(16 + 8 * image.segments.size() + image.size());
+    put_u32(out, (uint32_t)image.segments.size());
+    put_u32(out, (uint32_t)image.entry);
+    for (const program_segment& segment : image.segments) {
+        out.push_back((uint8_t)segment.address);
+        out.push_back((uint8_t)(segment.address >> 8));
+        out.push_back(0);
+        out.push_back(0);
+        put_u32(out, (uint32_t)segment.bytes.size());
+        out.insert(out.end(), segment.bytes.begin(), segment.bytes.end());
+    }
+    return out;
+}
+
+static bool read_file(const std::string& path, std::vector<uint8_t>& contents) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? size : 0);
+    bool ok = size >= 0 && std::fread(contents.data(), 1, contents.size(), file) == contents.size();
+    std::fclose(file);
+    return ok;
+}
+
+static bool has_extension(const std::string& path, const char* extension) {
+    size_t n = std::strlen(extension);
+    if (path.size() < n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::tolower((unsigned char)path[path.size() - n + i]) != extension[i]) return false;
+    }
+    return true;
+}
+
+static bool is_intel_hex(const std::string& path) {
+    return has_extension(path, ".hex") || has_extension(path, ".ihex");
+}
+
+static bool is_binary(const std::string& path) {
+    return has_extension(path, ".bin") || has_extension(path, ".img");
+}
+
+// Parses file contents by the extension of path
+static bool parse_program(const std::string& path, std::vector<uint8_t>& contents, program_image& image,
+                          std::string& error, uint16_t bin_address) {
+    const char* text = (const char*)contents.data();
+    if (has_extension(path, ".bin")) {
+        image = program_image();
+        contents.resize(std::min<size_t>(contents.size(), 0x10000 - bin_address));
+        image.segments.push_back(program_segment{ bin_address, std::move(contents) });
+        return true;
+    }
+    if (is_intel_hex(path)) {
+        return parse_intel_hex(text, contents.size(), image, error);
+    }
+    if (has_extension(path, ".img")) {
+        return parse_segment_image(contents.data(), contents.size(), image, error);
+    }
+    return parse_text_program(text, contents.size(), image, error);
+}
+
+bool load_program_image(const std::string& path, program_image& image, std::string& error, uint16_t bin_address) {
+    std::vector<uint8_t> contents;
+    if (!read_file(path, contents)) {
+        error = "Cannot open file: " + path;
+        return false;
+    }
+    return parse_program(path, contents, image, error, bin_address);
+}
+
+uint64_t program_hash(const uint8_t* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string program_cache::image_path(uint64_t hash, bool intel_hex) const {
+    static const char digits[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) {
+        name[i] = digits[hash & 0xF];
+    }
+    // The same bytes parse differently as text and as Intel HEX
+    return (std::filesystem::path(dir) / (name + (intel_hex ? ".ihex" : ".text") + ".img")).string();
+}
+
+bool program_cache::load(const std::string& path, program_image& image, std::string& error, uint16_t bin_address) {
+    std::vector<uint8_t> contents;
+    if (!read_file(path, contents)) {
+        error = "Cannot open file: " + path;
+        return false;
+    }
+    if (is_binary(path) || contents.size() < min_source) {
+        return parse_program(path, contents, image, error, bin_address);
+    }
+
+    std::string cached = image_path(program_hash(contents.data(), contents.size()), is_intel_hex(path));
+    std::vector<uint8_t> file;
+    if (read_file(cached, file) && parse_segment_image(file.data(), file.size(), image, error)) {
+        hits++;
+        return true;
+    }
+    misses++;
+    error.clear();
+    if (!parse_program(path, contents, image, error, bin_address)) {
+        return false;
+    }
+
+    // Written under a unique name and renamed, so concurrent runs never read a partial image
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    file = write_segment_image(image);
+    std::string temp = cached + "." + std::to_string(std::random_device()()) + ".tmp";
+    std::FILE* out = std::fopen(temp.c_str(), "wb");
+    if (out) {
+        bool written = std::fwrite(file.data(), 1, file.size(), out) == file.size();
+        written &= std::fclose(out) == 0;
+        if (!written || std::rename(temp.c_str(), cached.c_str()) != 0) {
+            std::remove(temp.c_str());
+        }
+    }
+    return true;
+}
+
+size_t copy_program_image(const program_image& image, uint8_t* mem) {
+    size_t copied = 0;
+    for (const program_segment& segment : image.segments) {
+        size_t count = std::min<size_t>(segment.bytes.size(), 0x10000 - segment.address);
+        std::memcpy(mem + segment.address, segment.bytes.data(), count);
+        copied += count;
+    }
+    if (image.entry >= 0) {
+        mem[0xFFFC] = (uint8_t)image.entry;
+        mem[0xFFFD] = (uint8_t)(image.entry >> 8);
+    }
+    return copied;
+}
@@ -0,0 +1,81 @@
+#include "trace_file.h"
+#include <cstring>
+
+trace_file_writer::trace_file_writer(size_t buffer_records) : buffer(buffer_records ? buffer_records : 1) {
+}
+
+trace_file_writer::~trace_file_writer() {
+    close();
+}
+
+bool trace_file_writer::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    // Records are already batched in buffer
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    trace_file_header_t header;
+    std::memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    written = 0;
+    used = 0;
+    write_error = false;
+    return true;
+}
+
+bool trace_file_writer::close() {
+    if (file) {
+        flush();
+        if (std::fclose(file) != 0) {
+            write_error = true;
+        }
+        file = nullptr;
+    }
+    return !write_error;
+}
+
+bool trace_file_writer::flush() {
+    if (file && used && std::fwrite(buffer.data(), sizeof(trace_record_t), used, file) != used) {
+        write_error = true;
+    }
+    written += used;
+    used = 0;
+    return !write_error;
+}
+
+trace_file_reader::~trace_file_reader() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool trace_file_reader::open(const std::string& path) {
+    if (file) {
+        std::fclose(file);
+    }
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    trace_file_header_t header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1
+        || std::memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != TRACE_FILE_VERSION || header.record_size != sizeof(trace_record_t)) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+size_t trace_file_reader::read(trace_record_t* records, size_t count) {
+    return file ? std::fread(records, sizeof(trace_record_t), count, file) : 0;
+}
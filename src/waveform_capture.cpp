@@ -0,0 +1,151 @@
+#include "waveform_capture.h"
+
+// VCD identifier of the n-th probe, printable characters '!' to '~'
+static std::string vcd_id(size_t n) {
+    std::string id;
+    do {
+        id += (char)('!' + n % 94);
+        n /= 94;
+    } while (n);
+    return id;
+}
+
+bool waveform_capture::open(const std::string& path) {
+    if (window.pre_cycles > MAX_PRE_CYCLES) {
+        return false;
+    }
+    vcd.open(path, std::ios::out | std::ios::trunc);
+    return vcd.is_open();
+}
+
+waveform_capture::~waveform_capture() {
+    if (vcd.is_open()) {
+        vcd.close();
+    }
+}
+
+bool waveform_capture::opens(uint64_t cycle) const {
+    if (cycle < window.start_cycle) {
+        return false;
+    }
+    if (window.on_trigger) {
+        return triggered;
+    }
+    if (window.start_pc >= 0) {
+        return pc_probe && pc_probe->read() == (uint64_t)window.start_pc;
+    }
+    return true;
+}
+
+static uint64_t current_cycle() {
+    const sc_time period(CPU_CLOCK_PERIOD_NS, SC_NS);
+    return sc_time_stamp().value() / period.value();
+}
+
+void waveform_capture::trigger() {
+    triggered = true;
+    if (state == ARMED && window.on_trigger && vcd.is_open() && opens(current_cycle())) {
+        open_window(current_cycle());
+        vcd.flush();
+    }
+}
+
+// Header, then the pre-trigger samples oldest first
+void waveform_capture::open_window(uint64_t cycle) {
+    state = OPEN;
+    bool cycle_window = window.start_pc < 0 && !window.on_trigger;
+    close_cycle = cycle_window ? window.stop_cycle
+                               : std::min(window.stop_cycle, cycle + std::min(window.post_cycles, UINT64_MAX - cycle));
+    write_header();
+    size_t n = probes.size();
+    size_t oldest = (ring_next + window.pre_cycles - ring_used) % (window.pre_cycles ? window.pre_cycles : 1);
+    for (size_t k = 0; k < ring_used; ++k) {
+        size_t slot = (oldest + k) % window.pre_cycles;
+        write_sample(ring_time[slot], &ring[slot * n]);
+    }
+    ring.clear();
+    ring.shrink_to_fit();
+    ring_time.clear();
+}
+
+void waveform_capture::sample() {
+    if (state == CLOSED || !vcd.is_open()) {
+        return;
+    }
+    uint64_t cycle = current_cycle();
+    uint64_t time_ns = (uint64_t)(sc_time_stamp().to_seconds() * 1e9 + 0.5);
+    // Nothing is read before the ring buffer or the file needs it
+    if (state == ARMED && window.pre_cycles == 0 && !opens(cycle)) {
+        return;
+    }
+
+    size_t n = probes.size();
+    current.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        current[i] = probes[i]->read();
+    }
+
+    if (state == ARMED) {
+        if (!opens(cycle)) {
+            // Keep the last pre_cycles samples
+            if (ring.empty()) {
+                ring.resize(window.pre_cycles * n);
+                ring_time.resize(window.pre_cycles);
+            }
+            std::copy(current.begin(), current.end(), ring.begin() + ring_next * n);
+            ring_time[ring_next] = time_ns;
+            ring_next = (ring_next + 1) % window.pre_cycles;
+            ring_used = std::min<size_t>(ring_used + 1, window.pre_cycles);
+            return;
+        }
+        open_window(cycle);
+    }
+
+    if (cycle >= close_cycle) {
+        state = CLOSED;
+        vcd << "#" << time_ns << "\n";
+        vcd.flush();
+        return;
+    }
+    write_sample(time_ns, current.data());
+}
+
+void waveform_capture::write_header() {
+    vcd << "$timescale 1ns $end\n$scope module " << basename() << " $end\n";
+    for (size_t i = 0; i < probes.size(); ++i) {
+        vcd << "$var wire " << probes[i]->width << " " << vcd_id(i) << " " << probes[i]->name << " $end\n";
+    }
+    vcd << "$upscope $end\n$enddefinitions $end\n";
+}
+
+// Values that changed since the last written sample, all of them the first time
+void waveform_capture::write_sample(uint64_t time_ns, const uint64_t* values) {
+    bool first = written == 0;
+    if (first) {
+        last.assign(probes.size(), 0);
+    }
+    vcd << "#" << time_ns << "\n";
+    if (first) {
+        vcd << "$dumpvars\n";
+    }
+    for (size_t i = 0; i < probes.size(); ++i) {
+        if (!first && values[i] == last[i]) {
+            continue;
+        }
+        last[i] = values[i];
+        int width = probes[i]->width;
+        if (width == 1) {
+            vcd << (values[i] & 1 ? '1' : '0') << vcd_id(i) << "\n";
+        } else {
+            vcd << 'b';
+            for (int bit = width - 1; bit >= 0; --bit) {
+                vcd << ((values[i] >> bit) & 1 ? '1' : '0');
+            }
+            vcd << ' ' << vcd_id(i) << "\n";
+        }
+    }
+    if (first) {
+        vcd << "$end\n";
+    }
+    written++;
+}
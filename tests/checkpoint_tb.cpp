@@ -0,0 +1,171 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <filesystem>
+#include "cpu.h"
+#include "cpu_defs.h"
+#include "checkpoint.h"
+
+// Checkpoint file format, and a program checkpointed half way, finished,
+// overwritten and resumed from the checkpoint on the signal-level or
+// loosely-timed model
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+static void test_format() {
+    static uint8_t mem[65536], restored[65536];
+    std::memset(mem, 0, sizeof(mem));
+    mem[0x0000] = 0xA9;
+    mem[0x02FF] = 0x42;
+    mem[0xFFFC] = 0x00;
+    mem[0xFFFD] = 0x04;
+    checkpoint_state_t state = {};
+    state.cycle = 1234;
+    state.pc = 0x0400;
+    state.a = 0x11;
+    state.p = 0x24;
+    state.halted = 1;
+
+    std::vector<uint8_t> file = write_checkpoint(state, mem);
+    check_result("all-zero pages left out", file.size() == 16 + 24 + 32 + 3 * 256);
+
+    checkpoint_state_t read;
+    std::string error;
+    std::memset(restored, 0xEE, sizeof(restored));
+    check_result("round trip", parse_checkpoint(file.data(), file.size(), read, restored, error) &&
+                 std::memcmp(&read, &state, sizeof(state)) == 0 && std::memcmp(mem, restored, sizeof(mem)) == 0);
+
+    std::vector<uint8_t> bad = file;
+    bad[0] = 'X';
+    check_result("bad magic rejected", !parse_checkpoint(bad.data(), bad.size(), read, restored, error));
+    bad = file;
+    bad[8] = CHECKPOINT_VERSION + 1;
+    check_result("unknown version rejected", !parse_checkpoint(bad.data(), bad.size(), read, restored, error));
+    restored[0x02FF] = 0x99;
+    check_result("truncated file rejected, memory untouched",
+                 !parse_checkpoint(file.data(), file.size() - 1, read, restored, error) && restored[0x02FF] == 0x99);
+
+    // A newer writer with a longer state record
+    bad = file;
+    bad[12] = sizeof(checkpoint_state_t) + 8;
+    bad.insert(bad.begin() + 16 + sizeof(checkpoint_state_t), 8, 0x77);
+    check_result("longer state record skipped", parse_checkpoint(bad.data(), bad.size(), read, restored, error) &&
+                 read.pc == 0x0400 && restored[0x02FF] == 0x42);
+}
+
+// LDA #$11 / STA $0200 / LDX #$22 / LDY #$33 | CLC / ADC #$05 / STA $0201 / BRK
+static const uint8_t program[] = { 0xA9, 0x11, 0x8D, 0x00, 0x02, 0xA2, 0x22, 0xA0, 0x33,
+                                   0x18, 0x69, 0x05, 0x8D, 0x01, 0x02, 0x00 };
+static const uint16_t checkpoint_pc = 9;
+
+SC_MODULE(checkpoint_tb) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+    std::string path;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    void run_cycles(int cycles) {
+        for (int i = 0; i < cycles; ++i) {
+            wait(10, SC_NS);
+        }
+    }
+
+    bool finished() {
+        uint8_t stored[2] = {};
+        cpu_i->debug_read(0x0200, stored, 2);
+        return cpu_i->regfile_i->A == 0x16 && cpu_i->regfile_i->X == 0x22 && cpu_i->regfile_i->Y == 0x33 &&
+               stored[0] == 0x11 && stored[1] == 0x16;
+    }
+
+    void run() {
+        cpu_i->debug_write(0x0000, program, sizeof(program));
+        reset.write(true);
+        wait(20, SC_NS);
+        reset.write(false);
+
+        int waited = 0;
+        while (!(cpu_i->at_instruction_boundary() && cpu_i->pc_val == checkpoint_pc) && waited++ < 200) {
+            wait(10, SC_NS);
+        }
+        std::string error;
+        check_result("reached the checkpoint", waited < 200 && cpu_i->regfile_i->Y == 0x33);
+        check_result("save checkpoint", cpu_i->save_checkpoint(path, error));
+        if (!cpu_i->loosely_timed()) {
+            wait(10, SC_NS);
+            check_result("no checkpoint mid-instruction", !cpu_i->save_checkpoint(path, error));
+        }
+
+        run_cycles(100);
+        check_result("program finished", finished());
+
+        // Different program state everywhere the checkpoint covers
+        uint8_t zeros[sizeof(program)] = {};
+        cpu_i->debug_write(0x0000, zeros, sizeof(zeros));
+        cpu_i->debug_write(0x0200, zeros, 2);
+        cpu_i->regfile_i->A = 0;
+        cpu_i->regfile_i->X = 0;
+        cpu_i->regfile_i->Y = 0;
+
+        check_result("restore checkpoint", cpu_i->restore_checkpoint(path, error));
+        check_result("registers restored", cpu_i->regfile_i->A == 0x11 && cpu_i->regfile_i->Y == 0x33 &&
+                     cpu_i->pc_val == checkpoint_pc);
+        run_cycles(100);
+        check_result("resumed run finished", finished());
+        check_result("missing checkpoint reported", !cpu_i->restore_checkpoint(path + ".missing", error) &&
+                     !error.empty());
+
+        std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+        std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(checkpoint_tb);
+
+    checkpoint_tb(sc_module_name name, cpu::cpu_model_t model, const std::string& path)
+        : sc_module(name), path(path) {
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        SC_THREAD(clock_gen);
+        SC_THREAD(run);
+    }
+
+    ~checkpoint_tb() {
+        delete cpu_i;
+    }
+};
+
+int sc_main(int argc, char* argv[]) {
+    // --lt checkpoints the loosely-timed model
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    }
+
+    test_format();
+    std::string path = (std::filesystem::temp_directory_path() / "checkpoint_tb.ckpt").string();
+    checkpoint_tb tb("checkpoint_tb", model, path);
+    sc_start();
+    std::filesystem::remove(path);
+    return tests_failed == 0 ? 0 : 1;
+}
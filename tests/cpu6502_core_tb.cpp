@@ -0,0 +1,399 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <random>
+#include "cpu6502_core.h"
+#include "cpu6502_batch.h"
+
+// Tests for the SystemC-free instruction-set core
+static uint8_t mem[65536];
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+// Clear memory, load program at 0x0000 and reset the core
+static void load_program(cpu6502_core& core, const uint8_t* bytes, size_t length) {
+    memset(mem, 0, sizeof(mem));
+    memcpy(mem, bytes, length);
+    core.reset();
+}
+
+static void test_load_store(cpu6502_core& core) {
+    uint8_t program[] = {
+        0xA9, 0x42,        // LDA #$42
+        0x8D, 0x00, 0x02,  // STA $0200
+        0xA2, 0x05,        // LDX #$05
+        0x9D, 0x00, 0x02,  // STA $0200,X
+        0xA0, 0x80,        // LDY #$80
+        0x00               // BRK
+    };
+    load_program(core, program, sizeof(program));
+    uint64_t executed = core.run_until_brk();
+
+    check_result("LDA/STA abs", core.a == 0x42 && mem[0x0200] == 0x42);
+    check_result("STA abs,X", mem[0x0205] == 0x42);
+    check_result("LDY sets N", core.y == 0x80 && (core.p & FLAG_N) && !(core.p & FLAG_Z));
+    check_result("BRK halts on BRK", core.halted && core.pc == 0x000C && executed == 6);
+}
+
+static void test_adc_sbc(cpu6502_core& core) {
+    uint8_t program[] = {
+        0x18,        // CLC
+        0xA9, 0x7F,  // LDA #$7F
+        0x69, 0x01,  // ADC #$01  -> 0x80, V=1, C=0
+        0x00
+    };
+    load_program(core, program, sizeof(program));
+    core.run_until_brk();
+    check_result("ADC overflow", core.a == 0x80 && (core.p & FLAG_V) && !(core.p & FLAG_C));
+
+    uint8_t program2[] = {
+        0x38,        // SEC
+        0xA9, 0x25,  // LDA #$25
+        0xE9, 0x25,  // SBC #$25  -> 0x00, C=1, Z=1
+        0x00
+    };
+    load_program(core, program2, sizeof(program2));
+    core.run_until_brk();
+    check_result("SBC with carry", core.a == 0x00 && (core.p & FLAG_C) && (core.p & FLAG_Z));
+}
+
+static void test_loop(cpu6502_core& core) {
+    // Sum 10..1 into A using X as counter
+    uint8_t program[] = {
+        0xA9, 0x00,        // LDA #0
+        0xA2, 0x0A,        // LDX #10
+        0x86, 0x80,        // loop: STX $80
+        0x18,              // CLC
+        0x65, 0x80,        // ADC $80
+        0xC6, 0x80,        // DEC $80
+        0xA6, 0x80,        // LDX $80
+        0xD0, 0xF5,        // BNE loop
+        0x00
+    };
+    load_program(core, program, sizeof(program));
+    core.run_until_brk();
+    check_result("Loop with BNE", core.a == 55 && core.x == 0);
+}
+
+static void test_subroutine(cpu6502_core& core) {
+    uint8_t program[] = {
+        0x20, 0x10, 0x00,  // JSR $0010
+        0x48,              // PHA
+        0x68,              // PLA
+        0x00,              // BRK
+    };
+    load_program(core, program, sizeof(program));
+    mem[0x0010] = 0xA9; mem[0x0011] = 0x33;  // LDA #$33
+    mem[0x0012] = 0x60;                      // RTS
+    core.run_until_brk();
+    check_result("JSR/RTS", core.a == 0x33 && core.s == 0xFF && core.pc == 0x0005);
+}
+
+static void test_indirect(cpu6502_core& core) {
+    uint8_t program[] = {
+        0xA2, 0x02,        // LDX #2
+        0xA0, 0x01,        // LDY #1
+        0xA1, 0x20,        // LDA ($20,X) -> ptr at $22
+        0x91, 0x24,        // STA ($24),Y -> [$0300] + 1
+        0x6C, 0xFF, 0x02,  // JMP ($02FF), high byte read from $0200
+    };
+    load_program(core, program, sizeof(program));
+    mem[0x22] = 0x00; mem[0x23] = 0x04; mem[0x0400] = 0x99;
+    mem[0x24] = 0x00; mem[0x25] = 0x03;
+    mem[0x02FF] = 0x40; mem[0x0200] = 0x00;  // target $0040
+    mem[0x0040] = 0x00;                      // BRK
+    core.run_until_brk();
+    check_result("LDA (ind,X)", core.a == 0x99);
+    check_result("STA (ind),Y", mem[0x0301] == 0x99);
+    check_result("JMP (ind) page wrap", core.pc == 0x0040);
+}
+
+static void test_shifts_compare(cpu6502_core& core) {
+    uint8_t program[] = {
+        0xA9, 0x81,  // LDA #$81
+        0x0A,        // ASL A  -> 0x02, C=1
+        0x6A,        // ROR A  -> 0x81, C=0
+        0xC9, 0x81,  // CMP #$81 -> Z=1, C=1
+        0x00
+    };
+    load_program(core, program, sizeof(program));
+    core.run_until_brk();
+    check_result("ASL/ROR/CMP", core.a == 0x81 && (core.p & FLAG_C) && (core.p & FLAG_Z));
+}
+
+static void test_run_n(cpu6502_core& core) {
+    // JMP to itself never halts, run() must stop after n instructions
+    uint8_t program[] = { 0x4C, 0x00, 0x00 };
+    load_program(core, program, sizeof(program));
+    uint64_t executed = core.run(1000);
+    check_result("run(n) bound", executed == 1000 && !core.halted && core.instructions == 1000);
+    check_result("step()", core.step() && core.instructions == 1001);
+}
+
+static void test_dispatch_modes(cpu6502_core& core) {
+    // Same loop as test_loop through every dispatcher
+    uint8_t program[] = {
+        0xA9, 0x00, 0xA2, 0x0A, 0x86, 0x80, 0x18, 0x65, 0x80,
+        0xC6, 0x80, 0xA6, 0x80, 0xD0, 0xF5, 0x00
+    };
+    load_program(core, program, sizeof(program));
+    uint64_t executed = core.run(1000);
+    uint64_t cycles = core.cycles;
+
+    load_program(core, program, sizeof(program));
+    bool same_switch = core.run_switch(1000) == executed && core.cycles == cycles && core.a == 55 && core.halted;
+
+    load_program(core, program, sizeof(program));
+    bool same_threaded = core.run_threaded(1000) == executed && core.cycles == cycles && core.a == 55 && core.halted;
+    check_result("run_switch matches run", same_switch);
+    check_result("run_threaded matches run", same_threaded);
+
+    // Bound on the instruction count, also for the threaded loop
+    uint8_t spin[] = { 0x4C, 0x00, 0x00 };
+    load_program(core, spin, sizeof(spin));
+    check_result("run_threaded(n) bound", core.run_threaded(777) == 777 && core.instructions == 777);
+}
+
+// Bus reporting every write to a block cache, as memory::write_mem does
+struct cached_bus {
+    uint8_t* mem;
+    cpu6502_block_cache* cache;
+
+    uint8_t read(uint16_t addr) { return mem[addr]; }
+    void write(uint16_t addr, uint8_t data) { mem[addr] = data; cache->invalidate_write(addr); }
+};
+
+static void test_block_cache() {
+    cpu6502_block_cache cache;
+    cpu6502_core_t<cached_bus> core(cached_bus{ mem, &cache });
+
+    // Counter at $0280: a store to the page holding the code would drop the block
+    uint8_t loop[] = {
+        0xA9, 0x00,        // LDA #0
+        0xA2, 0x0A,        // LDX #10
+        0x8E, 0x80, 0x02,  // loop: STX $0280
+        0x18,              // CLC
+        0x6D, 0x80, 0x02,  // ADC $0280
+        0xCE, 0x80, 0x02,  // DEC $0280
+        0xAE, 0x80, 0x02,  // LDX $0280
+        0xD0, 0xF1,        // BNE loop
+        0x00
+    };
+    memset(mem, 0, sizeof(mem));
+    memcpy(mem, loop, sizeof(loop));
+    core.reset();
+    uint64_t executed = core.run(1000);
+    uint64_t cycles = core.cycles;
+
+    memcpy(mem, loop, sizeof(loop));
+    core.reset();
+    bool same = core.run_cached(cache, 1000) == executed && core.cycles == cycles && core.a == 55;
+    check_result("run_cached matches run", same);
+    // blocks at $0000, loop ($0004, 1 miss + 8 hits) and BRK
+    check_result("Block cache hits", cache.misses == 3 && cache.hits == 8 && cache.invalidations == 0);
+
+    // STA rewrites the immediate of the next LDA, inside the running block
+    uint8_t smc[] = {
+        0xA9, 0x07,        // LDA #$07
+        0x8D, 0x06, 0x00,  // STA $0006
+        0xA9, 0x00,        // LDA #$00 -> LDA #$07
+        0x00
+    };
+    memset(mem, 0, sizeof(mem));
+    memcpy(mem, smc, sizeof(smc));
+    cache.clear();
+    cache.reset_counters();
+    core.reset();
+    core.run_cached(cache, 100);
+    check_result("Self-modifying code", core.a == 0x07 && cache.invalidations == 1 && core.halted);
+}
+
+// Full machine state after n instructions of the interpreter and of the JIT
+template <class A, class B>
+static bool same_state(const A& a, const B& b) {
+    return a.a == b.a && a.x == b.x && a.y == b.y && a.s == b.s && a.p == b.p && a.pc == b.pc
+        && a.halted == b.halted && a.instructions == b.instructions && a.cycles == b.cycles;
+}
+
+static void test_jit() {
+    if (!CPU6502_JIT) {
+        std::cout << "[SKIP] JIT not supported on this host" << std::endl;
+        return;
+    }
+    static uint8_t ref_mem[65536];
+    cpu6502_block_cache cache;
+    cpu6502_jit jit(cache, 2);
+    cpu6502_core_t<cached_bus> core(cached_bus{ mem, &cache });
+    cpu6502_core ref(ref_mem);
+    check_result("JIT arena mapped", jit.available());
+
+    // Loop from test_block_cache: $0004 runs 9 times, the second run translates it
+    // and stays in native code for the remaining iterations
+    uint8_t loop[] = {
+        0xA9, 0x00, 0xA2, 0x0A, 0x8E, 0x80, 0x02, 0x18, 0x6D, 0x80, 0x02,
+        0xCE, 0x80, 0x02, 0xAE, 0x80, 0x02, 0xD0, 0xF1, 0x00
+    };
+    memset(ref_mem, 0, sizeof(ref_mem));
+    memcpy(ref_mem, loop, sizeof(loop));
+    memcpy(mem, ref_mem, sizeof(mem));
+    ref.reset();
+    ref.run(1000);
+    core.reset();
+    core.run_jit(jit, 1000);
+    check_result("run_jit matches run", same_state(core, ref) && core.a == 55 && jit.translations == 1
+                 && jit.native_runs == 1);
+
+    // Native self-loop still stops at the instruction bound
+    uint8_t spin[] = { 0x4C, 0x00, 0x00 };
+    memset(mem, 0, sizeof(mem));
+    memcpy(mem, spin, sizeof(spin));
+    cache.clear();
+    core.reset();
+    core.run_jit(jit, 10);
+    check_result("run_jit(n) bound", core.run_jit(jit, 777) == 777 && core.instructions == 787 && core.cycles == 787 * 3);
+
+    // STA rewrites the LDA immediate of its own block once it runs natively,
+    // the translated code has to leave right after the store
+    uint8_t smc[] = {
+        0xA9, 0x07,        // loop: LDA #$07
+        0x8D, 0x06, 0x00,  // STA $0006
+        0xA9, 0x00,        // LDA #$00 -> LDA #$07
+        0x69, 0x01,        // ADC #1
+        0x8D, 0x01, 0x00,  // STA $0001
+        0x4C, 0x00, 0x00   // JMP loop
+    };
+    memset(ref_mem, 0, sizeof(ref_mem));
+    memcpy(ref_mem, smc, sizeof(smc));
+    memcpy(mem, ref_mem, sizeof(mem));
+    ref.reset();
+    ref.run(60);
+    cache.clear();
+    cache.reset_counters();
+    core.reset();
+    core.run_jit(jit, 60);
+    check_result("JIT self-modifying code", same_state(core, ref) && !memcmp(mem, ref_mem, sizeof(mem))
+                 && cache.invalidations > 0);
+
+    // Random memory, every block translated on first use
+    cpu6502_jit eager(cache, 1);
+    std::mt19937 rng(6502);
+    bool same = true;
+    for (int seed = 0; seed < 300 && same; ++seed) {
+        for (size_t i = 0; i < sizeof(ref_mem); ++i) ref_mem[i] = (uint8_t)rng();
+        memcpy(mem, ref_mem, sizeof(mem));
+        uint16_t start = (uint16_t)rng();
+        uint8_t p = (uint8_t)rng() | FLAG_U;
+        ref.reset(start);
+        ref.p = p;
+        ref.run(2000);
+        cache.clear();
+        core.reset(start);
+        core.p = p;
+        core.run_jit(eager, 2000);
+        same = same_state(core, ref) && !memcmp(mem, ref_mem, sizeof(mem));
+    }
+    check_result("JIT matches interpreter on random code", same && eager.translations > 0);
+}
+
+// Lane of the batch against the interpreter
+static bool same_lane(cpu6502_batch& batch, int lane, const cpu6502_core& ref, const uint8_t* ref_mem) {
+    return batch.a[lane] == ref.a && batch.x[lane] == ref.x && batch.y[lane] == ref.y && batch.s[lane] == ref.s
+        && batch.p[lane] == ref.p && batch.pc[lane] == ref.pc && ((batch.halted >> lane) & 1) == ref.halted
+        && batch.instructions[lane] == ref.instructions && batch.cycles[lane] == ref.cycles
+        && !memcmp(batch.memory(lane), ref_mem, 65536);
+}
+
+static void test_batch() {
+    std::cout << "Batch SIMD: " << cpu6502_batch::simd() << std::endl;
+    static uint8_t ref_mem[65536];
+    cpu6502_core ref(ref_mem);
+    cpu6502_batch batch;
+
+    // Loop from test_block_cache with X = lane + 1: every lane sums 1..X,
+    // the lanes reach BRK one after another and drop out of the batch
+    uint8_t loop[] = {
+        0xA9, 0x00, 0xA2, 0x0A, 0x8E, 0x80, 0x02, 0x18, 0x6D, 0x80, 0x02,
+        0xCE, 0x80, 0x02, 0xAE, 0x80, 0x02, 0xD0, 0xF1, 0x00
+    };
+    for (int lane = 0; lane < batch.lanes(); ++lane) {
+        loop[3] = (uint8_t)(lane + 1);
+        memset(batch.memory(lane), 0, 65536);
+        memcpy(batch.memory(lane), loop, sizeof(loop));
+    }
+    batch.reset();
+    uint64_t total = batch.run(100000);
+    bool same = batch.running() == 0;
+    uint64_t expected = 0;
+    for (int lane = 0; lane < batch.lanes() && same; ++lane) {
+        loop[3] = (uint8_t)(lane + 1);
+        memset(ref_mem, 0, sizeof(ref_mem));
+        memcpy(ref_mem, loop, sizeof(loop));
+        ref.reset();
+        expected += ref.run(100000);
+        same = same_lane(batch, lane, ref, ref_mem) && batch.a[lane] == (uint8_t)((lane + 1) * (lane + 2) / 2);
+    }
+    check_result("Batch lanes match interpreter", same && total == expected && batch.vector_groups > 0);
+
+    // Random memory, start and flags in every lane: diverging lanes, all opcodes
+    std::mt19937 rng(6510);
+    same = true;
+    for (int round = 0; round < 20 && same; ++round) {
+        std::vector<uint16_t> start(batch.lanes());
+        std::vector<uint8_t> flags(batch.lanes());
+        std::vector<std::vector<uint8_t> > image(batch.lanes(), std::vector<uint8_t>(65536));
+        for (int lane = 0; lane < batch.lanes(); ++lane) {
+            for (uint8_t& b : image[lane]) b = (uint8_t)rng();
+            memcpy(batch.memory(lane), image[lane].data(), 65536);
+            start[lane] = (uint16_t)rng();
+            flags[lane] = (uint8_t)rng() | FLAG_U;
+        }
+        batch.reset();
+        for (int lane = 0; lane < batch.lanes(); ++lane) {
+            batch.pc[lane] = start[lane];
+            batch.p[lane] = flags[lane];
+        }
+        batch.run(2000);
+        for (int lane = 0; lane < batch.lanes() && same; ++lane) {
+            memcpy(ref_mem, image[lane].data(), 65536);
+            ref.reset(start[lane]);
+            ref.p = flags[lane];
+            ref.run(2000);
+            same = same_lane(batch, lane, ref, ref_mem);
+        }
+    }
+    check_result("Batch matches interpreter on random code", same);
+}
+
+int sc_main(int, char**) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "   cpu6502_core Test Suite" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    cpu6502_core core(mem);
+    test_load_store(core);
+    test_adc_sbc(core);
+    test_loop(core);
+    test_subroutine(core);
+    test_indirect(core);
+    test_shifts_compare(core);
+    test_run_n(core);
+    test_dispatch_modes(core);
+    test_block_cache();
+    test_jit();
+    test_batch();
+
+    std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+    std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #include <systemc.h>
 #include <iostream>
 #include <iomanip>
+#include <cstring>
 #include "cpu.h"
 #include "cpu_defs.h"
 
@@ -14,10 +15,12 @@ SC_MODULE(cpu_tb) {
     int tests_passed = 0;
     int tests_failed = 0;
 
-    // Helper function to load a simple instruction sequence into memory
+    // Helper function to load a simple instruction sequence into memory,
+    // through the CPU's TLM debug transport
     void load_instruction(uint16_t addr, uint8_t* bytes, size_t length) {
-        for (size_t i = 0; i < length; ++i) {
-            cpu_i->memory_i->mem[addr + i] = bytes[i];
+        unsigned loaded = cpu_i->debug_write(addr, bytes, (unsigned)length);
+        if (loaded != length) {
+            std::cout << "ERROR: loaded " << loaded << " of " << length << " bytes" << std::endl;
         }
     }
 
@@ -206,6 +209,31 @@ SC_MODULE(cpu_tb) {
         check_result("LDA #0x80 (Negative Flag)", test_passed);
     }
 
+    // Test memory access through the TLM-2.0 sockets
+    void test_tlm_access() {
+        std::cout << "\n=== Testing TLM memory access ===" << std::endl;
+
+        // transport_dbg both ways
+        uint8_t pattern[] = {0xDE, 0xAD, 0xBE, 0xEF};
+        uint8_t readback[4] = {};
+        load_instruction(0x0300, pattern, 4);
+        bool debug_ok = cpu_i->debug_read(0x0300, readback, 4) == 4 && memcmp(pattern, readback, 4) == 0;
+        // Clamped at the end of the address space
+        debug_ok = debug_ok && cpu_i->debug_read(0xFFFE, readback, 4) == 2;
+        check_result("TLM transport_dbg round trip", debug_ok);
+
+        // Loosely-timed models fetch through DMI and store with b_transport
+        if (cpu_i->loosely_timed()) {
+            uint8_t program[] = {0xA9, 0x5A, 0x8D, 0x00, 0x02, 0x00};  // LDA #0x5A, STA $0200, BRK
+            load_instruction(0x0000, program, sizeof(program));
+            reset_cpu();
+            run_cycles(30);
+            uint8_t stored = 0;
+            cpu_i->debug_read(0x0200, &stored, 1);
+            check_result("TLM DMI fetch, b_transport store", cpu_i->lt_core.bus.dmi != nullptr && stored == 0x5A);
+        }
+    }
+
     // Main test runner
     void run_tests() {
         std::cout << "\n========================================" << std::endl;
@@ -218,6 +246,7 @@ SC_MODULE(cpu_tb) {
         test_lda_absolute();
         test_lda_zero_flag();
         test_lda_negative_flag();
+        test_tlm_access();
 
         // TODO: Add more instruction tests here
         // test_ldx_immediate();
@@ -238,9 +267,11 @@ SC_MODULE(cpu_tb) {
         sc_stop();
     }
 
-    SC_CTOR(cpu_tb) {
+    SC_HAS_PROCESS(cpu_tb);
+
+    cpu_tb(sc_module_name name, cpu::cpu_model_t model = cpu::SIGNAL_LEVEL) : sc_module(name) {
         // Instantiate CPU
-        cpu_i = new cpu("cpu_i");
+        cpu_i = new cpu("cpu_i", model);
         cpu_i->clk(clk);
         cpu_i->reset(reset);
 
@@ -255,7 +286,19 @@ SC_MODULE(cpu_tb) {
 };
 
 int sc_main(int argc, char* argv[]) {
-    cpu_tb tb("cpu_tb");
+    // --lt runs the same tests against the loosely-timed model,
+    // --bundled against the signal-level model with one control word signal,
+    // --fast against the loosely-timed model running decoded basic blocks
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    } else if (argc > 1 && std::string(argv[1]) == "--bundled") {
+        model = cpu::BUNDLED_CONTROL;
+    } else if (argc > 1 && std::string(argv[1]) == "--fast") {
+        model = cpu::BLOCK_CACHED;
+    }
+
+    cpu_tb tb("cpu_tb", model);
     sc_start();
     return 0;
 }
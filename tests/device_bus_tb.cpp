@@ -0,0 +1,131 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include "cpu.h"
+#include "cpu_defs.h"
+#include "device_bus.h"
+
+// Address decoding of device_bus, and a program reading and writing a
+// device through memory on the signal-level or loosely-timed model
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+// Register file of four bytes, reads return 0x5A + offset
+struct test_device : bus_device {
+    unsigned reads = 0, writes = 0;
+    uint16_t last_offset = 0xFFFF;
+    uint8_t last_data = 0;
+    bool side_effects = true;
+
+    uint8_t read(uint16_t offset) override {
+        reads++;
+        return 0x5A + offset;
+    }
+    void write(uint16_t offset, uint8_t data) override {
+        writes++;
+        last_offset = offset;
+        last_data = data;
+    }
+    bool read_side_effects() const override { return side_effects; }
+};
+
+static void test_decode() {
+    device_bus bus;
+    test_device a, b;
+    uint16_t offset = 0;
+
+    check_result("empty bus decodes to RAM", !bus.is_device(0x0000) && !bus.is_device(0xFFFF));
+    check_result("map inside a page", bus.map(0xD010, 4, &a));
+    check_result("decode base", bus.decode(0xD010, offset) == &a && offset == 0);
+    check_result("decode last byte", bus.decode(0xD013, offset) == &a && offset == 3);
+    check_result("hole in a device page is RAM", !bus.is_device(0xD00F) && !bus.is_device(0xD014));
+    check_result("overlap rejected", !bus.map(0xD012, 8, &b));
+    check_result("range past 64KB rejected", !bus.map(0xFFF0, 0x20, &b));
+    check_result("map across pages", bus.map(0xD0F0, 0x20, &b));
+    check_result("decode second page", bus.decode(0xD105, offset) == &b && offset == 0x15);
+    check_result("read side effects block DMI", !bus.dmi_readable());
+    bus.unmap(&a);
+    bus.unmap(&b);
+    check_result("unmap back to RAM", !bus.is_device(0xD010) && !bus.is_device(0xD105) && bus.dmi_readable());
+}
+
+SC_MODULE(device_bus_tb) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+    test_device device;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    void run() {
+        check_result("map device at 0xD000", cpu_i->memory_i->map_device(0xD000, 4, &device));
+        check_result("output ports still mapped", cpu_i->memory_i->is_device(0xFF02));
+
+        // LDA $D001 / STA $D002 / STA $0200 / BRK
+        uint8_t program[] = { 0xAD, 0x01, 0xD0, 0x8D, 0x02, 0xD0, 0x8D, 0x00, 0x02, 0x00 };
+        cpu_i->debug_write(0x0000, program, sizeof(program));
+        reset.write(true);
+        wait(20, SC_NS);
+        reset.write(false);
+        wait(10, SC_NS);
+        for (int i = 0; i < 100; ++i) {
+            wait(10, SC_NS);
+        }
+
+        uint8_t stored = 0;
+        cpu_i->debug_read(0x0200, &stored, 1);
+        check_result("device read reaches A", cpu_i->regfile_i->A == 0x5B);
+        check_result("device read", device.reads >= 1);
+        check_result("device write", device.writes == 1 && device.last_offset == 2 && device.last_data == 0x5B);
+        check_result("RAM write beside the device", stored == 0x5B);
+        check_result("no DMI with a side-effect device", !cpu_i->request_dmi());
+
+        std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+        std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(device_bus_tb);
+
+    device_bus_tb(sc_module_name name, cpu::cpu_model_t model) : sc_module(name) {
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        SC_THREAD(clock_gen);
+        SC_THREAD(run);
+    }
+
+    ~device_bus_tb() {
+        delete cpu_i;
+    }
+};
+
+int sc_main(int argc, char* argv[]) {
+    // --lt runs the program on the loosely-timed model (reads through b_transport)
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    }
+
+    test_decode();
+    device_bus_tb tb("device_bus_tb", model);
+    sc_start();
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <systemc.h>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "io_sink.h"
+
+// Output port sinks: record text, a file sink writing several buffers' worth,
+// flushing on demand, cycle stamps and the stream and buffer sinks
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static const std::string log_rule = "=====================================\n";
+static const std::string plain_header = "=== CPU - Output Ports Log ===\nFormat: VALUE (port values concatenated)\n" + log_rule;
+static const std::string stamped_header = "=== CPU - Output Ports Log ===\nFormat: [CYCLE] PORT n: VALUE\n" + log_rule;
+
+// Every port in turn, the values running through 0-255
+static std::vector<io_record_t> make_records(size_t count) {
+    std::vector<io_record_t> records;
+    for (size_t i = 0; i < count; ++i) {
+        records.push_back(io_record_t{ 100 + i * 7, (uint8_t)(i % 4), (uint8_t)(i * 37) });
+    }
+    return records;
+}
+
+static std::string sink_text(const std::vector<io_record_t>& records, bool stamp_cycles) {
+    io_buffer_sink sink(stamp_cycles);
+    for (const io_record_t& r : records) {
+        sink.write(r);
+    }
+    return sink.text;
+}
+
+static void test_record_text() {
+    char text[48];
+    io_record_t record = { 123, 0, 42 };
+    check_result("port 0 decimal", std::string(text, io_port_text(record, text)) == "42");
+    record.port = 1;
+    check_result("port 1 hex", std::string(text, io_port_text(record, text)) == "0x2a");
+    record.port = 2;
+    check_result("port 2 character", std::string(text, io_port_text(record, text)) == "*");
+    record.port = 3;
+    check_result("port 3 binary", std::string(text, io_port_text(record, text)) == "00101010");
+    check_result("cycle stamp", std::string(text, io_format_record(record, true, text)) == "[123] PORT 3: 00101010\n");
+    record.cycle = UINT64_MAX;
+    size_t length = io_format_record(record, true, text);
+    check_result("longest stamped record fits", length <= 48 &&
+                 std::string(text, length) == "[18446744073709551615] PORT 3: 00101010\n");
+    check_result("console message", io_port_message(io_record_t{ 0, 2, 'A' }) == "PORT 2 (CHR): 'A'");
+}
+
+static void test_file_sink(const std::string& path, bool stamp_cycles) {
+    // 200 records through the smallest buffer, 64 bytes: dozens of buffer flushes
+    std::vector<io_record_t> records = make_records(200);
+    std::string expected = (stamp_cycles ? stamped_header : plain_header) + sink_text(records, stamp_cycles);
+    std::string mode = stamp_cycles ? " (stamped)" : " (plain)";
+    {
+        io_file_sink sink(path, stamp_cycles, 64);
+        check_result("file sink open" + mode, sink.is_open());
+        for (const io_record_t& r : records) {
+            sink.write(r);
+        }
+        check_result("buffered until flushed" + mode, read_file(path) != expected);
+        sink.flush();
+        check_result("flush on demand" + mode, read_file(path) == expected);
+
+        sink.write(records[0]);
+        std::string more = expected + sink_text({ records[0] }, stamp_cycles);
+        check_result("writes after a flush" + mode, read_file(path) == expected);
+        sink.flush();
+        check_result("second flush" + mode, read_file(path) == more);
+        sink.write(records[1]);
+        expected = more + sink_text({ records[1] }, stamp_cycles);
+    }
+    check_result("flushed when destroyed" + mode, read_file(path) == expected);
+}
+
+static void test_other_sinks() {
+    std::vector<io_record_t> records = make_records(8);
+    std::ostringstream out;
+    io_stream_sink stream(out, true);
+    io_buffer_sink buffer(true);
+    for (const io_record_t& r : records) {
+        stream.write(r);
+        buffer.write(r);
+    }
+    stream.flush();
+    check_result("stream sink", out.str() == buffer.text && buffer.records.size() == records.size() &&
+                 buffer.text.compare(0, 19, "[100] PORT 0: 0\n[10") == 0);
+    buffer.clear();
+    check_result("buffer sink cleared", buffer.records.empty() && buffer.text.empty());
+
+    size_t seen = 0;
+    io_callback_sink callback([&](const io_record_t& r) { seen += r.port == records[seen].port; });
+    for (const io_record_t& r : records) {
+        callback.write(r);
+    }
+    check_result("callback sink", seen == records.size());
+
+    io_file_sink missing("/nonexistent-dir/io_output.txt");
+    missing.write(records[0]);
+    missing.flush();
+    check_result("unopened file sink ignores writes", !missing.is_open());
+}
+
+int sc_main(int, char**) {
+    std::string path = (std::filesystem::temp_directory_path() / "io_sink_tb.txt").string();
+    test_record_text();
+    test_file_sink(path, false);
+    test_file_sink(path, true);
+    test_other_sinks();
+    std::filesystem::remove(path);
+
+    std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+    std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include "cpu.h"
+#include "cpu_defs.h"
+#include "lockstep.h"
+
+// Golden reference checker on its own, then checking a program on the
+// signal-level or loosely-timed model in lockstep, and the first divergence
+// stopping the simulation
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+static bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+static void test_checker() {
+    static uint8_t mem[65536];
+    std::memset(mem, 0, sizeof(mem));
+    // LDA #$05 / STA $0200 / BRK
+    const uint8_t program[] = { 0xA9, 0x05, 0x8D, 0x00, 0x02, 0x00 };
+    std::memcpy(mem, program, sizeof(program));
+    const lockstep_state_t power_on = { 0x0000, 0, 0, 0, 0xFF, 0x20 };
+    const lockstep_state_t loaded = { 0x0002, 0x05, 0, 0, 0xFF, 0x20 };
+    const lockstep_state_t stored = { 0x0005, 0x05, 0, 0, 0xFF, 0x20 };
+
+    lockstep_checker checker;
+    checker.start(mem, power_on);
+    bool ok = checker.retire(loaded);
+    checker.model_write(0x0200, 0x05);
+    ok = ok && checker.retire(stored);
+    ok = ok && checker.retire(stored); // BRK stays on its address
+    check_result("matching run", ok && !checker.failed() && checker.instructions() == 3 && checker.report().empty());
+
+    checker.start(mem, power_on);
+    lockstep_state_t wrong = loaded;
+    wrong.a = 0x06;
+    check_result("register divergence", !checker.retire(wrong) && checker.failed() &&
+                 contains(checker.report(), "instruction 1, $0000: A9 05     LDA") &&
+                 contains(checker.report(), "differs:  A\n"));
+    std::string report = checker.report();
+    check_result("stops at the first divergence", !checker.retire(loaded) && checker.report() == report);
+
+    checker.start(mem, power_on);
+    checker.retire(loaded);
+    checker.model_write(0x0201, 0x05);
+    check_result("write divergence", !checker.retire(stored) &&
+                 contains(checker.report(), "writes [0200]=05") && contains(checker.report(), "writes [0201]=05") &&
+                 contains(checker.report(), "differs:  writes\n"));
+
+    checker.start(mem, power_on);
+    checker.model_write(0x0200, 0x05);
+    check_result("block of instructions", checker.retire(stored, 2) && checker.instructions() == 2);
+
+    // The model stores into a device, the reference compares without storing
+    device_bus devices;
+    struct : bus_device {
+        uint8_t read(uint16_t) override { return 0; }
+        void write(uint16_t, uint8_t) override {}
+    } port;
+    devices.map(0x0200, 1, &port);
+    checker.devices = &devices;
+    mem[0x0005] = 0xAD; // LDA $0200, reads the RAM behind the device
+    mem[0x0006] = 0x00;
+    mem[0x0007] = 0x02;
+    mem[0x0200] = 0x77;
+    checker.start(mem, power_on);
+    checker.retire(loaded);
+    checker.model_write(0x0200, 0x05);
+    checker.retire(stored);
+    const lockstep_state_t reread = { 0x0008, 0x77, 0, 0, 0xFF, 0x20 };
+    check_result("device writes not stored", checker.retire(reread));
+}
+
+// LDA #$11 / STA $0200 / LDX #$22 / LDY #$33 / CLC / ADC #$05 / STA $0201 / BRK
+static const uint8_t program[] = { 0xA9, 0x11, 0x8D, 0x00, 0x02, 0xA2, 0x22, 0xA0, 0x33,
+                                   0x18, 0x69, 0x05, 0x8D, 0x01, 0x02, 0x00 };
+// LDA $FE00 / STA $0202 / BRK, the device at $FE00 reads 0x42, the reference the RAM behind it
+static const uint8_t device_program[] = { 0xAD, 0x00, 0xFE, 0x8D, 0x02, 0x02, 0x00 };
+
+struct constant_device : bus_device {
+    uint8_t read(uint16_t) override { return 0x42; }
+    void write(uint16_t, uint8_t) override {}
+};
+
+SC_MODULE(lockstep_tb) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+    lockstep_checker checker;
+    constant_device device;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    void boot() {
+        reset.write(true);
+        wait(20, SC_NS);
+        reset.write(false);
+        for (int i = 0; i < 120; ++i) {
+            wait(10, SC_NS);
+        }
+    }
+
+    void run() {
+        cpu_i->set_lockstep(&checker);
+        cpu_i->debug_write(0x0000, program, sizeof(program));
+        boot();
+        check_result("program checked to BRK", !checker.failed() && checker.instructions() == 8);
+        check_result("program ran", cpu_i->regfile_i->A == 0x16 && cpu_i->memory_i->mem[0x0201] == 0x16);
+
+        // Stopped by the divergence, checked in sc_main
+        cpu_i->memory_i->map_device(0xFE00, 1, &device);
+        cpu_i->debug_write(0x0000, device_program, sizeof(device_program));
+        boot();
+        std::cout << "Simulation not stopped by the divergence" << std::endl;
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(lockstep_tb);
+
+    lockstep_tb(sc_module_name name, cpu::cpu_model_t model) : sc_module(name) {
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        SC_THREAD(clock_gen);
+        SC_THREAD(run);
+    }
+
+    ~lockstep_tb() {
+        delete cpu_i;
+    }
+};
+
+int sc_main(int argc, char* argv[]) {
+    // --lt checks the loosely-timed model
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    }
+
+    test_checker();
+    lockstep_tb tb("lockstep_tb", model);
+    sc_start();
+    check_result("divergence stops the simulation", tb.checker.failed() &&
+                 contains(tb.checker.report(), "instruction 1, $0000: AD 00 FE  LDA") &&
+                 tb.cpu_i->memory_i->mem[0x0202] == 0);
+
+    std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+    std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include "cpu.h"
+#include "cpu_defs.h"
+#include "memory_snapshot.h"
+
+// Copy-on-write page snapshots, and one booted program forked into several
+// runs with different inputs on the signal-level or loosely-timed model
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+static void test_tracker() {
+    static uint8_t mem[65536];
+    std::memset(mem, 0, sizeof(mem));
+    memory_page_tracker tracker;
+    mem[0x1234] = 0x01;
+
+    memory_snapshot s0 = tracker.snapshot(mem);
+    check_result("first snapshot", !s0.empty() && s0.read(0x1234) == 0x01 && tracker.dirty_pages() == 0);
+
+    mem[0x0200] = 0x05;
+    tracker.mark(0x0200);
+    mem[0x0201] = 0x06;
+    tracker.mark(0x0201);
+    check_result("one dirty page", tracker.dirty_pages() == 1);
+    check_result("diff against the array", tracker.diff(s0, mem) == std::vector<uint8_t>({ 0x02 }));
+
+    memory_snapshot s1 = tracker.snapshot(mem);
+    check_result("unwritten pages shared", s1.shares_page(s0, 0x12) && s1.shares_page(s0, 0x00) &&
+                 !s1.shares_page(s0, 0x02) && s1.read(0x0201) == 0x06);
+    check_result("diff of two snapshots", memory_page_tracker::diff(s0, s1) == std::vector<uint8_t>({ 0x02 }));
+
+    std::vector<uint8_t> copied = tracker.restore(s0, mem);
+    check_result("restore copies the changed page", copied == std::vector<uint8_t>({ 0x02 }) &&
+                 mem[0x0200] == 0 && mem[0x1234] == 0x01);
+    copied = tracker.restore(s1, mem);
+    check_result("restore forward", copied.size() == 1 && mem[0x0200] == 0x05);
+
+    mem[0x0300] = 0x00;
+    tracker.mark(0x0300);
+    memory_snapshot s2 = tracker.snapshot(mem);
+    check_result("page written back unchanged stays shared", s2.shares_page(s1, 0x03));
+
+    mem[0x0500] = 0x09;
+    tracker.mark(0x0500);
+    copied = tracker.restore(s2, mem);
+    check_result("restore drops dirty pages", copied == std::vector<uint8_t>({ 0x05 }) && mem[0x0500] == 0 &&
+                 tracker.diff(s2, mem).empty());
+}
+
+// LDA $0300 / CLC / ADC #$01 / STA $0301 / BRK, input at $0300
+static const uint8_t program[] = { 0xAD, 0x00, 0x03, 0x18, 0x69, 0x01, 0x8D, 0x01, 0x03, 0x00 };
+
+SC_MODULE(memory_snapshot_tb) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    void run() {
+        cpu_i->debug_write(0x0000, program, sizeof(program));
+        memory_snapshot booted = cpu_i->memory_i->snapshot();
+
+        for (uint8_t input : { 0x10, 0x20, 0x7F }) {
+            size_t copied = cpu_i->memory_i->restore(booted);
+            cpu_i->debug_write(0x0300, &input, 1);
+            reset.write(true);
+            wait(20, SC_NS);
+            reset.write(false);
+            for (int i = 0; i < 60; ++i) {
+                wait(10, SC_NS);
+            }
+
+            uint8_t result = 0;
+            cpu_i->debug_read(0x0301, &result, 1);
+            std::string run = "run with input " + std::to_string(input);
+            check_result(run, result == input + 1 && cpu_i->regfile_i->A == input + 1);
+            check_result(run + " touched one page", cpu_i->memory_i->diff(booted) == std::vector<uint8_t>({ 0x03 }));
+            check_result(run + " restored in one page", input == 0x10 ? copied == 0 : copied == 1);
+        }
+        cpu_i->memory_i->restore(booted);
+        check_result("back to the booted memory", cpu_i->memory_i->diff(booted).empty() &&
+                     cpu_i->memory_i->mem[0x0301] == 0);
+
+        std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+        std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(memory_snapshot_tb);
+
+    memory_snapshot_tb(sc_module_name name, cpu::cpu_model_t model) : sc_module(name) {
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        SC_THREAD(clock_gen);
+        SC_THREAD(run);
+    }
+
+    ~memory_snapshot_tb() {
+        delete cpu_i;
+    }
+};
+
+int sc_main(int argc, char* argv[]) {
+    // --lt forks the runs on the loosely-timed model
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    }
+
+    test_tracker();
+    memory_snapshot_tb tb("memory_snapshot_tb", model);
+    sc_start();
+    return tests_failed == 0 ? 0 : 1;
+}
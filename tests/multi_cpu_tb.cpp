@@ -0,0 +1,158 @@
+#include <systemc.h>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "cpu.h"
+#include "cpu_defs.h"
+
+// Several cpu instances elaborated side by side on one clock: every one runs
+// its own program and must see only its own memory, registers and output
+// port writes. The first two instances log to in-memory buffers, the third
+// to a file at io_path and the last to the file derived from its name.
+static const int CPU_COUNT = 4;
+static const int BUFFERED = 2;
+
+SC_MODULE(multi_cpu_tb) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpus[CPU_COUNT];
+    io_buffer_sink buffers[BUFFERED];
+
+    int tests_passed = 0;
+    int tests_failed = 0;
+
+    void check_result(const std::string& test_name, bool passed) {
+        if (passed) {
+            std::cout << "[PASS] " << test_name << std::endl;
+            tests_passed++;
+        } else {
+            std::cout << "[FAIL] " << test_name << std::endl;
+            tests_failed++;
+        }
+    }
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    static std::string io_file(int n) {
+        return "multi_cpu_io_" + std::to_string(n) + ".txt";
+    }
+
+    // Log file of cpu n, the last one with io and io_path unset
+    std::string log_file(int n) const {
+        return n < CPU_COUNT - 1 ? io_file(n)
+                                 : "../output/io_output_" + std::string(cpus[n]->memory_i->name()) + ".txt";
+    }
+
+    static std::string read_file(const std::string& path) {
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    // Expected port 2 text of cpu n
+    static std::string expected_text(int n) {
+        return std::string(1, (char)('a' + n)) + (char)('x' + n);
+    }
+
+    void run_tests() {
+        // Same code on every instance, different data: LDA #c1 / STA $FF02 /
+        // LDA #c2 / STA $FF02 / LDA #n / STA $0200 / BRK
+        for (int n = 0; n < CPU_COUNT; ++n) {
+            std::string text = expected_text(n);
+            uint8_t program[] = {
+                0xA9, (uint8_t)text[0], 0x8D, 0x02, 0xFF,
+                0xA9, (uint8_t)text[1], 0x8D, 0x02, 0xFF,
+                0xA9, (uint8_t)(0x10 + n), 0x8D, 0x00, 0x02,
+                0x00
+            };
+            cpus[n]->debug_write(0x0000, program, sizeof(program));
+        }
+
+        reset.write(true);
+        wait(20, SC_NS);
+        reset.write(false);
+        wait(10, SC_NS);
+        for (int i = 0; i < 200; ++i) {
+            wait(10, SC_NS);
+        }
+
+        for (int n = 0; n < CPU_COUNT; ++n) {
+            std::string name = "cpu " + std::to_string(n);
+            uint8_t stored = 0;
+            cpus[n]->debug_read(0x0200, &stored, 1);
+            check_result(name + " A register", cpus[n]->regfile_i->A == 0x10 + n);
+            check_result(name + " RAM", stored == 0x10 + n);
+            if (n < BUFFERED) {
+                check_result(name + " port output", buffers[n].text == expected_text(n));
+            } else {
+                // Flushed on BRK, the other instances keep their sinks
+                std::string log = read_file(log_file(n));
+                check_result(name + " port output file",
+                             log.size() >= 2 && log.compare(log.size() - 2, 2, expected_text(n)) == 0);
+            }
+        }
+
+        // A file already written by another instance is refused
+        memory* other = cpus[0]->memory_i;
+        other->io = nullptr;
+        other->io_path = "./" + io_file(BUFFERED);
+        bool refused = false;
+        try {
+            other->io_destination();
+        } catch (const sc_report&) {
+            refused = true;
+        }
+        check_result("shared port output file refused", refused && !other->default_io);
+
+        std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+        std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(multi_cpu_tb);
+
+    multi_cpu_tb(sc_module_name name, cpu::cpu_model_t model) : sc_module(name) {
+        for (int n = 0; n < CPU_COUNT; ++n) {
+            cpus[n] = new cpu(("cpu_" + std::to_string(n)).c_str(), model);
+            cpus[n]->clk(clk);
+            cpus[n]->reset(reset);
+            if (n < BUFFERED) {
+                cpus[n]->memory_i->io = &buffers[n];
+            } else if (n < CPU_COUNT - 1) {
+                cpus[n]->memory_i->io_path = io_file(n);
+            }
+        }
+        std::filesystem::create_directories("../output");
+        SC_THREAD(clock_gen);
+        SC_THREAD(run_tests);
+    }
+
+    ~multi_cpu_tb() {
+        for (cpu* c : cpus) {
+            delete c;
+        }
+    }
+};
+
+int sc_main(int argc, char* argv[]) {
+    // --lt and --fast run the instances on the loosely-timed models
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    } else if (argc > 1 && std::string(argv[1]) == "--fast") {
+        model = cpu::BLOCK_CACHED;
+    }
+
+    multi_cpu_tb tb("multi_cpu_tb", model);
+    sc_start();
+    return tb.tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include "cpu.h"
+#include "opcode_table.h"
+
+// Checks opcode_table against the decode switches cpu.cpp used before the table existed
+
+static cpu::addressing_mode_t legacy_addressing_mode(sc_uint<8> opcode) {
+    switch (opcode) {
+        // Immediate
+        case 0xA9: case 0xA2: case 0xA0: case 0x29: case 0x09: case 0x49: case 0x69: case 0xE9: case 0xC9: case 0xE0: case 0xC0:
+            return cpu::IMMEDIATE;
+        
+        // Zero Page
+        case 0xA5: case 0xA6: case 0xA4: case 0x85: case 0x86: case 0x84: case 0x25: case 0x05: case 0x45: case 0x65: case 0xE5:
+        case 0xC5: case 0xE4: case 0xC4: case 0x06: case 0x46: case 0x26: case 0x66: case 0xE6: case 0xC6:
+            return cpu::ZERO_PAGE;
+            
+        // Zero Page,X
+        case 0xB5: case 0x95: case 0x35: case 0x15: case 0x55: case 0x75: case 0xF5: case 0xD5: case 0x16: case 0x56:
+        case 0x36: case 0x76: case 0xF6: case 0xD6: case 0x94:
+            return cpu::ZERO_PAGE_X;
+            
+        // Zero Page,Y
+        case 0xB6: case 0x96: case 0xB4:
+            return cpu::ZERO_PAGE_Y;
+            
+        // Absolute
+        case 0xAD: case 0xAE: case 0xAC: case 0x8D: case 0x8E: case 0x8C: case 0x2D: case 0x0D: case 0x4D: case 0x6D:
+        case 0xED: case 0xCD: case 0xEC: case 0xCC: case 0x0E: case 0x4E: case 0x2E: case 0x6E: case 0xEE: case 0xCE:
+        case 0x20: case 0x4C: case 0x6C:
+            return cpu::ABSOLUTE;
+            
+        // Absolute,X
+        case 0xBD: case 0x9D: case 0x3D: case 0x1D: case 0x5D: case 0x7D: case 0xFD: case 0xDD: case 0x1E: case 0x5E:
+        case 0x3E: case 0x7E: case 0xFE: case 0xDE: case 0xBC:
+            return cpu::ABSOLUTE_X;
+            
+        // Absolute,Y
+        case 0xB9: case 0x99: case 0x39: case 0x19: case 0x59: case 0x79: case 0xF9: case 0xD9: case 0xBE:
+            return cpu::ABSOLUTE_Y;
+            
+        // (Zero Page,X)
+        case 0xA1: case 0x81: case 0x21: case 0x01: case 0x41: case 0x61: case 0xE1: case 0xC1:
+            return cpu::INDIRECT_X;
+            
+        // (Zero Page),Y
+        case 0xB1: case 0x91: case 0x31: case 0x11: case 0x51: case 0x71: case 0xF1: case 0xD1:
+            return cpu::INDIRECT_Y;
+
+        // Implied (all others)
+        default:
+            return cpu::IMPLIED;
+    }
+}
+
+static int legacy_instruction_length(sc_uint<8> opcode) {
+    cpu::addressing_mode_t mode = legacy_addressing_mode(opcode);
+    switch (mode) {
+        case cpu::IMPLIED: return 1;
+        case cpu::IMMEDIATE: case cpu::ZERO_PAGE: case cpu::ZERO_PAGE_X: case cpu::ZERO_PAGE_Y: 
+        case cpu::INDIRECT_X: case cpu::INDIRECT_Y: return 2;
+        case cpu::ABSOLUTE: case cpu::ABSOLUTE_X: case cpu::ABSOLUTE_Y: return 3;
+        default: return 1;
+    }
+}
+
+static bool legacy_needs_operand(sc_uint<8> opcode) {
+    return legacy_addressing_mode(opcode) != cpu::IMPLIED;
+}
+
+static bool legacy_is_store_instruction(sc_uint<8> opcode) {
+    // Instructions STA, STX, STY do not read operand from memory,
+    // they only write to memory at the calculated address
+    switch (opcode) {
+        // STA variants
+        case 0x85: case 0x95: case 0x8D: case 0x9D: case 0x99: case 0x81: case 0x91:
+        // STX variants  
+        case 0x86: case 0x96: case 0x8E:
+        // STY variants
+        case 0x84: case 0x94: case 0x8C:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+// Compare every opcode, report the first mismatch
+static void check_all_opcodes(const std::string& test_name, bool (*same)(int opcode)) {
+    for (int op = 0; op < 256; ++op) {
+        if (!same(op)) {
+            std::cout << "Mismatch at opcode 0x" << std::hex << std::setw(2) << std::setfill('0')
+                      << op << std::dec << std::endl;
+            check_result(test_name, false);
+            return;
+        }
+    }
+    check_result(test_name, true);
+}
+
+int sc_main(int, char**) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "   Opcode Table Test Suite" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // LDY zp,X (0xB4) was listed under zero page,Y in the switch, the table follows the ISA
+    check_all_opcodes("Addressing mode matches switch", [](int op) {
+        if (op == 0xB4) return cpu::get_addressing_mode(op) == cpu::ZERO_PAGE_X;
+        return cpu::get_addressing_mode(op) == legacy_addressing_mode(op);
+    });
+    check_all_opcodes("needs_operand matches switch", [](int op) {
+        return cpu::needs_operand(op) == legacy_needs_operand(op);
+    });
+    check_all_opcodes("is_store_instruction matches switch", [](int op) {
+        return cpu::is_store_instruction(op) == legacy_is_store_instruction(op);
+    });
+    check_all_opcodes("Instruction length matches switch", [](int op) {
+        return cpu::get_instruction_length(op) == legacy_instruction_length(op);
+    });
+    // The ISA length, used by cpu6502_core
+    check_all_opcodes("Branches are 2 bytes in the table", [](int op) {
+        return !(opcode_table[op].flags & OPC_BRANCH) || opcode_table[op].length == 2;
+    });
+
+    int legal = 0;
+    for (int op = 0; op < 256; ++op) {
+        if (opcode_table[op].flags & OPC_LEGAL) legal++;
+    }
+    check_result("144 opcodes decoded", legal == 144);
+
+    // 6502 timing
+    check_result("LDA abs,X cycles", opcode_table[0xBD].cycles == 4 && opcode_table[0xBD].page_penalty == 1);
+    check_result("STA abs,X cycles", opcode_table[0x9D].cycles == 5 && opcode_table[0x9D].page_penalty == 0);
+    check_result("INC abs,X cycles", opcode_table[0xFE].cycles == 7 && (opcode_table[0xFE].flags & OPC_RMW));
+    check_result("LDA (ind),Y cycles", opcode_table[0xB1].cycles == 5 && opcode_table[0xB1].page_penalty == 1);
+    check_result("STA (ind),Y cycles", opcode_table[0x91].cycles == 6);
+    check_result("ASL A cycles", opcode_table[0x0A].cycles == 2 && !(opcode_table[0x0A].flags & OPC_RMW));
+    check_result("JSR/JMP (ind)/BRK cycles",
+                 opcode_table[0x20].cycles == 6 && opcode_table[0x6C].cycles == 5 && opcode_table[0x00].cycles == 7);
+    check_result("PLA cycles", opcode_table[0x68].cycles == 4);
+    check_result("BNE cycles", opcode_table[0xD0].cycles == 2 && (opcode_table[0xD0].flags & OPC_BRANCH));
+    check_result("Mnemonic names", std::string(opcode_mnemonic_name(0xA9)) == "LDA" &&
+                 std::string(opcode_mnemonic_name(0x00)) == "BRK" && std::string(opcode_mnemonic_name(0xFE)) == "INC" &&
+                 std::string(opcode_mnemonic_name(0x02)) == "???");
+
+    std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+    std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+#include <systemc.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include "cpu.h"
+#include "cpu_defs.h"
+#include "program_image.h"
+
+// Program file parsers, and the CPU booting from the reset vector of a
+// loaded image on the signal-level or loosely-timed model
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+// One Intel HEX record with its checksum
+static std::string ihex_record(uint8_t type, uint16_t address, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> bytes = { (uint8_t)data.size(), (uint8_t)(address >> 8), (uint8_t)address, type };
+    bytes.insert(bytes.end(), data.begin(), data.end());
+    uint8_t sum = 0;
+    std::ostringstream out;
+    out << ':' << std::hex << std::uppercase << std::setfill('0');
+    for (uint8_t b : bytes) {
+        out << std::setw(2) << (int)b;
+        sum += b;
+    }
+    out << std::setw(2) << (int)(uint8_t)-sum << "\r\n";
+    return out.str();
+}
+
+// LDA #$42 / STA $0200 / LDX $0300 / BRK at $0400, a data byte at $0300
+static const std::vector<uint8_t> boot_code = { 0xA9, 0x42, 0x8D, 0x00, 0x02, 0xAE, 0x00, 0x03, 0x00 };
+
+static std::string boot_hex() {
+    return ihex_record(0x00, 0x0400, boot_code) +
+           ihex_record(0x00, 0x0300, { 0x17 }) +
+           ihex_record(0x05, 0x0000, { 0x00, 0x00, 0x04, 0x00 }) +
+           ihex_record(0x01, 0x0000, {});
+}
+
+static void test_parsers() {
+    program_image image;
+    std::string error;
+
+    std::string text = "# comment\nA9 0x05 69\n  03 00 # trailing\n";
+    check_result("text program", parse_text_program(text.data(), text.size(), image, error) &&
+                 image.segments.size() == 1 && image.segments[0].address == 0 &&
+                 image.segments[0].bytes == std::vector<uint8_t>({ 0xA9, 0x05, 0x69, 0x03, 0x00 }) && image.entry == -1);
+    text = "A9 zz 00";
+    check_result("text program keeps bytes around a bad token",
+                 !parse_text_program(text.data(), text.size(), image, error) && image.size() == 2 && !error.empty());
+
+    std::string hex = boot_hex();
+    check_result("Intel HEX", parse_intel_hex(hex.data(), hex.size(), image, error) &&
+                 image.segments.size() == 2 && image.segments[0].address == 0x0400 &&
+                 image.segments[0].bytes == boot_code && image.segments[1].address == 0x0300 && image.entry == 0x0400);
+    hex = ihex_record(0x00, 0x1000, { 1, 2 }) + ihex_record(0x00, 0x1002, { 3 }) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX merges contiguous records", parse_intel_hex(hex.data(), hex.size(), image, error) &&
+                 image.segments.size() == 1 && image.size() == 3);
+    hex = ":0100000042BE\n:00000001FF\n";
+    check_result("Intel HEX checksum error", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x00, 0xFFFF, { 1, 2 }) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX past 64KB rejected", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x00, 0x0000, { 1 });
+    check_result("Intel HEX without end record", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x04, 0x0000, {}) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX short address record rejected", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x05, 0x0000, { 0x00, 0x04 }) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX short start record rejected", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x02, 0x0000, { 0x00, 0x01, 0x00, 0x00 }) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX long address record rejected", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x05, 0x0000, { 0xFF, 0xFF, 0xFF, 0xFF }) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX negative start address rejected", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ":" + std::string(4000, '0') + "\n" + ihex_record(0x01, 0, {});
+    check_result("Intel HEX overlong record rejected", !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x00, 0x0000, { 1, 2, 3 });
+    hex.insert(hex.size() - 4, "00"); // a fourth data byte, checksum still right
+    check_result("Intel HEX record longer than its count rejected",
+                 !parse_intel_hex(hex.data(), hex.size(), image, error));
+    hex = ihex_record(0x03, 0x0000, { 0x00, 0x40, 0x00, 0x10 }) + ihex_record(0x01, 0, {});
+    check_result("Intel HEX segment start address", parse_intel_hex(hex.data(), hex.size(), image, error) &&
+                 image.entry == 0x0410);
+
+    hex = boot_hex();
+    parse_intel_hex(hex.data(), hex.size(), image, error);
+    std::vector<uint8_t> file = write_segment_image(image);
+    program_image copy;
+    check_result("segment image round trip", parse_segment_image(file.data(), file.size(), copy, error) &&
+                 copy.segments.size() == 2 && copy.segments[0].bytes == boot_code &&
+                 copy.segments[1].bytes == image.segments[1].bytes && copy.entry == 0x0400);
+    file.resize(file.size() - 1);
+    check_result("truncated segment image", !parse_segment_image(file.data(), file.size(), copy, error));
+
+    std::vector<uint8_t> mem(0x10000, 0);
+    check_result("copy into memory", copy_program_image(image, mem.data()) == boot_code.size() + 1 &&
+                 mem[0x0400] == 0xA9 && mem[0x0300] == 0x17 && mem[0xFFFC] == 0x00 && mem[0xFFFD] == 0x04);
+}
+
+static void write_text(const std::string& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+static void test_cache() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "program_image_tb_cache";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string source = (dir / "program.txt").string();
+    program_cache cache((dir / "images").string());
+    cache.min_source = 0;
+    program_image image;
+    std::string error;
+
+    write_text(source, "A9 42 00 # LDA #$42 / BRK\n");
+    check_result("first load parses", cache.load(source, image, error) && cache.misses == 1 && cache.hits == 0);
+    check_result("compiled image written", std::filesystem::exists(cache.image_path(
+                 program_hash((const uint8_t*)"A9 42 00 # LDA #$42 / BRK\n", 26), false)));
+    program_image cached;
+    check_result("second load hits", cache.load(source, cached, error) && cache.hits == 1 &&
+                 cached.segments.size() == 1 && cached.segments[0].bytes == image.segments[0].bytes);
+
+    write_text(source, "A9 43 00\n");
+    check_result("edited source misses", cache.load(source, cached, error) && cache.misses == 2 &&
+                 cached.segments[0].bytes == std::vector<uint8_t>({ 0xA9, 0x43, 0x00 }));
+
+    write_text(source, "A9 zz 00\n");
+    cache.load(source, cached, error);
+    check_result("bad source not cached", !cache.load(source, cached, error) && cache.misses == 4 && !error.empty());
+
+    cache.min_source = 4096;
+    write_text(source, "A9 43 00\n");
+    cache.load(source, cached, error);
+    check_result("small source parsed directly", cache.hits == 1 && cache.misses == 4);
+    std::filesystem::remove_all(dir);
+}
+
+SC_MODULE(program_image_tb) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    void run() {
+        program_image image;
+        std::string error;
+        std::string hex = boot_hex();
+        parse_intel_hex(hex.data(), hex.size(), image, error);
+        check_result("load image", cpu_i->memory_i->load_image(image) == boot_code.size() + 1);
+        check_result("reset vector from the entry point", cpu_i->reset_vector() == 0x0400);
+
+        reset.write(true);
+        wait(20, SC_NS);
+        reset.write(false);
+        wait(10, SC_NS);
+        for (int i = 0; i < 100; ++i) {
+            wait(10, SC_NS);
+        }
+
+        uint8_t stored = 0;
+        cpu_i->debug_read(0x0200, &stored, 1);
+        check_result("boot from $0400", cpu_i->regfile_i->A == 0x42 && stored == 0x42);
+        check_result("data segment loaded", cpu_i->regfile_i->X == 0x17);
+
+        std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+        std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(program_image_tb);
+
+    program_image_tb(sc_module_name name, cpu::cpu_model_t model) : sc_module(name) {
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        SC_THREAD(clock_gen);
+        SC_THREAD(run);
+    }
+
+    ~program_image_tb() {
+        delete cpu_i;
+    }
+};
+
+int sc_main(int argc, char* argv[]) {
+    // --lt boots the loosely-timed model
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    if (argc > 1 && std::string(argv[1]) == "--lt") {
+        model = cpu::LOOSELY_TIMED;
+    }
+
+    test_parsers();
+    test_cache();
+    program_image_tb tb("program_image_tb", model);
+    sc_start();
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <systemc.h>
+#include <iostream>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "trace_file.h"
+
+// Binary execution trace: writer buffering, reader round trip and header checks
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+static std::vector<trace_record_t> make_records(size_t count) {
+    std::vector<trace_record_t> records;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 3 == 0) {
+            trace_record_t r = {};
+            r.cycle = i * 10;
+            r.kind = TRACE_INSTRUCTION;
+            r.pc = (uint16_t)(0x0400 + i);
+            r.opcode = 0xAD;
+            r.operand[0] = (uint8_t)i;
+            r.operand[1] = 0x02;
+            r.addr = (uint16_t)(0x0200 + i);
+            r.a = (uint8_t)i;
+            r.x = 1;
+            r.y = 2;
+            r.s = 0xFF;
+            r.p = 0x20;
+            records.push_back(r);
+        } else {
+            records.push_back(trace_memory_record(i * 10, i % 3 == 2, (uint16_t)(0x0200 + i), (uint8_t)(i * 7)));
+        }
+    }
+    return records;
+}
+
+// Copy of the file at path with one header byte changed
+static std::string corrupt(const std::string& path, size_t offset, uint8_t value) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    bytes[offset] = (char)value;
+    std::string out_path = path + ".bad";
+    std::ofstream out(out_path, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+    return out_path;
+}
+
+static void test_round_trip(const std::string& path) {
+    // 10 records through a 4-record buffer: two flushes while writing, one on close
+    std::vector<trace_record_t> records = make_records(10);
+    trace_file_writer writer(4);
+    check_result("open writer", writer.open(path));
+    for (const trace_record_t& r : records) {
+        writer.write(r);
+    }
+    check_result("records counted across flushes", writer.records() == records.size());
+    check_result("close writer", writer.close() && !writer.failed());
+    check_result("file size", std::filesystem::file_size(path) ==
+                 sizeof(trace_file_header_t) + records.size() * sizeof(trace_record_t));
+
+    trace_file_reader reader;
+    check_result("open reader", reader.open(path));
+    std::vector<trace_record_t> read_back;
+    trace_record_t chunk[3];
+    size_t n;
+    while ((n = reader.read(chunk, 3)) > 0) {
+        read_back.insert(read_back.end(), chunk, chunk + n);
+    }
+    check_result("round trip", read_back.size() == records.size() &&
+                 std::memcmp(read_back.data(), records.data(), records.size() * sizeof(trace_record_t)) == 0);
+}
+
+static void test_bad_headers(const std::string& path) {
+    trace_file_reader reader;
+    std::string bad = corrupt(path, 0, 'X');
+    check_result("bad magic rejected", !reader.open(bad));
+    bad = corrupt(path, 8, TRACE_FILE_VERSION + 1);
+    check_result("unknown version rejected", !reader.open(bad));
+    bad = corrupt(path, 12, sizeof(trace_record_t) + 8);
+    check_result("other record size rejected", !reader.open(bad));
+    std::filesystem::remove(bad);
+    check_result("missing file rejected", !reader.open(path + ".missing"));
+    check_result("nothing read after a failed open", reader.read(nullptr, 0) == 0);
+}
+
+static void test_write_error() {
+    // Every write to /dev/full fails with ENOSPC
+    if (!std::filesystem::exists("/dev/full")) {
+        return;
+    }
+    trace_file_writer writer(4);
+    check_result("header write error reported", !writer.open("/dev/full") && !writer.is_open());
+}
+
+int sc_main(int, char**) {
+    std::string path = (std::filesystem::temp_directory_path() / "trace_file_tb.bin").string();
+    test_round_trip(path);
+    test_bad_headers(path);
+    test_write_error();
+    std::filesystem::remove(path);
+
+    std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+    std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#include <systemc.h>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "cpu_defs.h"
+#include "waveform_capture.h"
+
+// Windowed VCD capture on a counter that equals the cycle number at every
+// falling edge: a cycle window, a PC match with a wrapped pre-trigger ring,
+// a trigger from a check and a trigger that never fires
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check_result(const std::string& test_name, bool passed) {
+    if (passed) {
+        std::cout << "[PASS] " << test_name << std::endl;
+        tests_passed++;
+    } else {
+        std::cout << "[FAIL] " << test_name << std::endl;
+        tests_failed++;
+    }
+}
+
+static std::string temp_path(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// Timestamps of the file in ns, the samples and the closing one
+static std::vector<uint64_t> timestamps(const std::string& text) {
+    std::vector<uint64_t> times;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line[0] == '#') {
+            times.push_back(std::stoull(line.substr(1)));
+        }
+    }
+    return times;
+}
+
+static std::vector<uint64_t> cycles_ns(uint64_t first, uint64_t last) {
+    std::vector<uint64_t> times;
+    for (uint64_t cycle = first; cycle <= last; ++cycle) {
+        times.push_back(cycle * CPU_CLOCK_PERIOD_NS);
+    }
+    return times;
+}
+
+SC_MODULE(waveform_capture_tb) {
+    sc_signal<bool> clk;
+    sc_signal<sc_uint<16>> pc;
+    sc_signal<bool> odd;
+    waveform_capture cycle_window, pc_match, triggered, never, oversized;
+    uint64_t written_at_trigger = 0;
+    bool oversized_opened = true;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(CPU_CLOCK_PERIOD_NS / 2, SC_NS);
+            clk.write(true);
+            wait(CPU_CLOCK_PERIOD_NS / 2, SC_NS);
+        }
+    }
+
+    // Falling edge n samples pc == n
+    void count() {
+        uint16_t next = (uint16_t)(pc.read() + 1);
+        pc.write(next);
+        odd.write(next & 1);
+    }
+
+    // A failing check after the sample of cycle 12
+    void check() {
+        wait(12 * CPU_CLOCK_PERIOD_NS + 3, SC_NS);
+        triggered.trigger();
+        written_at_trigger = triggered.samples_written();
+    }
+
+    void setup(waveform_capture& capture, const waveform_window_t& window, const std::string& file) {
+        capture.clk(clk);
+        capture.window = window;
+        capture.add(pc, "pc", 16);
+        capture.add(odd, "odd", 1);
+        capture.open(temp_path(file));
+    }
+
+    SC_HAS_PROCESS(waveform_capture_tb);
+
+    waveform_capture_tb(sc_module_name name)
+        : sc_module(name), cycle_window("cycle_window"), pc_match("pc_match"), triggered("triggered"), never("never"),
+          oversized("oversized") {
+        waveform_window_t window;
+        window.start_cycle = 5;
+        window.stop_cycle = 8;
+        setup(cycle_window, window, "waveform_cycle_window.vcd");
+
+        window = waveform_window_t();
+        window.start_pc = 0x20;
+        window.pre_cycles = 3; // wraps ten times before the match
+        window.post_cycles = 4;
+        setup(pc_match, window, "waveform_pc_match.vcd");
+
+        window = waveform_window_t();
+        window.on_trigger = true;
+        window.pre_cycles = 4;
+        window.post_cycles = 2;
+        setup(triggered, window, "waveform_triggered.vcd");
+        setup(never, window, "waveform_never.vcd");
+
+        window.pre_cycles = waveform_capture::MAX_PRE_CYCLES + 1;
+        oversized.clk(clk);
+        oversized.window = window;
+        oversized.add(pc, "pc", 16);
+        oversized_opened = oversized.open(temp_path("waveform_oversized.vcd"));
+
+        SC_THREAD(clock_gen);
+        SC_METHOD(count);
+        sensitive << clk.posedge_event();
+        dont_initialize();
+        SC_THREAD(check);
+    }
+};
+
+int sc_main(int, char**) {
+    waveform_capture_tb tb("waveform_capture_tb");
+    sc_start(60 * CPU_CLOCK_PERIOD_NS, SC_NS);
+
+    // Cycles 5-7, closed at cycle 8
+    std::string text = read_file(temp_path("waveform_cycle_window.vcd"));
+    std::vector<uint64_t> expected = cycles_ns(5, 8);
+    check_result("cycle window", tb.cycle_window.samples_written() == 3 && timestamps(text) == expected);
+    check_result("header and first values", text.find("$var wire 16 ! pc $end") != std::string::npos &&
+                 text.find("$dumpvars\nb0000000000000101 !\n1\"\n$end") != std::string::npos);
+    check_result("only changes after the first sample", text.find("#60\nb0000000000000110 !\n0\"\n#70") != std::string::npos);
+
+    // Ring of cycles 29-31 written on the match at 32, then 33-35, closed at 36
+    text = read_file(temp_path("waveform_pc_match.vcd"));
+    expected = cycles_ns(29, 36);
+    check_result("PC match with pre-trigger ring", tb.pc_match.samples_written() == 7 && timestamps(text) == expected);
+    check_result("ring written oldest first", text.find("$dumpvars\nb0000000000011101 !") != std::string::npos);
+
+    // Ring of cycles 9-12 written by trigger() itself, then 13, closed at 14
+    text = read_file(temp_path("waveform_triggered.vcd"));
+    expected = cycles_ns(9, 14);
+    check_result("trigger writes the ring at once", tb.written_at_trigger == 4);
+    check_result("post cycles after a trigger", tb.triggered.opened() && tb.triggered.samples_written() == 5 &&
+                 timestamps(text) == expected);
+
+    check_result("nothing written without a trigger", !tb.never.opened() && tb.never.samples_written() == 0 &&
+                 read_file(temp_path("waveform_never.vcd")).empty());
+
+    check_result("pre-trigger ring above the limit refused", !tb.oversized_opened && tb.oversized.samples_written() == 0);
+
+    for (const char* file : { "waveform_cycle_window.vcd", "waveform_pc_match.vcd", "waveform_triggered.vcd",
+                              "waveform_never.vcd" }) {
+        std::filesystem::remove(temp_path(file));
+    }
+
+    std::cout << "Tests Passed: " << std::dec << tests_passed << std::endl;
+    std::cout << "Tests Failed: " << std::dec << tests_failed << std::endl;
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cpu6502_core.h"
+#include "cpu6502_batch.h"
+#include "program_image.h"
+
+// Dispatch benchmark of cpu6502_core: handler table, plain switch, threaded
+// code and the JIT (hot blocks as x86-64 code) on the programs in programs/. Every program is run from reset to BRK
+// until the requested number of instructions has been executed. The batch column runs
+// cpu6502_batch::MAX_LANES copies of the program in lockstep and counts the
+// instructions of all lanes (aggregate throughput). A second table compares
+// parsing each program file with loading it from the program cache.
+//
+// usage: core_bench [-n instructions] [--perf-map] [--loads n] [--program-cache dir] [program.txt ...]
+// --perf-map writes /tmp/perf-<pid>.map for the translated blocks.
+// Build with CMAKE_BUILD_TYPE=Release, unoptimized numbers mean nothing.
+
+static uint8_t mem[65536];
+static bool perf_map = false;
+
+// The line-by-line getline/istringstream/stoi parse the testbench used
+// before program_image.h, kept as the baseline of the load table
+static bool stream_load_program(const std::string& filename, std::vector<uint8_t>& bytes) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "ERROR: Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        std::string hex_byte;
+        while (iss >> hex_byte) {
+            if (hex_byte[0] == '#') break;
+            try {
+                bytes.push_back((uint8_t)std::stoi(hex_byte, nullptr, 16));
+            } catch (const std::exception&) {
+                std::cout << "ERROR parsing: " << hex_byte << std::endl;
+            }
+        }
+    }
+    return true;
+}
+
+// Microseconds per load of a program file: the stream parse, the
+// program_image.h parse and a read back from the compiled program cache (one
+// miss fills it before timing)
+static void bench_load(const std::string& filename, program_cache& cache, int loads, double& stream_us,
+                       double& parse_us, double& cached_us) {
+    program_image image;
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loads; ++i) {
+        std::vector<uint8_t> bytes;
+        stream_load_program(filename, bytes);
+    }
+    std::chrono::duration<double, std::micro> stream = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loads; ++i) {
+        load_program_image(filename, image, error);
+    }
+    std::chrono::duration<double, std::micro> parse = std::chrono::steady_clock::now() - start;
+
+    cache.load(filename, image, error);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loads; ++i) {
+        cache.load(filename, image, error);
+    }
+    std::chrono::duration<double, std::micro> cached = std::chrono::steady_clock::now() - start;
+    stream_us = stream.count() / loads;
+    parse_us = parse.count() / loads;
+    cached_us = cached.count() / loads;
+}
+
+enum dispatch_t { TABLE, SWITCH, THREADED, JIT, BATCH };
+static const char* dispatch_name[] = { "table", "switch", "threaded", "jit", "batch" };
+
+// Flat memory reporting writes to the block cache, as run_jit() needs
+struct cached_bus {
+    uint8_t* mem;
+    cpu6502_block_cache* cache;
+
+    uint8_t read(uint16_t addr) { return mem[addr]; }
+    void write(uint16_t addr, uint8_t data) { mem[addr] = data; cache->invalidate_write(addr); }
+};
+
+// Returns executed instructions per second
+static double bench(const std::vector<uint8_t>& program, dispatch_t dispatch, uint64_t instructions,
+                    uint64_t& checksum) {
+    cpu6502_core core(mem);
+    cpu6502_block_cache cache;
+    cpu6502_jit jit(cache, 16, 4 << 20, perf_map);
+    cpu6502_core_t<cached_bus> jit_core(cached_bus{ mem, &cache });
+    static cpu6502_batch batch;
+    uint64_t done = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < instructions) {
+        // Every run starts from the same bytes, cached code stays valid
+        memcpy(mem, program.data(), program.size());
+        core.reset();
+        jit_core.reset();
+        // Programs that never reach BRK are cut at the remaining budget
+        uint64_t budget = instructions - done;
+        switch (dispatch) {
+            case TABLE:    done += core.run(budget); break;
+            case SWITCH:   done += core.run_switch(budget); break;
+            case THREADED: done += core.run_threaded(budget); break;
+            case JIT:      done += jit_core.run_jit(jit, budget); checksum += jit_core.a + jit_core.cycles; break;
+            case BATCH:
+                for (int lane = 0; lane < batch.lanes(); ++lane) {
+                    memcpy(batch.memory(lane), program.data(), program.size());
+                }
+                batch.reset();
+                done += batch.run((budget + batch.lanes() - 1) / batch.lanes());
+                checksum += batch.a[0] + batch.cycles[0];
+                break;
+        }
+        checksum += core.a + core.cycles;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return done / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t instructions = 50000000;
+    std::vector<std::string> files;
+    int loads = 1000;
+    std::string cache_dir = "../output/program_cache";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            instructions = std::stoull(argv[++i]);
+        } else if (arg == "--loads" && i + 1 < argc) {
+            loads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--program-cache" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "--perf-map") {
+            perf_map = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        for (const char* name : { "add2num.txt", "hello.txt", "lda_simple.txt", "test_io.txt", "test_sec.txt",
+                                  "bench_loop.txt" }) {
+            files.push_back(std::string("../programs/") + name);
+        }
+    }
+
+    std::cout << "Dispatch: threaded code "
+              << (CPU6502_COMPUTED_GOTO ? "(computed goto)" : "(switch fallback)")
+              << ", JIT " << (CPU6502_JIT ? "x86-64" : "not supported (interpreter)")
+              << ", batch " << cpu6502_batch::MAX_LANES << " lanes " << cpu6502_batch::simd() << std::endl;
+    std::cout << std::left << std::setw(24) << "program";
+    for (const char* name : dispatch_name) std::cout << std::right << std::setw(12) << name;
+    std::cout << "   MIPS" << std::endl;
+
+    uint64_t checksum = 0;
+    for (const std::string& file : files) {
+        program_image image;
+        std::string error;
+        if (!load_program_image(file, image, error)) {
+            std::cout << "ERROR: " << error << std::endl;
+        }
+        // Flat bytes from 0 to the end of the last segment, runs start at 0
+        std::vector<uint8_t> program;
+        for (const program_segment& segment : image.segments) {
+            program.resize(std::max<size_t>(program.size(), segment.address + segment.bytes.size()));
+            std::copy(segment.bytes.begin(), segment.bytes.end(), program.begin() + segment.address);
+        }
+        if (program.empty()) continue;
+
+        std::cout << std::left << std::setw(24) << file.substr(file.find_last_of("/\\") + 1);
+        for (int d = TABLE; d <= BATCH; ++d) {
+            double ips = bench(program, (dispatch_t)d, instructions, checksum);
+            std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(1) << ips / 1e6;
+        }
+        std::cout << std::endl;
+    }
+
+    program_cache cache(cache_dir);
+    cache.min_source = 0; // time the cache on the small programs too
+    std::cout << std::endl << "Program load, us per load (" << loads << " loads, cache in " << cache_dir << ")"
+              << std::endl;
+    std::cout << std::left << std::setw(24) << "program" << std::right << std::setw(12) << "stream"
+              << std::setw(12) << "parse" << std::setw(12) << "cache hit" << std::endl;
+    for (const std::string& file : files) {
+        double stream_us = 0, parse_us = 0, cached_us = 0;
+        bench_load(file, cache, loads, stream_us, parse_us, cached_us);
+        std::cout << std::left << std::setw(24) << file.substr(file.find_last_of("/\\") + 1) << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(12) << stream_us << std::setw(12) << parse_us
+                  << std::setw(12) << cached_us << std::endl;
+    }
+    std::cout << "cache hits " << cache.hits << " misses " << cache.misses << std::endl;
+    std::cout << "checksum " << checksum << std::endl;
+    return 0;
+}
@@ -0,0 +1,495 @@
+#include <systemc.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cpu.h"
+#include "cpu_defs.h"
+#include "cpu_coverage.h"
+#include "cpu6502_core.h"
+#include "io_sink.h"
+#include "memory_snapshot.h"
+#include "program_image.h"
+
+// Coverage-guided fuzzer of the SystemC cpu models. Byte programs are mutated
+// from a corpus (seeded with programs/*.txt), loaded at 0 and run with a
+// cycle budget. Inputs reaching new coverage (cpu_coverage.h: FSM state
+// transitions per opcode, control word changes, LT retire outcomes) join the
+// corpus. Every run is also executed on cpu6502_core as the reference:
+//
+//   hang        the reference reaches BRK within budget/10 instructions, the
+//               model not within the budget (at most 10 cycles per instruction)
+//   divergence  both stop on BRK with different registers, PC, RAM or port writes
+//   crash       a signal or exception while the input was running
+//
+// Failures with new coverage among failures are written under --out as hex
+// text programs that run with ./cpu as they are. The elaborated cpu is reused:
+// between runs memory goes back to a copy-on-write snapshot (only the pages the
+// last run wrote are copied) and cpu::restore_state() resets the CPU, reset is
+// never asserted.
+//
+// usage: cpu_fuzz [--lt | --bundled | --fast] [--runs n] [--seconds s] [--budget cycles]
+//                 [--max-len bytes] [--seed n] [--seeds dir] [--out dir] [--max-reports n]
+
+static const uint8_t valid_opcodes[] = {
+#define CPU_FUZZ_OPCODE(opcode, mnemonic, mode) opcode,
+    CPU6502_OPCODE_LIST(CPU_FUZZ_OPCODE)
+#undef CPU_FUZZ_OPCODE
+};
+
+static const uint8_t interesting_bytes[] = { 0x00, 0x01, 0x02, 0x7F, 0x80, 0xFE, 0xFF, 0x10, 0x20, 0x40 };
+
+// Input of the run in progress. The crash handler may only open() and
+// write(), so the file name and the input's program text are formatted
+// before every run.
+static std::vector<uint8_t> current_input;
+static std::string crash_path;
+static char crash_file[4096];
+static std::vector<char> crash_program;
+
+// Memory of the reference core. Port writes are recorded instead of stored,
+// like the output ports of memory.
+struct fuzz_bus {
+    uint8_t* mem;
+    std::vector<io_record_t>* ports;
+
+    uint8_t read(uint16_t addr) { return mem[addr]; }
+    void write(uint16_t addr, uint8_t data) {
+        if (addr >= 0xFF00 && addr <= 0xFF03) {
+            ports->push_back(io_record_t{ 0, (uint8_t)(addr - 0xFF00), data });
+        } else {
+            mem[addr] = data;
+        }
+    }
+};
+
+struct run_result {
+    bool halted;
+    uint8_t a, x, y, s, p;
+    uint16_t pc;
+};
+
+static std::string describe(const run_result& r, size_t ports) {
+    std::ostringstream out;
+    out << std::hex << std::uppercase << std::setfill('0') << "A=" << std::setw(2) << (int)r.a
+        << " X=" << std::setw(2) << (int)r.x << " Y=" << std::setw(2) << (int)r.y << " S=" << std::setw(2)
+        << (int)r.s << " P=" << std::setw(2) << (int)r.p << " PC=" << std::setw(4) << r.pc << std::dec << ", "
+        << ports << " port writes" << (r.halted ? "" : ", no BRK");
+    return out.str();
+}
+
+static bool same_ports(const std::vector<io_record_t>& a, const std::vector<io_record_t>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const io_record_t& x, const io_record_t& y) {
+        return x.port == y.port && x.value == y.value;
+    });
+}
+
+// Program in the hex text format, 16 bytes per line
+static std::string program_text(const std::vector<uint8_t>& program) {
+    std::string text;
+    char byte[4];
+    for (size_t i = 0; i < program.size(); ++i) {
+        std::snprintf(byte, sizeof(byte), "%02X%c", program[i], (i % 16 == 15 || i + 1 == program.size()) ? '\n' : ' ');
+        text += byte;
+    }
+    return text;
+}
+
+// Writes a program in the hex text format, comment lines first
+static bool write_program(const std::string& path, const std::vector<std::string>& comments,
+                          const std::vector<uint8_t>& program) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    for (const std::string& line : comments) {
+        std::fprintf(file, "# %s\n", line.c_str());
+    }
+    std::string text = program_text(program);
+    std::fwrite(text.data(), 1, text.size(), file);
+    return std::fclose(file) == 0;
+}
+
+static void set_current_input(std::vector<uint8_t> input) {
+    current_input = std::move(input);
+    std::string text = program_text(current_input);
+    crash_program.assign(text.begin(), text.end());
+}
+
+static void write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+// Async-signal-safe: open()/write() of the text prepared by set_current_input
+static void crash_handler(int signal) {
+    int fd = open(crash_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        char header[48] = "# cpu_fuzz crash: signal ";
+        size_t length = std::strlen(header);
+        char digits[12];
+        int count = 0;
+        for (unsigned n = (unsigned)signal; n > 0 || count == 0; n /= 10) {
+            digits[count++] = (char)('0' + n % 10);
+        }
+        while (count > 0) {
+            header[length++] = digits[--count];
+        }
+        header[length++] = '\n';
+        write_all(fd, header, length);
+        write_all(fd, crash_program.data(), crash_program.size());
+        close(fd);
+    }
+    _exit(128 + signal);
+}
+
+// AFL hit count buckets: 1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+
+static uint8_t bucket(uint8_t count) {
+    if (count <= 2) return count;
+    if (count == 3) return 4;
+    if (count < 8) return 8;
+    if (count < 16) return 16;
+    if (count < 32) return 32;
+    if (count < 128) return 64;
+    return 128;
+}
+
+// Clears the buckets of map in virgin, true if any was still set
+static bool new_coverage(const cpu_coverage& coverage, uint8_t* virgin) {
+    bool found = false;
+    for (size_t w = 0; w < cpu_coverage::MAP_SIZE / 8; ++w) {
+        // Eight counts at a time to skip the empty ones, memcpy keeps it aligned and alias-safe
+        uint64_t word;
+        std::memcpy(&word, coverage.map + w * 8, sizeof(word));
+        if (!word) continue;
+        for (size_t i = w * 8; i < w * 8 + 8; ++i) {
+            uint8_t b = bucket(coverage.map[i]);
+            if (virgin[i] & b) {
+                virgin[i] &= ~b;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+SC_MODULE(cpu_fuzzer) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+
+    // Options
+    uint64_t max_runs = 100000;
+    double max_seconds = 0;
+    unsigned budget = 2000;
+    size_t max_len = 64;
+    unsigned max_reports = 50;
+    std::string out_dir = "../programs/fuzz";
+    std::string model_flag;
+
+    std::mt19937 rng;
+    std::vector<std::vector<uint8_t> > corpus;
+    cpu_coverage coverage;
+    uint8_t virgin[cpu_coverage::MAP_SIZE];
+    uint8_t virgin_failures[cpu_coverage::MAP_SIZE];
+
+    memory_snapshot power_on_memory;
+    checkpoint_state_t power_on = {};
+    std::vector<io_record_t> model_ports, reference_ports;
+    io_callback_sink port_sink;
+    std::vector<uint8_t> reference_mem;
+
+    uint64_t runs = 0, hangs = 0, divergences = 0, reports = 0;
+    std::chrono::steady_clock::time_point start;
+
+    void clock_gen() {
+        while (true) {
+            clk.write(false);
+            wait(5, SC_NS);
+            clk.write(true);
+            wait(5, SC_NS);
+        }
+    }
+
+    size_t random(size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); }
+
+    std::vector<uint8_t> mutate(const std::vector<uint8_t>& input) {
+        std::vector<uint8_t> out = input;
+        int stacked = 1 << random(3);
+        for (int i = 0; i < stacked; ++i) {
+            size_t at = random(out.size() + 1);
+            switch (random(7)) {
+                case 0:
+                    if (!out.empty()) out[random(out.size())] ^= 1 << random(8);
+                    break;
+                case 1:
+                    if (!out.empty()) out[random(out.size())] = (uint8_t)random(256);
+                    break;
+                case 2:
+                    if (!out.empty()) out[random(out.size())] = interesting_bytes[random(sizeof(interesting_bytes))];
+                    break;
+                case 3: {
+                    // Whole instruction: a decoded opcode and its operand bytes
+                    uint8_t opcode = valid_opcodes[random(sizeof(valid_opcodes))];
+                    std::vector<uint8_t> insn(1, opcode);
+                    for (int b = 1; b < opcode_table[opcode].length; ++b) {
+                        insn.push_back(random(2) ? interesting_bytes[random(sizeof(interesting_bytes))] : (uint8_t)random(256));
+                    }
+                    out.insert(out.begin() + at, insn.begin(), insn.end());
+                    break;
+                }
+                case 4:
+                    if (at < out.size()) out.erase(out.begin() + at, out.begin() + std::min(out.size(), at + 1 + random(4)));
+                    break;
+                case 5:
+                    if (!out.empty()) {
+                        size_t from = random(out.size());
+                        std::vector<uint8_t> chunk(out.begin() + from, out.begin() + std::min(out.size(), from + 1 + random(8)));
+                        out.insert(out.begin() + at, chunk.begin(), chunk.end());
+                    }
+                    break;
+                case 6: {
+                    // Splice: our head, the tail of another corpus entry
+                    const std::vector<uint8_t>& other = corpus[random(corpus.size())];
+                    out.resize(std::min(at, out.size()));
+                    if (!other.empty()) {
+                        out.insert(out.end(), other.begin() + random(other.size()), other.end());
+                    }
+                    break;
+                }
+            }
+        }
+        if (out.size() > max_len) out.resize(max_len);
+        if (out.empty()) out.push_back((uint8_t)random(256));
+        return out;
+    }
+
+    // In-place reset, then the program runs until BRK or the budget
+    run_result run_model(const std::vector<uint8_t>& program) {
+        cpu_i->memory_i->restore(power_on_memory);
+        cpu_i->debug_write(0x0000, program.data(), (unsigned)program.size());
+        model_ports.clear();
+        coverage.clear();
+        cpu_i->restore_state(power_on);
+        wait(sc_time(CPU_CLOCK_PERIOD_NS * (double)budget, SC_NS), cpu_i->brk_event);
+
+        run_result r;
+        r.halted = cpu_i->loosely_timed() ? cpu_i->lt_core.halted : cpu_i->brk_reached;
+        r.a = cpu_i->regfile_i->A;
+        r.x = cpu_i->regfile_i->X;
+        r.y = cpu_i->regfile_i->Y;
+        r.s = cpu_i->regfile_i->S;
+        r.p = cpu_i->regfile_i->P;
+        r.pc = cpu_i->pc_val;
+        return r;
+    }
+
+    run_result run_reference(const std::vector<uint8_t>& program) {
+        std::fill(reference_mem.begin(), reference_mem.end(), 0);
+        std::copy(program.begin(), program.end(), reference_mem.begin());
+        reference_ports.clear();
+        cpu6502_core_t<fuzz_bus> core(fuzz_bus{ reference_mem.data(), &reference_ports });
+        core.run(std::max(1u, budget / 10));
+        return run_result{ core.halted, core.a, core.x, core.y, core.s, core.p, core.pc };
+    }
+
+    void report(const char* kind, const std::vector<uint8_t>& program, const run_result& expected,
+                const run_result& got) {
+        if (!new_coverage(coverage, virgin_failures) || reports >= max_reports) {
+            return;
+        }
+        uint64_t hash = program_hash(program.data(), program.size());
+        std::ostringstream name;
+        name << kind << "-" << std::hex << std::setw(16) << std::setfill('0') << hash << ".txt";
+        std::string path = (std::filesystem::path(out_dir) / name.str()).string();
+        std::vector<std::string> comments = {
+            std::string("cpu_fuzz ") + kind + ", " + std::to_string(budget) + " cycle budget",
+            "reference: " + describe(expected, reference_ports.size()),
+            "model:     " + describe(got, model_ports.size()),
+            "run: cpu " + model_flag + name.str()
+        };
+        if (write_program(path, comments, program)) {
+            reports++;
+            std::cout << "[" << kind << "] " << path << std::endl;
+        }
+    }
+
+    void print_status(bool final) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        size_t features = 0;
+        for (uint8_t v : virgin) features += v != 0xFF;
+        std::cout << (final ? "done: " : "") << runs << " runs, " << std::fixed << std::setprecision(0)
+                  << runs / elapsed.count() << " runs/s, corpus " << corpus.size() << ", coverage " << features
+                  << ", hangs " << hangs << ", divergences " << divergences << ", reports " << reports << std::endl;
+    }
+
+    void run() {
+        power_on_memory = cpu_i->memory_i->snapshot();
+        power_on.s = 0xFF;
+        power_on.p = 0x20;
+        start = std::chrono::steady_clock::now();
+        double next_status = 1.0;
+
+        while (runs < max_runs) {
+            set_current_input(runs < corpus.size() ? corpus[runs] : mutate(corpus[random(corpus.size())]));
+            run_result got = run_model(current_input);
+            run_result expected = run_reference(current_input);
+            runs++;
+
+            if (new_coverage(coverage, virgin)) {
+                corpus.push_back(current_input);
+            }
+            if (expected.halted && !got.halted) {
+                hangs++;
+                report("hang", current_input, expected, got);
+            } else if (expected.halted && (expected.a != got.a || expected.x != got.x || expected.y != got.y ||
+                       expected.s != got.s || expected.p != got.p || expected.pc != got.pc ||
+                       !same_ports(reference_ports, model_ports) ||
+                       std::memcmp(reference_mem.data(), cpu_i->memory_i->mem, reference_mem.size()) != 0)) {
+                divergences++;
+                report("divergence", current_input, expected, got);
+            }
+
+            if ((runs & 1023) == 0) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (max_seconds > 0 && elapsed.count() >= max_seconds) break;
+                if (elapsed.count() >= next_status) {
+                    print_status(false);
+                    next_status = elapsed.count() + 5.0;
+                }
+            }
+        }
+        print_status(true);
+        sc_stop();
+    }
+
+    SC_HAS_PROCESS(cpu_fuzzer);
+
+    cpu_fuzzer(sc_module_name name, cpu::cpu_model_t model, unsigned seed)
+        : sc_module(name), rng(seed), port_sink([this](const io_record_t& record) { model_ports.push_back(record); }),
+          reference_mem(65536) {
+        std::memset(virgin, 0xFF, sizeof(virgin));
+        std::memset(virgin_failures, 0xFF, sizeof(virgin_failures));
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        cpu_i->memory_i->io = &port_sink;
+        cpu_i->set_coverage(&coverage);
+        if (!cpu_i->loosely_timed()) {
+            SC_THREAD(clock_gen);
+        }
+        SC_THREAD(run);
+    }
+
+    ~cpu_fuzzer() {
+        delete cpu_i;
+    }
+};
+
+// Programs loaded at 0 from the text files in dir (not its subdirectories)
+static void load_seeds(const std::string& dir, size_t max_len, std::vector<std::vector<uint8_t> >& corpus) {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+        program_image image;
+        std::string error;
+        load_program_image(entry.path().string(), image, error);
+        if (image.segments.size() == 1 && image.segments[0].address == 0 && !image.segments[0].bytes.empty()) {
+            std::vector<uint8_t> bytes = image.segments[0].bytes;
+            bytes.resize(std::min(bytes.size(), max_len));
+            corpus.push_back(bytes);
+        }
+    }
+}
+
+int sc_main(int argc, char* argv[]) {
+    cpu::cpu_model_t model = cpu::SIGNAL_LEVEL;
+    std::string model_flag;
+    std::string seeds_dir = "../programs";
+    unsigned seed = 1;
+    uint64_t runs = 100000;
+    double seconds = 0;
+    unsigned budget = 2000;
+    size_t max_len = 64;
+    unsigned max_reports = 50;
+    std::string out_dir = "../programs/fuzz";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lt" || arg == "--bundled" || arg == "--fast") {
+            model = arg == "--lt" ? cpu::LOOSELY_TIMED : arg == "--fast" ? cpu::BLOCK_CACHED : cpu::BUNDLED_CONTROL;
+            model_flag = arg + " ";
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::stoull(argv[++i]);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::stod(argv[++i]);
+        } else if (arg == "--budget" && i + 1 < argc) {
+            budget = std::max(10, std::stoi(argv[++i]));
+        } else if (arg == "--max-len" && i + 1 < argc) {
+            max_len = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoul(argv[++i]);
+        } else if (arg == "--seeds" && i + 1 < argc) {
+            seeds_dir = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if (arg == "--max-reports" && i + 1 < argc) {
+            max_reports = std::stoi(argv[++i]);
+        } else {
+            std::cout << "ERROR: unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(out_dir, ec);
+    crash_path = (std::filesystem::path(out_dir) / "crash-last.txt").string();
+    if (crash_path.size() >= sizeof(crash_file)) {
+        std::cout << "ERROR: output directory name too long: " << out_dir << std::endl;
+        return 1;
+    }
+    std::strcpy(crash_file, crash_path.c_str());
+    std::signal(SIGSEGV, crash_handler);
+    std::signal(SIGABRT, crash_handler);
+    std::signal(SIGFPE, crash_handler);
+    std::signal(SIGILL, crash_handler);
+
+    cpu_fuzzer fuzzer("fuzzer", model, seed);
+    fuzzer.max_runs = runs;
+    fuzzer.max_seconds = seconds;
+    fuzzer.budget = budget;
+    fuzzer.max_len = max_len;
+    fuzzer.max_reports = max_reports;
+    fuzzer.out_dir = out_dir;
+    fuzzer.model_flag = model_flag;
+    load_seeds(seeds_dir, max_len, fuzzer.corpus);
+    fuzzer.corpus.push_back({ 0xA9, 0x01, 0x00 }); // LDA #1 / BRK
+    std::cout << "cpu_fuzz: " << fuzzer.corpus.size() << " seeds, budget " << budget << " cycles, seed " << seed
+              << std::endl;
+
+    try {
+        sc_start();
+    } catch (const std::exception& e) {
+        write_program(crash_path, { std::string("cpu_fuzz crash: ") + e.what() }, current_input);
+        std::cout << "[crash] " << crash_path << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <systemc.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cpu.h"
+#include "cpu_defs.h"
+
+// Temporal decoupling benchmark of the loosely-timed CPU models: wall time to
+// simulate a fixed number of clock cycles for several quantum sizes.
+//
+// usage: quantum_bench [--fast] [--lockstep] [-c cycles] [program.txt]
+//            sweeps the quanta below, one child process per quantum
+//        quantum_bench --quantum N [--fast] [-c cycles] [program.txt]
+//            a single run, prints one result line
+//
+// SystemC elaborates once per process, hence the child processes. The size of
+// one cpu instance (with its submodules) is printed first, build with
+// -DCPU_SC_WORDS=1 to compare native against sc_uint datapath words.
+// Without a program an endless counting loop is run that writes port 0
+// every 65536 iterations, so the I/O syncs are part of the measurement.
+// --lockstep checks every instruction against the golden reference
+// (lockstep.h), compare with a sweep without it for the overhead.
+
+static const int sweep[] = { 0, 100, 1000, 10000, 100000 };
+
+// inner: INC $0280 / BNE inner / INC $0281 / BNE inner /
+//        INC $0282 / LDA $0282 / STA $FF00 / JMP inner
+static const uint8_t loop_program[] = {
+    0xEE, 0x80, 0x02, 0xD0, 0xFB, 0xEE, 0x81, 0x02, 0xD0, 0xF6,
+    0xEE, 0x82, 0x02, 0xAD, 0x82, 0x02, 0x8D, 0x00, 0xFF, 0x4C, 0x00, 0x00
+};
+
+// Same text format as the cpu testbench: hex bytes, '#' starts a comment
+static bool load_program(const std::string& filename, std::vector<uint8_t>& bytes) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "ERROR: Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        std::string hex_byte;
+        while (iss >> hex_byte) {
+            if (hex_byte[0] == '#') break;
+            bytes.push_back((uint8_t)std::stoi(hex_byte, nullptr, 16));
+        }
+    }
+    return true;
+}
+
+SC_MODULE(quantum_bench) {
+    sc_signal<bool> clk;
+    sc_signal<bool> reset;
+    cpu* cpu_i;
+    std::vector<uint8_t> program;
+
+    void run() {
+        cpu_i->debug_write(0x0000, program.data(), (unsigned)program.size());
+        reset.write(true);
+        wait(20, SC_NS);
+        reset.write(false);
+    }
+
+    quantum_bench(sc_module_name name, cpu::cpu_model_t model, const std::vector<uint8_t>& program)
+        : sc_module(name), program(program) {
+        cpu_i = new cpu("cpu_i", model);
+        cpu_i->clk(clk);
+        cpu_i->reset(reset);
+        SC_THREAD(run);
+    }
+
+    SC_HAS_PROCESS(quantum_bench);
+
+    ~quantum_bench() {
+        delete cpu_i;
+    }
+};
+
+// Bytes of one cpu with its submodules, signals and state included
+static void print_footprint() {
+    size_t total = sizeof(cpu) + sizeof(memory) + sizeof(regfile) + sizeof(alu) + sizeof(control_unit);
+    std::cout << "cpu instance: " << total << " bytes (cpu " << sizeof(cpu) << ", memory " << sizeof(memory)
+              << ", regfile " << sizeof(regfile) << ", alu " << sizeof(alu) << ", control_unit "
+              << sizeof(control_unit) << "), datapath words " << (CPU_SC_WORDS ? "sc_uint" : "native")
+              << std::endl;
+}
+
+// Runs the whole sweep through child processes, prints the speedup table
+static int run_sweep(const std::string& self, const std::string& args) {
+    std::cout << std::left << std::setw(16) << "quantum" << std::right << std::setw(12) << "wall [s]"
+              << std::setw(12) << "MIPS" << std::setw(12) << "speedup" << std::endl;
+    double baseline = 0;
+    for (int quantum : sweep) {
+        std::string command = self + " --quantum " + std::to_string(quantum) + args;
+        FILE* child = popen(command.c_str(), "r");
+        if (!child) return 1;
+        // Last line of the child is "RESULT <instructions> <seconds>"
+        char line[256];
+        unsigned long long instructions = 0;
+        double seconds = 0;
+        while (fgets(line, sizeof(line), child)) {
+            sscanf(line, "RESULT %llu %lf", &instructions, &seconds);
+        }
+        pclose(child);
+        if (seconds <= 0) {
+            std::cout << "quantum " << quantum << ": no result" << std::endl;
+            continue;
+        }
+        if (quantum == 0) baseline = seconds;
+        std::string name = quantum == 0 ? "per instruction" : std::to_string(quantum) + " cycles";
+        std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << seconds << std::setw(12) << std::setprecision(2) << instructions / seconds / 1e6
+                  << std::setw(11) << std::setprecision(1) << (baseline > 0 ? baseline / seconds : 0) << "x"
+                  << std::endl;
+    }
+    return 0;
+}
+
+int sc_main(int argc, char* argv[]) {
+    cpu::cpu_model_t model = cpu::LOOSELY_TIMED;
+    long long cycles = 20000000;
+    int quantum = -1;
+    std::string program_file;
+    std::string args; // passed on to the children
+    bool lockstep = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quantum" && i + 1 < argc) {
+            quantum = std::stoi(argv[++i]);
+        } else if (arg == "--fast") {
+            model = cpu::BLOCK_CACHED;
+            args += " --fast";
+        } else if (arg == "--lockstep") {
+            lockstep = true;
+            args += " --lockstep";
+        } else if (arg == "-c" && i + 1 < argc) {
+            cycles = std::stoll(argv[++i]);
+            args += " -c " + std::to_string(cycles);
+        } else {
+            program_file = arg;
+            args += " " + arg;
+        }
+    }
+    if (quantum < 0) {
+        print_footprint();
+        return run_sweep(argv[0], args);
+    }
+
+    std::vector<uint8_t> program(loop_program, loop_program + sizeof(loop_program));
+    if (!program_file.empty()) {
+        program.clear();
+        if (!load_program(program_file, program)) return 1;
+    }
+
+    quantum_bench bench("bench", model, program);
+    lockstep_checker checker;
+    if (lockstep) {
+        bench.cpu_i->set_lockstep(&checker);
+    }
+    if (quantum > 0) {
+        bench.cpu_i->set_quantum(sc_time(CPU_CLOCK_PERIOD_NS * quantum, SC_NS));
+    }
+    auto start = std::chrono::steady_clock::now();
+    sc_start(sc_time(CPU_CLOCK_PERIOD_NS * (double)cycles, SC_NS));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (checker.failed()) {
+        return 1;
+    }
+    std::cout << "RESULT " << bench.cpu_i->lt_core.instructions << " " << elapsed.count() << std::endl;
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "trace_file.h"
+#include "opcode_table.h"
+
+// Offline decoder of the binary execution trace (include/trace_file.h) written
+// by cpu.exe --trace-file. Lists the records as text and/or summarizes them.
+//
+// usage: tracedump [--pc lo-hi] [--addr lo-hi] [--opcode xx] [--no-memory]
+//                  [--limit n] [--summary] trace.bin
+// Addresses and the opcode are hex. --pc and --opcode select instructions
+// and drop the memory records, --addr selects memory records by bus address.
+// --summary prints counts, the hottest opcodes, PCs and written addresses of
+// the selected records instead of listing them.
+
+struct trace_filter {
+    unsigned pc_lo = 0, pc_hi = 0xFFFF;
+    unsigned addr_lo = 0, addr_hi = 0xFFFF;
+    int opcode = -1;
+    bool instructions_only = false; // --pc, --opcode or --no-memory given
+
+    bool selects(const trace_record_t& r) const {
+        if (r.kind == TRACE_INSTRUCTION) {
+            return r.pc >= pc_lo && r.pc <= pc_hi && (opcode < 0 || r.opcode == opcode);
+        }
+        return !instructions_only && r.addr >= addr_lo && r.addr <= addr_hi;
+    }
+};
+
+static bool parse_range(const std::string& text, unsigned& lo, unsigned& hi) {
+    size_t dash = text.find('-');
+    try {
+        lo = std::stoul(text.substr(0, dash), nullptr, 16);
+        hi = dash == std::string::npos ? lo : std::stoul(text.substr(dash + 1), nullptr, 16);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return lo <= hi && hi <= 0xFFFF;
+}
+
+static bool parse_count(const std::string& text, uint64_t& value) {
+    size_t used = 0;
+    try {
+        value = std::stoull(text, &used);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return used == text.size() && text[0] != '-';
+}
+
+static void print_record(const trace_record_t& r) {
+    if (r.kind == TRACE_INSTRUCTION) {
+        const opcode_info_t& info = opcode_table[r.opcode];
+        char bytes[16];
+        if (info.length == 1)      std::snprintf(bytes, sizeof(bytes), "%02X      ", r.opcode);
+        else if (info.length == 2) std::snprintf(bytes, sizeof(bytes), "%02X %02X   ", r.opcode, r.operand[0]);
+        else                       std::snprintf(bytes, sizeof(bytes), "%02X %02X %02X", r.opcode, r.operand[0], r.operand[1]);
+        std::printf("%10llu  %04X  %s  %-3s  ea=%04X  A=%02X X=%02X Y=%02X S=%02X P=%02X\n",
+                    (unsigned long long)r.cycle, r.pc, bytes,
+                    opcode_mnemonic_name(r.opcode),
+                    r.addr, r.a, r.x, r.y, r.s, r.p);
+    } else {
+        std::printf("%10llu  %s [%04X] = %02X\n", (unsigned long long)r.cycle,
+                    r.kind == TRACE_WRITE ? "W" : "R", r.addr, r.operand[0]);
+    }
+}
+
+// The ten largest counts, label() prints the key
+template <typename Label>
+static void print_top(const char* title, const std::map<unsigned, uint64_t>& counts, Label label) {
+    std::vector<std::pair<uint64_t, unsigned>> sorted;
+    for (const auto& entry : counts) {
+        sorted.push_back({ entry.second, entry.first });
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& l, const auto& r) {
+        return l.first != r.first ? l.first > r.first : l.second < r.second;
+    });
+    std::printf("%s\n", title);
+    for (size_t i = 0; i < sorted.size() && i < 10; ++i) {
+        std::printf("  %-10s  %llu\n", label(sorted[i].second).c_str(), (unsigned long long)sorted[i].first);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    trace_filter filter;
+    bool summary = false;
+    uint64_t limit = UINT64_MAX;
+    std::string path;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool ok = true;
+        if (arg == "--pc" && i + 1 < argc) {
+            ok = parse_range(argv[++i], filter.pc_lo, filter.pc_hi);
+            filter.instructions_only = true;
+        } else if (arg == "--addr" && i + 1 < argc) {
+            ok = parse_range(argv[++i], filter.addr_lo, filter.addr_hi);
+        } else if (arg == "--opcode" && i + 1 < argc) {
+            unsigned lo, hi;
+            ok = parse_range(argv[++i], lo, hi) && lo == hi && lo <= 0xFF;
+            filter.opcode = (int)lo;
+            filter.instructions_only = true;
+        } else if (arg == "--no-memory") {
+            filter.instructions_only = true;
+        } else if (arg == "--limit" && i + 1 < argc) {
+            ok = parse_count(argv[++i], limit);
+        } else if (arg == "--summary") {
+            summary = true;
+        } else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cout << "usage: tracedump [--pc lo-hi] [--addr lo-hi] [--opcode xx] [--no-memory] "
+                         "[--limit n] [--summary] trace.bin" << std::endl;
+            return 1;
+        }
+    }
+
+    trace_file_reader reader;
+    if (path.empty() || !reader.open(path)) {
+        std::cout << "ERROR: Cannot open trace: " << path << std::endl;
+        return 1;
+    }
+
+    uint64_t total = 0, selected = 0, instructions = 0, reads = 0, writes = 0;
+    uint64_t first_cycle = 0, last_cycle = 0, first_retire = 0, last_retire = 0;
+    std::map<unsigned, uint64_t> opcode_counts, pc_counts, write_counts;
+    std::vector<trace_record_t> records(1 << 16);
+    size_t count;
+    while (selected < limit && (count = reader.read(records.data(), records.size())) > 0) {
+        total += count;
+        for (size_t i = 0; i < count && selected < limit; ++i) {
+            const trace_record_t& r = records[i];
+            if (!filter.selects(r)) continue;
+            if (selected++ == 0) first_cycle = r.cycle;
+            last_cycle = r.cycle;
+            if (!summary) {
+                print_record(r);
+                continue;
+            }
+            if (r.kind == TRACE_INSTRUCTION) {
+                if (instructions++ == 0) first_retire = r.cycle;
+                last_retire = r.cycle;
+                opcode_counts[r.opcode]++;
+                pc_counts[r.pc]++;
+            } else if (r.kind == TRACE_WRITE) {
+                writes++;
+                write_counts[r.addr]++;
+            } else {
+                reads++;
+            }
+        }
+    }
+
+    if (summary) {
+        std::printf("records        %llu read, %llu selected\n", (unsigned long long)total, (unsigned long long)selected);
+        std::printf("cycles         %llu-%llu\n", (unsigned long long)first_cycle, (unsigned long long)last_cycle);
+        std::printf("instructions   %llu", (unsigned long long)instructions);
+        if (instructions > 1) {
+            std::printf(" (%.2f cycles each)", (double)(last_retire - first_retire) / (instructions - 1));
+        }
+        std::printf("\nmemory         %llu reads, %llu writes\n", (unsigned long long)reads, (unsigned long long)writes);
+
+        auto address = [](unsigned addr) {
+            char text[8];
+            std::snprintf(text, sizeof(text), "%04X", addr);
+            return std::string(text);
+        };
+        print_top("top opcodes", opcode_counts, [](unsigned opcode) {
+            char text[16];
+            std::snprintf(text, sizeof(text), "%02X %s", opcode, opcode_mnemonic_name((uint8_t)opcode));
+            return std::string(text);
+        });
+        print_top("top PCs", pc_counts, address);
+        print_top("top written addresses", write_counts, address);
+    }
+    return 0;
+}